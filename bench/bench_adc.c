@@ -0,0 +1,92 @@
+// bench_adc.c – Mittelwert und Schwellenzählung über 4096 Messwerte:
+// ein adc_sample() je Wert in Bytecode gegen die Block-Natives
+// adc_block_avg/count_above, dazu ein FIR mit 16 Taps per fir_apply.
+// Quelle ist das synthetische Signal aus hal_stub.c (Periode 4096 Werte,
+// daher sehen beide Varianten dieselben Werte).
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/vm_simd.h"
+#include "../src/hal.h"
+
+#define N    4096
+#define THR  2500
+#define TAPS 16
+
+// locals[1] = Summe, locals[2] = Zähler, locals[3] = Wert
+static Code build_loop(void){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 0); op8(&c, OP_STOREL, 1);
+    op32(&c, OP_PUSHI, 0); op8(&c, OP_STOREL, 2);
+    Loop a = loop_begin(&c, 0, N);
+    op8(&c, OP_LOADL, 1); op32(&c, OP_PUSHI, 0); op8(&c, OP_CALL, NAT_ADC_SAMPLE);
+    op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+    loop_end(&c, a, 0);
+    op8(&c, OP_LOADL, 1); op32(&c, OP_PUSHI, N); op(&c, OP_DIV); op8(&c, OP_STOREL, 1);
+    Loop b = loop_begin(&c, 0, N);
+    op8(&c, OP_LOADL, 2);
+    op32(&c, OP_PUSHI, 0); op8(&c, OP_CALL, NAT_ADC_SAMPLE); op32(&c, OP_PUSHI, THR); op(&c, OP_GT);
+    op(&c, OP_ADD); op8(&c, OP_STOREL, 2);
+    loop_end(&c, b, 0);
+    op(&c, OP_HALT);
+    return c;
+}
+
+static Code build_native(void){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 0); op32(&c, OP_PUSHI, N); op8(&c, OP_CALL, NAT_ADC_BLOCK_AVG);
+    op8(&c, OP_STOREL, 1);
+    op32(&c, OP_PUSHI, 0); op32(&c, OP_PUSHI, N); op32(&c, OP_PUSHI, THR); op8(&c, OP_CALL, NAT_COUNT_ABOVE);
+    op8(&c, OP_STOREL, 2);
+    op(&c, OP_HALT);
+    return c;
+}
+
+// fir_apply(0, N, 0, TAPS, 2*TAPS) -> locals[1]
+static Code build_fir(void){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 0); op32(&c, OP_PUSHI, N); op32(&c, OP_PUSHI, 0);
+    op32(&c, OP_PUSHI, TAPS); op32(&c, OP_PUSHI, 2*TAPS); op8(&c, OP_CALL, NAT_FIR_APPLY);
+    op8(&c, OP_STOREL, 1);
+    op(&c, OP_HALT);
+    return c;
+}
+
+static Val stack[16], locals[4], mem[2*TAPS + N];
+static uint32_t calls[4];
+
+static double measure(const Code *c, int reps){
+    VM vm;
+    double t0 = now_s();
+    for (int r=0; r<reps; r++){
+        vm = (VM){ .code=c->data, .code_len=(uint32_t)c->len, .stack=stack, .stack_cap=16,
+                   .locals=locals, .locals_cap=4, .callstack=calls, .call_cap=4,
+                   .mem=mem, .mem_cap=2*TAPS + N, .hal=mote_bind_hal() };
+        if (vm_run(&vm) != VM_OK) fprintf(stderr, "TRAP\n");
+    }
+    return (now_s() - t0) / reps;
+}
+
+int main(int argc, char **argv){
+    int reps = argc > 1 ? atoi(argv[1]) : 500;
+    Code lo = build_loop(), na = build_native(), fi = build_fir();
+
+    double t_loop = measure(&lo, reps);
+    Val avg_l = locals[1], cnt_l = locals[2];
+    double t_nat = measure(&na, reps * 10);
+    Val avg_n = locals[1], cnt_n = locals[2];
+
+    for (int k=0; k<TAPS; k++) mem[k] = 32768 / TAPS;   // gleitender Mittelwert in Q15
+    double t_fir = measure(&fi, reps * 10);
+    int fir_ok = locals[1] == N;
+
+    int ok = avg_l == avg_n && cnt_l == cnt_n && fir_ok;
+    printf("2 x %d Werte (Mittelwert, Anzahl > %d), SIMD-Variante %s\n", N, THR, vsimd_ops()->name);
+    printf("  adc_sample je Wert (Bytecode)   : %9.2f us, %6.2f ns/Wert\n", t_loop*1e6, t_loop*1e9/(2*N));
+    printf("  adc_block_avg + count_above     : %9.2f us, %6.2f ns/Wert (%.0fx)\n",
+           t_nat*1e6, t_nat*1e9/(2*N), t_loop/t_nat);
+    printf("  fir_apply, %d Taps              : %9.2f us, %6.2f ns/Wert\n", TAPS, t_fir*1e6, t_fir*1e9/N);
+    printf("  Ergebnis %s (Mittelwert %d, %d über Schwelle)\n", ok ? "identisch" : "VERSCHIEDEN",
+           (int)avg_n, (int)cnt_n);
+    free(lo.data); free(na.data); free(fi.data);
+    return ok ? 0 : 1;
+}
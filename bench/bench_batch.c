@@ -0,0 +1,84 @@
+// bench_batch.c – N Instanzen desselben Programms: vm_run je Instanz gegen vm_batch_run
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/vm_batch.h"
+
+// LCG je Instanz, locals[1] = Zustand (Startwert je Lane verschieden), locals[2] = Zähler.
+// divergent: Verzweigung hängt vom Zustand ab (Lanes laufen auseinander),
+// sonst vom Schleifenzähler (alle Lanes nehmen denselben Zweig).
+static Code build(int divergent, int32_t iters){
+    Code c = {0};
+    Loop l = loop_begin(&c, 0, iters);
+    op8(&c, OP_LOADL, 1); op32(&c, OP_PUSHI, 1103515245); op(&c, OP_MUL);
+    op32(&c, OP_PUSHI, 12345); op(&c, OP_ADD); op(&c, OP_DUP); op8(&c, OP_STOREL, 1);
+    if (!divergent){ op(&c, OP_DROP); op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, iters/2); op(&c, OP_SUB); }
+    op32(&c, OP_PUSHI, 0); op(&c, OP_LT);
+    size_t to_else = op32(&c, OP_JZ, 0);
+    op8(&c, OP_LOADL, 2); op32(&c, OP_PUSHI, 1); op(&c, OP_ADD); op8(&c, OP_STOREL, 2);
+    size_t to_end = op32(&c, OP_JMP, 0);
+    patch32(&c, to_else, (int32_t)c.len);
+    op8(&c, OP_LOADL, 2); op32(&c, OP_PUSHI, 3); op(&c, OP_SUB); op8(&c, OP_STOREL, 2);
+    patch32(&c, to_end, (int32_t)c.len);
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    return c;
+}
+
+static Val seed(size_t lane){ return (Val)(lane*2654435761u + 1); }
+
+// Einzeln: eine VM je Instanz nacheinander; Ergebnis locals[2] je Lane
+static double run_single(const Code *c, size_t n, Val *out){
+    double t0 = now_s();
+    for (size_t i=0; i<n; i++){
+        Val stack[16] = {0}, locals[4] = {0, seed(i), 0, 0};
+        uint32_t calls[4];
+        VM vm = { .code=c->data, .code_len=(uint32_t)c->len, .stack=stack, .stack_cap=16,
+                  .locals=locals, .locals_cap=4, .callstack=calls, .call_cap=4 };
+        if (vm_run(&vm) != VM_OK) fprintf(stderr, "VM TRAP\n");
+        out[i] = locals[2];
+    }
+    return now_s() - t0;
+}
+
+static double run_batch(const Code *c, size_t n, Val *out, double *occupancy){
+    VmBatch B;
+    if (vm_batch_init(&B, c->data, c->len, n, 16, 4, 0) < 0){ fprintf(stderr, "kein Speicher\n"); exit(1); }
+    for (size_t i=0; i<n; i++) *vm_batch_local(&B, i, 1) = seed(i);
+    double t0 = now_s();
+    vm_batch_run(&B);
+    double t = now_s() - t0;
+    for (size_t i=0; i<n; i++){
+        if (vm_batch_result(&B, i) != VM_OK) fprintf(stderr, "Lane %zu TRAP\n", i);
+        out[i] = *vm_batch_local(&B, i, 2);
+    }
+    *occupancy = (double)B.lane_steps / ((double)B.steps * n);   // Anteil aktiver Lanes je Schritt
+    vm_batch_free(&B);
+    return t;
+}
+
+int main(int argc, char **argv){
+    int32_t iters = argc > 1 ? atoi(argv[1]) : 20000;
+    static const size_t lanes[] = { 8, 64, 256, 1024 };
+    int ok = 1;
+
+    printf("SIMD-Variante: %s, %d Iterationen je Instanz\n", vsimd_ops()->name, iters);
+    for (int d=0; d<2; d++){
+        Code c = build(d, iters);
+        printf("%s:\n", d ? "divergent (Zweig je Lane verschieden)" : "gleichförmig (alle Lanes gleicher Zweig)");
+        for (size_t k=0; k<sizeof(lanes)/sizeof(lanes[0]); k++){
+            size_t n = lanes[k];
+            Val *a = (Val*)malloc(n*sizeof(Val)), *b = (Val*)malloc(n*sizeof(Val));
+            double occ;
+            double ts = run_single(&c, n, a), tb = run_batch(&c, n, b, &occ);
+            int same = !memcmp(a, b, n*sizeof(Val));
+            ok &= same;
+            printf("  %5zu Instanzen: einzeln %8.2f ns/Iter, Batch %8.2f ns/Iter, Speedup %5.2fx, "
+                   "Auslastung %3.0f%%, %s\n",
+                   n, ts*1e9/((double)n*iters), tb*1e9/((double)n*iters), ts/tb, occ*100,
+                   same ? "identisch" : "VERSCHIEDEN");
+            free(a); free(b);
+        }
+        free(c.data);
+    }
+    return ok ? 0 : 1;
+}
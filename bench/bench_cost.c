@@ -0,0 +1,256 @@
+// bench_cost.c – Kostenmodell für mote-wcet kalibrieren: ns je Opcode und je
+// Native (Grundkosten plus je Element) mit vm_run und einer stummen HAL.
+// Jede Messung wiederholt eine Einheit mit ausgeglichenem Stack (z. B.
+// PUSHI; PUSHI; ADD; DROP) und zieht Schleifenrahmen sowie PUSHI/DROP ab;
+// PUSHI und DROP selbst teilen sich ihr gemeinsames Paar. Zur Kontrolle wird
+// eine gemischte Schleife mit dem Modell vorhergesagt und gemessen, ihr
+// Ergebnis mit einer C-Referenz verglichen.
+//
+//   bench_cost [kosten.txt]    schreibt das Modell (sonst nur Bericht)
+//   mote-wcet --costs kosten.txt programm.bin
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/hal.h"
+#include "../src/vm_ops.h"
+
+// Stumme HAL; adc_read liefert immer die volle Anzahl
+static void nh_gpio_mode(void*c,int pin,int mode){ (void)c; (void)pin; (void)mode; }
+static void nh_gpio_write(void*c,int pin,int val){ (void)c; (void)pin; (void)val; }
+static void nh_sleep_ms(void*c,int ms){ (void)c; (void)ms; }
+static int  nh_gpio_read(void*c,int pin){ (void)c; return pin & 1; }
+static void nh_print_int(void*c,int v){ (void)c; (void)v; }
+static void nh_gpio_mode_mask(void*c,int port,uint32_t mask,int mode){ (void)c; (void)port; (void)mask; (void)mode; }
+static void nh_gpio_write_mask(void*c,int port,uint32_t mask,uint32_t val){ (void)c; (void)port; (void)mask; (void)val; }
+static uint32_t nh_gpio_read_port(void*c,int port){ (void)c; return (uint32_t)port; }
+static int  nh_irq_attach(void*c,int pin,int edge){ (void)c; (void)pin; (void)edge; return -1; }
+static int  nh_event_poll(void*c,int*pin,int*edge){ (void)c; (void)pin; (void)edge; return 0; }
+static void nh_event_wait(void*c,int ms){ (void)c; (void)ms; }
+static int  nh_adc_read(void*c,int ch,Val*dst,int n){ (void)c; for (int i=0;i<n;i++) dst[i] = ch + (i & 255); return n; }
+
+static struct HAL null_hal = { nh_gpio_mode, nh_gpio_write, nh_sleep_ms, nh_gpio_read, nh_print_int,
+                               nh_gpio_mode_mask, nh_gpio_write_mask, nh_gpio_read_port,
+                               nh_irq_attach, nh_event_poll, nh_event_wait, nh_adc_read };
+
+#define MEM   16384
+#define REP   32          // Einheiten je Schleifendurchlauf
+#define FIR_TAPS 16
+
+typedef struct { Op op; int32_t arg; } Ins;
+enum { ARG_NEXT = 0x7fff0000, ARG_FN };      // Sprung auf die nächste Instruktion, Adresse der Hilfsfunktion
+
+static Val mem[MEM], locals[4];
+
+// Schleife mit iters Durchläufen à REP Einheiten; die Hilfsfunktion (nur RET) hinter HALT
+static Code build(const Ins *u, int nu, int32_t iters){
+    Code c = {0};
+    size_t fix[REP*8]; int nfix = 0;
+    Loop l = loop_begin(&c, 0, iters);
+    for (int r=0; r<REP; r++)
+        for (int k=0; k<nu; k++){
+            if (vm_op_operand_len(u[k].op) == 1) op8(&c, u[k].op, (uint8_t)u[k].arg);
+            else if (vm_op_operand_len(u[k].op) == 4){
+                size_t at = op32(&c, u[k].op, u[k].arg);
+                if (u[k].arg == ARG_NEXT) patch32(&c, at, (int32_t)c.len);
+                if (u[k].arg == ARG_FN) fix[nfix++] = at;
+            } else op(&c, u[k].op);
+        }
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    for (int k=0; k<nfix; k++) patch32(&c, fix[k], (int32_t)c.len);
+    op(&c, OP_RET);
+    return c;
+}
+
+static double run_once(const Code *c){
+    Val stack[32] = {0};
+    uint32_t calls[8];
+    VM vm = { .code=c->data, .code_len=(uint32_t)c->len, .stack=stack, .stack_cap=32,
+              .locals=locals, .locals_cap=4, .callstack=calls, .call_cap=8,
+              .mem=mem, .mem_cap=MEM, .hal=&null_hal };
+    double t0 = now_s();
+    VmRes r = vm_run(&vm);
+    double t = now_s() - t0;
+    if (r != VM_OK || vm.sp){ fprintf(stderr, "VM TRAP oder Stack nicht leer\n"); exit(1); }
+    return t;
+}
+
+// Bestzeit von 5 Läufen, Durchläufe so gewählt, dass ein Lauf mindestens 5 ms dauert
+static double best(const Ins *u, int nu, int32_t *iters){
+    int32_t n = 256;
+    for (;;){
+        Code c = build(u, nu, n);
+        double t = run_once(&c);
+        free(c.data);
+        if (t > 0.005 || n >= (1<<26)) break;
+        n *= 4;
+    }
+    Code c = build(u, nu, n);
+    double t = 1e30;
+    for (int r=0; r<5; r++){ double x = run_once(&c); if (x < t) t = x; }
+    free(c.data);
+    *iters = n;
+    return t;
+}
+
+static double frame_ns;     // Schleifenrahmen je Durchlauf
+static double push_ns;      // PUSHI bzw. DROP, je Hälfte des Paars
+
+// ns je Einheit ohne Rahmen
+static double unit_ns(const Ins *u, int nu){
+    int32_t n;
+    double t = best(u, nu, &n);
+    return (t*1e9/n - frame_ns) / REP;
+}
+
+// Einheit minus enthaltene PUSHI/DROP außer der gemessenen Instruktion at
+static double op_ns(const Ins *u, int nu, int at){
+    double t = unit_ns(u, nu);
+    for (int k=0; k<nu; k++) if (k != at && (u[k].op == OP_PUSHI || u[k].op == OP_DROP)) t -= push_ns;
+    return t;
+}
+
+typedef struct { double op[OP_COUNT]; double nat[NAT_COUNT], elem[NAT_COUNT]; uint8_t nat_ok[NAT_COUNT]; } Model;
+
+#define U(...) (const Ins[]){ __VA_ARGS__ }, sizeof((const Ins[]){ __VA_ARGS__ })/sizeof(Ins)
+
+static void measure_ops(Model *M){
+    #define BIN(o, b) M->op[o] = op_ns(U({OP_PUSHI,1000},{OP_PUSHI,b},{o,0},{OP_DROP,0}), 2)
+    BIN(OP_ADD,7); BIN(OP_SUB,7); BIN(OP_MUL,7); BIN(OP_DIV,7); BIN(OP_MOD,7);
+    BIN(OP_LT,7); BIN(OP_EQ,7); BIN(OP_GT,7); BIN(OP_GE,7); BIN(OP_LE,7); BIN(OP_NE,7);
+    BIN(OP_AND,7); BIN(OP_OR,7); BIN(OP_SHL,3); BIN(OP_SHR,3); BIN(OP_BAND,7); BIN(OP_BOR,7); BIN(OP_BXOR,7);
+    BIN(OP_FMUL,70000); BIN(OP_FDIV,70000);
+    #undef BIN
+    M->op[OP_NOT]    = op_ns(U({OP_PUSHI,3},{OP_NOT,0},{OP_DROP,0}), 1);
+    M->op[OP_LOADM]  = op_ns(U({OP_PUSHI,5},{OP_LOADM,0},{OP_DROP,0}), 1);
+    M->op[OP_STOREM] = op_ns(U({OP_PUSHI,5},{OP_PUSHI,9},{OP_STOREM,0}), 2);
+    M->op[OP_LOADL]  = op_ns(U({OP_LOADL,1},{OP_DROP,0}), 0);
+    M->op[OP_STOREL] = op_ns(U({OP_PUSHI,9},{OP_STOREL,1}), 1);
+    M->op[OP_DUP]    = op_ns(U({OP_PUSHI,3},{OP_DUP,0},{OP_DROP,0},{OP_DROP,0}), 1);
+    M->op[OP_SWAP]   = op_ns(U({OP_PUSHI,3},{OP_PUSHI,4},{OP_SWAP,0},{OP_DROP,0},{OP_DROP,0}), 2);
+    M->op[OP_OVER]   = op_ns(U({OP_PUSHI,3},{OP_PUSHI,4},{OP_OVER,0},{OP_DROP,0},{OP_DROP,0},{OP_DROP,0}), 2);
+    M->op[OP_ADD64]  = op_ns(U({OP_PUSHI,-1},{OP_PUSHI,1},{OP_PUSHI,1},{OP_PUSHI,0},{OP_ADD64,0},{OP_DROP,0},{OP_DROP,0}), 4);
+    M->op[OP_MUL64]  = op_ns(U({OP_PUSHI,-1},{OP_PUSHI,1},{OP_PUSHI,3},{OP_PUSHI,0},{OP_MUL64,0},{OP_DROP,0},{OP_DROP,0}), 4);
+    M->op[OP_JMP]    = op_ns(U({OP_JMP,ARG_NEXT}), 0);
+    M->op[OP_JZ]     = op_ns(U({OP_PUSHI,1},{OP_JZ,ARG_NEXT}), 1);
+    // Aufruf und Rücksprung nur als Paar messbar
+    M->op[OP_CALLUSER] = M->op[OP_RET] = op_ns(U({OP_CALLUSER,ARG_FN}), 0) / 2;
+    M->op[OP_HALT]   = M->op[OP_JMP];     // einmal je Lauf, wie ein Sprung angesetzt
+    M->op[OP_CALL]   = 0;                 // steckt in den Grundkosten der Natives
+}
+
+// Native mit festen Argumenten: Grundkosten ohne Argumente und DROP
+static void nat_fixed(Model *M, int k, int nargs){
+    Ins u[8]; int nu = 0;
+    for (int a=0; a<nargs; a++) u[nu++] = (Ins){ OP_PUSHI, a+1 };
+    u[nu++] = (Ins){ OP_CALL, k }; u[nu++] = (Ins){ OP_DROP, 0 };
+    M->nat[k] = op_ns(u, nu, nargs); M->nat_ok[k] = 1;
+}
+
+// Block-Native: Argumente aus args, an Position n_at die Länge; zwei Längen,
+// Differenz ergibt die Kosten je Element
+static void nat_block(Model *M, int k, const int32_t *args, int nargs, int n_at, int per_n){
+    static const int32_t len[2] = { 64, 4096 };
+    double t[2];
+    for (int j=0; j<2; j++){
+        Ins u[8]; int nu = 0;
+        for (int a=0; a<nargs; a++) u[nu++] = (Ins){ OP_PUSHI, a == n_at ? len[j] : args[a] };
+        u[nu++] = (Ins){ OP_CALL, k }; u[nu++] = (Ins){ OP_DROP, 0 };
+        t[j] = op_ns(u, nu, nargs);
+    }
+    M->elem[k] = (t[1]-t[0]) / ((double)(len[1]-len[0]) * per_n);
+    M->nat[k]  = t[0] - M->elem[k] * len[0] * per_n;
+    if (M->nat[k] < 0) M->nat[k] = 0;
+    M->nat_ok[k] = 1;
+}
+
+static void measure_natives(Model *M){
+    nat_fixed(M, NAT_GPIO_MODE, 2);      nat_fixed(M, NAT_GPIO_WRITE, 2);
+    nat_fixed(M, NAT_SLEEP_MS, 1);       nat_fixed(M, NAT_GPIO_READ, 1);
+    nat_fixed(M, NAT_PRINT_INT, 1);      nat_fixed(M, NAT_GPIO_MODE_MASK, 3);
+    nat_fixed(M, NAT_GPIO_WRITE_MASK, 3); nat_fixed(M, NAT_GPIO_READ_PORT, 1);
+    nat_fixed(M, NAT_ADC_SAMPLE, 1);
+    nat_block(M, NAT_MEM_FILL,      (const int32_t[]){ 0, 0, 7 }, 3, 1, 1);
+    nat_block(M, NAT_MEM_COPY,      (const int32_t[]){ 0, 8192, 0 }, 3, 2, 1);
+    nat_block(M, NAT_MEM_SUM,       (const int32_t[]){ 0, 0 }, 2, 1, 1);
+    nat_block(M, NAT_MEM_MAX,       (const int32_t[]){ 0, 0 }, 2, 1, 1);
+    nat_block(M, NAT_ADC_READ,      (const int32_t[]){ 1, 0, 0 }, 3, 2, 1);
+    nat_block(M, NAT_ADC_BLOCK_AVG, (const int32_t[]){ 1, 0 }, 2, 1, 1);
+    nat_block(M, NAT_COUNT_ABOVE,   (const int32_t[]){ 1, 0, 100 }, 3, 1, 1);
+    nat_block(M, NAT_FIR_APPLY,     (const int32_t[]){ 1, 0, 12000, FIR_TAPS, 0 }, 5, 1, FIR_TAPS);
+}
+
+// Kontrolle: s = s + ((i*3) ^ i) % 7 + mem_sum(0, 64); je Durchlauf i = i + 1
+static const Ins mix[] = {
+    {OP_LOADL,1}, {OP_LOADL,2}, {OP_PUSHI,3}, {OP_MUL,0}, {OP_LOADL,2}, {OP_BXOR,0},
+    {OP_PUSHI,7}, {OP_MOD,0}, {OP_ADD,0}, {OP_PUSHI,0}, {OP_PUSHI,64}, {OP_CALL,NAT_MEM_SUM},
+    {OP_ADD,0}, {OP_STOREL,1}, {OP_LOADL,2}, {OP_PUSHI,1}, {OP_ADD,0}, {OP_STOREL,2},
+};
+#define NMIX (int)(sizeof mix / sizeof mix[0])
+
+static double predict(const Model *M, int32_t iters){
+    static const Op frame[] = { OP_LOADL, OP_JZ, OP_LOADL, OP_PUSHI, OP_SUB, OP_STOREL, OP_JMP };
+    double per = 0;
+    for (int k=0; k<7; k++) per += M->op[frame[k]];
+    for (int r=0; r<REP; r++)
+        for (int k=0; k<NMIX; k++){
+            per += M->op[mix[k].op];
+            if (mix[k].op == OP_CALL) per += M->nat[mix[k].arg] + M->elem[mix[k].arg] * 64;
+        }
+    // PUSHI n; STOREL 0 vorweg, LOADL; JZ beim Verlassen, HALT
+    return iters*per + M->op[OP_PUSHI] + M->op[OP_STOREL] + M->op[OP_LOADL] + M->op[OP_JZ] + M->op[OP_HALT];
+}
+
+int main(int argc, char **argv){
+    const char *out = argc > 1 ? argv[1] : NULL;
+    for (int i=0; i<MEM; i++) mem[i] = (i*7) % 101;
+
+    int32_t n;
+    Code c = build(NULL, 0, 1 << 20);
+    double t = 1e30;
+    for (int r=0; r<5; r++){ double x = run_once(&c); if (x < t) t = x; }
+    free(c.data);
+    frame_ns = t*1e9 / (1 << 20);
+    push_ns = unit_ns(U({OP_PUSHI,1},{OP_DROP,0})) / 2;
+
+    Model M; memset(&M, 0, sizeof M);
+    M.op[OP_PUSHI] = M.op[OP_DROP] = push_ns;
+    measure_ops(&M);
+    measure_natives(&M);
+
+    printf("Kostenmodell (vm_run, stumme HAL), Schleifenrahmen %.2f ns\n", frame_ns);
+    for (int k=0; k<OP_COUNT; k++) printf("  %-9s %7.2f ns%s", vm_op_names[k], M.op[k], k%4 == 3 ? "\n" : "");
+    printf("\n");
+    for (int k=0; k<NAT_COUNT; k++)
+        if (M.nat_ok[k]) printf("  %-14s %7.2f ns + %6.3f ns je Element\n", vm_native_names[k], M.nat[k], M.elem[k]);
+
+    // Kontrolle gegen die Messung und gegen C
+    double tm = best(mix, NMIX, &n);
+    Code mc = build(mix, NMIX, n);
+    locals[1] = locals[2] = 0;
+    run_once(&mc);
+    free(mc.data);
+    uint32_t s = 0, sum64 = 0;
+    for (int i=0; i<64; i++) sum64 += (uint32_t)mem[i];
+    for (uint32_t i=0; i<(uint32_t)n*REP; i++) s += ((i*3) ^ i) % 7 + sum64;
+    double tp = predict(&M, n) * 1e-9;
+    printf("Kontrolle (%d Durchläufe): vorhergesagt %.2f ms, gemessen %.2f ms (%+.1f%%)\n",
+           n, tp*1e3, tm*1e3, (tp/tm - 1)*100);
+    int ok = (uint32_t)locals[1] == s && locals[2] == (Val)((uint32_t)n*REP);
+    printf("  Ergebnis %s\n", ok ? "identisch" : "VERSCHIEDEN");
+
+    if (out){
+        FILE *f = fopen(out, "w");
+        if (!f){ perror(out); return 1; }
+        fprintf(f, "# Kostenmodell aus bench_cost (vm_run, stumme HAL): ns je Opcode,\n"
+                   "# Natives mit Grundkosten und Kosten je Element. Zeit in der echten HAL\n"
+                   "# (Pins, Wandler, sleep_ms) kommt auf dem Zielsystem hinzu.\n"
+                   "unit ns\n");
+        for (int k=0; k<OP_COUNT; k++) fprintf(f, "%-9s %.3f\n", vm_op_names[k], M.op[k]);
+        for (int k=0; k<NAT_COUNT; k++)
+            if (M.nat_ok[k]) fprintf(f, "native %-14s %.3f %.4f\n", vm_native_names[k], M.nat[k], M.elem[k]);
+        fprintf(f, "# gpio_on_edge, wait_event, yield: nicht gemessen (hängen am Host)\n");
+        fclose(f);
+        printf("Modell nach %s geschrieben\n", out);
+    }
+    return ok ? 0 : 1;
+}
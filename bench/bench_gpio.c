@@ -0,0 +1,88 @@
+// bench_gpio.c – 8-Bit-LED-Leiste: 8 x gpio_write gegen 1 x gpio_write_mask
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/hal.h"
+
+// Zählende HAL ohne Ausgabe
+typedef struct {
+    struct HAL hal;
+    uint32_t port[8];
+    long calls;
+} BenchHal;
+
+static void b_gpio_mode(void*c,int pin,int mode){ (void)pin; (void)mode; ((BenchHal*)c)->calls++; }
+static void b_gpio_write(void*c,int pin,int val){
+    BenchHal *H = (BenchHal*)c; H->calls++;
+    uint32_t bit = 1u << (pin&31);
+    H->port[(pin>>5)&7] = val ? H->port[(pin>>5)&7]|bit : H->port[(pin>>5)&7]&~bit;
+}
+static void b_sleep_ms(void*c,int ms){ (void)c; (void)ms; }
+static int  b_gpio_read(void*c,int pin){ (void)pin; ((BenchHal*)c)->calls++; return 0; }
+static void b_print_int(void*c,int v){ (void)c; (void)v; }
+static void b_gpio_mode_mask(void*c,int port,uint32_t mask,int mode){ (void)port; (void)mask; (void)mode; ((BenchHal*)c)->calls++; }
+static void b_gpio_write_mask(void*c,int port,uint32_t mask,uint32_t val){
+    BenchHal *H = (BenchHal*)c; H->calls++;
+    H->port[port&7] = (H->port[port&7] & ~mask) | (val & mask);
+}
+static uint32_t b_gpio_read_port(void*c,int port){ BenchHal *H=(BenchHal*)c; H->calls++; return H->port[port&7]; }
+
+// Lauflicht: in Iteration i leuchtet LED (i mod 8); locals[1] = aktuelles Muster
+static Code build(int batched, int32_t iters){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 1); op8(&c, OP_STOREL, 1);
+    Loop l = loop_begin(&c, 0, iters);
+    if (batched){
+        op32(&c, OP_PUSHI, 0);              // port
+        op32(&c, OP_PUSHI, 0xFF);           // mask
+        op8(&c, OP_LOADL, 1);               // value
+        op8(&c, OP_CALL, NAT_GPIO_WRITE_MASK); op(&c, OP_DROP);
+    } else {
+        for (int b=0; b<8; b++){
+            // gpio_write(val, pin): val = (muster / 2^b) mod 2 über AND/NE gebildet
+            op8(&c, OP_LOADL, 1); op32(&c, OP_PUSHI, 1<<b); op(&c, OP_EQ);
+            op32(&c, OP_PUSHI, b);
+            op8(&c, OP_CALL, NAT_GPIO_WRITE); op(&c, OP_DROP);
+        }
+    }
+    // muster = muster*2, bei 256 wieder 1
+    op8(&c, OP_LOADL, 1); op32(&c, OP_PUSHI, 2); op(&c, OP_MUL); op(&c, OP_DUP);
+    op32(&c, OP_PUSHI, 256); op(&c, OP_EQ);
+    size_t fix = op32(&c, OP_JZ, 0);
+    op(&c, OP_DROP); op32(&c, OP_PUSHI, 1);
+    patch32(&c, fix, (int32_t)c.len);
+    op8(&c, OP_STOREL, 1);
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    return c;
+}
+
+static double run(const Code *c, BenchHal *H){
+    Val stack[64] = {0}, locals[4] = {0};
+    uint32_t calls[4];
+    VM vm = { .code=c->data, .code_len=(uint32_t)c->len, .stack=stack, .stack_cap=64,
+              .locals=locals, .locals_cap=4, .callstack=calls, .call_cap=4, .hal=H };
+    double t0 = now_s();
+    VmRes r = vm_run(&vm);
+    double t = now_s() - t0;
+    if (r != VM_OK) fprintf(stderr, "VM TRAP\n");
+    return t;
+}
+
+int main(int argc, char **argv){
+    int32_t iters = argc > 1 ? atoi(argv[1]) : 2000000;
+    BenchHal H = { { b_gpio_mode, b_gpio_write, b_sleep_ms, b_gpio_read, b_print_int,
+                     b_gpio_mode_mask, b_gpio_write_mask, b_gpio_read_port,
+                     NULL, NULL, NULL, NULL }, {0}, 0 };
+
+    Code pin = build(0, iters), port = build(1, iters);
+    H.calls = 0; double tp = run(&pin, &H);  long cp = H.calls; uint32_t sp = H.port[0];
+    H.calls = 0; memset(H.port, 0, sizeof(H.port));
+    double tb = run(&port, &H); long cb = H.calls; uint32_t sb = H.port[0];
+
+    printf("Updates: %d (8 LEDs je Update)\n", iters);
+    printf("  je Pin  gpio_write      : %8.1f ns/Update, %ld HAL-Aufrufe\n", tp*1e9/iters, cp);
+    printf("  Port    gpio_write_mask : %8.1f ns/Update, %ld HAL-Aufrufe\n", tb*1e9/iters, cb);
+    printf("  Speedup %.2fx, Endzustand %s\n", tp/tb, sp==sb ? "identisch" : "VERSCHIEDEN");
+    free(pin.data); free(port.data);
+    return sp==sb ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// bench_hal.c – HAL-lastige Schleifen: derselbe Interpreter einmal über die
+// Vtable (vm_run aus vm.c) und einmal per vm_interp.h fest an diese HAL
+// gebunden (vm_run_bound), sodass die Natives in die Dispatch-Schleife wandern.
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/hal.h"
+#include "../src/vm_ops.h"
+#include "../src/vm_simd.h"
+
+// Zählende HAL ohne Ausgabe; Eingänge wechseln alle 8 Lesezugriffe
+typedef struct {
+    struct HAL hal;
+    uint32_t port[8];
+    long calls;
+} BenchHal;
+
+#define BH(c) ((BenchHal*)(c))
+
+static inline void bh_gpio_mode(void*c,int pin,int mode){ (void)pin; (void)mode; BH(c)->calls++; }
+static inline void bh_gpio_write(void*c,int pin,int val){
+    BenchHal *H = BH(c); H->calls++;
+    uint32_t bit = 1u << (pin&31);
+    H->port[(pin>>5)&7] = val ? H->port[(pin>>5)&7]|bit : H->port[(pin>>5)&7]&~bit;
+}
+static inline void bh_sleep_ms(void*c,int ms){ (void)c; (void)ms; }
+static inline int  bh_gpio_read(void*c,int pin){ (void)pin; return (int)(++BH(c)->calls >> 3) & 1; }
+static inline void bh_print_int(void*c,int v){ (void)c; (void)v; }
+static inline void bh_gpio_mode_mask(void*c,int port,uint32_t mask,int mode){ (void)port; (void)mask; (void)mode; BH(c)->calls++; }
+static inline void bh_gpio_write_mask(void*c,int port,uint32_t mask,uint32_t val){
+    BenchHal *H = BH(c); H->calls++;
+    H->port[port&7] = (H->port[port&7] & ~mask) | (val & mask);
+}
+static inline uint32_t bh_gpio_read_port(void*c,int port){ BenchHal *H = BH(c); H->calls++; return H->port[port&7]; }
+static inline int  bh_irq_attach(void*c,int pin,int edge){ (void)c; (void)pin; (void)edge; return -1; }
+static inline int  bh_event_poll(void*c,int*pin,int*edge){ (void)c; (void)pin; (void)edge; return 0; }
+static inline void bh_event_wait(void*c,int ms){ (void)c; (void)ms; }
+static inline int  bh_adc_read(void*c,int ch,Val*dst,int n){ (void)c; (void)ch; (void)dst; (void)n; return 0; }
+
+#define VM_INTERP_NAME vm_run_bound
+#define VM_HAL_CALL(f, ...) bh_##f(vm->hal, __VA_ARGS__)
+#include "../src/vm_interp.h"
+
+// 0: gpio_write(i&7, i&1)   1: s += gpio_read(3)   2: write_mask(0, 0xFF, read_port(0)+1)
+// locals[1] = Prüfsumme
+static Code build(int kind, int32_t iters){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 0); op8(&c, OP_STOREL, 1);
+    Loop l = loop_begin(&c, 0, iters);
+    switch (kind){
+    case 0:
+        op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, 1); op(&c, OP_BAND);       // val
+        op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, 7); op(&c, OP_BAND);       // pin
+        op8(&c, OP_CALL, NAT_GPIO_WRITE); op(&c, OP_DROP);
+        break;
+    case 1:
+        op8(&c, OP_LOADL, 1); op32(&c, OP_PUSHI, 3); op8(&c, OP_CALL, NAT_GPIO_READ);
+        op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+        break;
+    default:
+        op32(&c, OP_PUSHI, 0); op32(&c, OP_PUSHI, 0xFF);
+        op32(&c, OP_PUSHI, 0); op8(&c, OP_CALL, NAT_GPIO_READ_PORT); op32(&c, OP_PUSHI, 1); op(&c, OP_ADD);
+        op8(&c, OP_CALL, NAT_GPIO_WRITE_MASK); op(&c, OP_DROP);
+        break;
+    }
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    return c;
+}
+
+typedef struct { double t; Val sum; uint32_t port; long calls; } Res;
+
+static Res run(const Code *c, int bound){
+    Val stack[16] = {0}, locals[4] = {0};
+    uint32_t calls[4];
+    BenchHal H = { { bh_gpio_mode, bh_gpio_write, bh_sleep_ms, bh_gpio_read, bh_print_int,
+                     bh_gpio_mode_mask, bh_gpio_write_mask, bh_gpio_read_port,
+                     bh_irq_attach, bh_event_poll, bh_event_wait, bh_adc_read }, {0}, 0 };
+    VM vm = { .code=c->data, .code_len=(uint32_t)c->len, .stack=stack, .stack_cap=16,
+              .locals=locals, .locals_cap=4, .callstack=calls, .call_cap=4, .hal=&H };
+    double t0 = now_s();
+    VmRes r = bound ? vm_run_bound(&vm) : vm_run(&vm);
+    Res x = { now_s() - t0, locals[1], H.port[0], H.calls };
+    if (r != VM_OK) fprintf(stderr, "VM TRAP\n");
+    return x;
+}
+
+int main(int argc, char **argv){
+    int32_t iters = argc > 1 ? atoi(argv[1]) : 2000000;
+    static const char *name[3] = { "gpio_write je Pin     ", "gpio_read-Polling     ", "read_port+write_mask  " };
+    int ok = 1;
+    printf("HAL-Bindung, %d Iterationen je Schleife\n", iters);
+    for (int k=0; k<3; k++){
+        Code c = build(k, iters);
+        Res v = run(&c, 0), s = run(&c, 1);
+        for (int r=1; r<5; r++){                      // abwechselnd, jeweils Bestzeit
+            Res a = run(&c, 0), b = run(&c, 1);
+            if (a.t < v.t) v = a;
+            if (b.t < s.t) s = b;
+        }
+        int same = v.sum == s.sum && v.port == s.port && v.calls == s.calls;
+        ok &= same;
+        printf("  %s: Vtable %6.2f ns, statisch %6.2f ns je Iteration (%.2fx)%s\n",
+               name[k], v.t*1e9/iters, s.t*1e9/iters, v.t/s.t, same ? "" : "  VERSCHIEDEN");
+        free(c.data);
+    }
+    printf("  Ergebnis %s\n", ok ? "identisch" : "VERSCHIEDEN");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// bench_mem.c – Speicher je Instanz: bisheriges Layout gegen Slab-Pool mit analysiertem Bedarf
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/vm_pool.h"
+
+// Bisheriges Layout: VM mit eingebettetem size_t callstack[256], dazu Stack
+// und Locals mit je 256 Einträgen wie in main_host.c
+typedef struct {
+    const uint8_t *code; size_t code_len, ip;
+    Val *stack; size_t sp, stack_cap;
+    Val *locals; size_t locals_cap;
+    void *hal;
+    size_t callstack[256]; size_t csp;
+    struct { int16_t pin; uint8_t edge; uint32_t addr; } irq[VM_MAX_IRQ];
+    uint8_t nirq, in_irq;
+} LegacyVM;
+#define LEGACY_BYTES (sizeof(LegacyVM) + 2*256*sizeof(Val))
+
+// Gleicher Rechenaufwand mit dem alten Platzbedarf: eine Allokation je Instanz
+typedef struct { VM vm; uint32_t calls[256]; Val stack[256], locals[256]; } Fat;
+
+// locals[1] = Zustand; je Iteration ein Funktionsaufruf f(x) = x*1103515245 + 12345
+static Code build(int32_t iters){
+    Code c = {0};
+    Loop l = loop_begin(&c, 0, iters);
+    op8(&c, OP_LOADL, 1);
+    size_t call = op32(&c, OP_CALLUSER, 0);
+    op8(&c, OP_STOREL, 1);
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    patch32(&c, call, (int32_t)c.len);
+    op8(&c, OP_STOREL, 2); op8(&c, OP_LOADL, 2);
+    op32(&c, OP_PUSHI, 1103515245); op(&c, OP_MUL); op32(&c, OP_PUSHI, 12345); op(&c, OP_ADD);
+    op(&c, OP_RET);
+    return c;
+}
+
+int main(int argc, char **argv){
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+    int32_t iters = argc > 2 ? atoi(argv[2]) : 20;
+    Code c = build(iters);
+
+    VmNeeds need;
+    if (vm_analyze(c.data, c.len, &need) != 0) fprintf(stderr, "Analyse fehlgeschlagen\n");
+    printf("Bedarf: Stack %u, Call-Stack %u, Locals %u, Interrupts %s\n",
+           need.stack_max, need.call_max, need.locals_max, need.irq ? "ja" : "nein");
+
+    // ---- Pool ----
+    VmPool P;
+    vm_pool_init(&P, c.data, c.len, &need);
+    VM **vms = (VM**)malloc(n*sizeof(VM*));
+    for (size_t i=0;i<n;i++){ vms[i] = vm_pool_alloc(&P, NULL); vms[i]->locals[1] = (Val)i; }
+    double t0 = now_s();
+    Val sum_p = 0;
+    for (size_t i=0;i<n;i++){
+        if (vm_run(vms[i]) != VM_OK) fprintf(stderr, "TRAP\n");
+        sum_p += vms[i]->locals[1];
+    }
+    double tp = now_s() - t0;
+
+    // ---- bisheriger Platzbedarf ----
+    Fat **fat = (Fat**)malloc(n*sizeof(Fat*));
+    for (size_t i=0;i<n;i++){
+        Fat *f = fat[i] = (Fat*)calloc(1, sizeof(Fat));
+        f->vm = (VM){ .code=c.data, .code_len=(uint32_t)c.len, .stack=f->stack, .stack_cap=256,
+                      .locals=f->locals, .locals_cap=256, .callstack=f->calls, .call_cap=256 };
+        f->locals[1] = (Val)i;
+    }
+    t0 = now_s();
+    Val sum_f = 0;
+    for (size_t i=0;i<n;i++){
+        if (vm_run(&fat[i]->vm) != VM_OK) fprintf(stderr, "TRAP\n");
+        sum_f += fat[i]->locals[1];
+    }
+    double tf = now_s() - t0;
+
+    double per_pool = (double)P.bytes / n;
+    printf("%zu Instanzen, %d Aufrufe je Instanz\n", n, iters);
+    printf("  bisher (VM mit callstack[256], Stack/Locals 256): %7zu B/Instanz, %9.0f Instanzen/GB\n",
+           (size_t)LEGACY_BYTES, 1e9 / LEGACY_BYTES);
+    printf("  Pool (Block %zu B, VM-Kopf %zu B)               : %7.1f B/Instanz, %9.0f Instanzen/GB\n",
+           P.block, sizeof(VM), per_pool, 1e9 / per_pool);
+    printf("  Durchlauf aller Instanzen: Pool %.2f ms, 256er-Layout %.2f ms (%.2fx), Ergebnis %s\n",
+           tp*1e3, tf*1e3, tf/tp, sum_p == sum_f ? "identisch" : "VERSCHIEDEN");
+
+    for (size_t i=0;i<n;i++){ vm_pool_release(&P, vms[i]); free(fat[i]); }
+    vm_pool_destroy(&P);
+    free(vms); free(fat); free(c.data);
+    return sum_p == sum_f ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+// bench_memsum.c – Summe über 4096 Messwerte im linearen Speicher:
+// Bytecode-Schleife mit LOADM gegen den Block-Native mem_sum
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/vm_simd.h"
+
+#define N 4096
+
+// locals[0] zählt herunter, locals[1] = Summe; Element i-1 je Durchlauf
+static Code build_loop(void){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 0); op8(&c, OP_STOREL, 1);
+    Loop l = loop_begin(&c, 0, N);
+    op8(&c, OP_LOADL, 1);
+    op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, 1); op(&c, OP_SUB); op(&c, OP_LOADM);
+    op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    return c;
+}
+
+static Code build_native(void){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 0); op32(&c, OP_PUSHI, N); op8(&c, OP_CALL, NAT_MEM_SUM);
+    op8(&c, OP_STOREL, 1);
+    op(&c, OP_HALT);
+    return c;
+}
+
+static Val stack[16], locals[4], mem[N];
+static uint32_t calls[4];
+
+// Mittlere Zeit je Lauf in Sekunden, Ergebnis in *sum
+static double measure(const Code *c, int reps, Val *sum){
+    VM vm;
+    double t0 = now_s();
+    for (int r=0; r<reps; r++){
+        vm = (VM){ .code=c->data, .code_len=(uint32_t)c->len, .stack=stack, .stack_cap=16,
+                   .locals=locals, .locals_cap=4, .callstack=calls, .call_cap=4,
+                   .mem=mem, .mem_cap=N };
+        if (vm_run(&vm) != VM_OK) fprintf(stderr, "TRAP\n");
+    }
+    *sum = locals[1];
+    return (now_s() - t0) / reps;
+}
+
+int main(int argc, char **argv){
+    int reps = argc > 1 ? atoi(argv[1]) : 2000;
+    uint32_t x = 1, ref = 0;
+    for (int i=0; i<N; i++){                     // 12-Bit-ADC-ähnliche Werte
+        x = x*1103515245u + 12345u;
+        mem[i] = (Val)((x >> 16) & 0xfff);
+        ref += (uint32_t)mem[i];
+    }
+    Code lo = build_loop(), na = build_native();
+    Val s_loop, s_nat;
+    double t_loop = measure(&lo, reps, &s_loop);
+    double t_nat  = measure(&na, reps * 20, &s_nat);
+
+    int ok = s_loop == (Val)ref && s_nat == (Val)ref;
+    printf("Summe über %d Werte, SIMD-Variante %s\n", N, vsimd_ops()->name);
+    printf("  Bytecode-Schleife (LOADM) : %9.2f us/Summe, %6.2f ns/Wert\n", t_loop*1e6, t_loop*1e9/N);
+    printf("  mem_sum (Block-Native)    : %9.2f us/Summe, %6.2f ns/Wert (%.0fx)\n",
+           t_nat*1e6, t_nat*1e9/N, t_loop/t_nat);
+    printf("  Ergebnis %s (%d)\n", ok ? "identisch" : "VERSCHIEDEN", (int)ref);
+    free(lo.data); free(na.data);
+    return ok ? 0 : 1;
+}
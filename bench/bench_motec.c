@@ -0,0 +1,169 @@
+// bench_motec.c – Übersetzungen je Sekunde: libmotec in N Threads (je ein
+// Kontext) gegen einen motec-Prozess je Übersetzung, ebenfalls N parallel.
+// Quelltexte unterscheiden sich in Konstanten, jeder achte enthält einen
+// Syntaxfehler. Beide Wege müssen für jeden Quelltext dasselbe liefern wie
+// eine vorab einzeln erzeugte Referenz: gleiches Image bzw. gleicher Fehler.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "bench_util.h"
+#include "../tools/libmotec.h"
+
+extern char **environ;
+
+#define NSRC 64
+
+typedef struct {
+    char src[4096]; size_t len;
+    uint8_t *image; size_t ilen;         // Referenz, NULL bei Fehler
+    MotecDiag diag;
+} Src;
+
+static Src srcs[NSRC];
+
+// Vier Funktionspaare, Schleifen, Arrays; k variiert die Konstanten
+static void make_src(Src *s, int k){
+    int n = 0;
+    for (int f=0; f<4; f++)
+        n += snprintf(s->src+n, sizeof s->src - n,
+            "func mix%d(a, b) {\n"
+            "  return (a * %d + b) ^ (a >> %d);\n"
+            "}\n"
+            "func filt%d(x) {\n"
+            "  let acc = 0;\n"
+            "  for (i = 0; i < %d; i = i + 1) {\n"
+            "    acc = acc + mix%d(x, i) %% 1000;\n"
+            "    if (acc > %d) { break; }\n"
+            "  }\n"
+            "  return acc;\n"
+            "}\n", f, 31+k+f, 1+(k+f)%7, f, 8+k%5, f, 5000+k*13);
+    n += snprintf(s->src+n, sizeof s->src - n,
+        "let buf[%d];\n"
+        "let n = 0;\n"
+        "while (n < 16) {\n"
+        "  buf[n] = filt0(n + %d) + filt1(n) - filt2(n * 3) + filt3(%d);\n"
+        "  n = n + %s;\n"
+        "}\n"
+        "print_int(mem_sum(buf, 16));\n", 16+k, k, k*7, k%8 == 7 ? "" : "1");
+    s->len = (size_t)n;
+}
+
+static int same_diag(const MotecDiag *a, const MotecDiag *b){
+    return a->line == b->line && a->col == b->col && !strcmp(a->msg, b->msg);
+}
+
+typedef struct {
+    int id, n;
+    int bad;
+    char dir[64];
+} Job;
+
+// In-Prozess: ein Kontext je Thread, für alle Übersetzungen wiederverwendet
+static void *lib_worker(void *arg){
+    Job *j = (Job*)arg;
+    Motec *m = motec_new(NULL);
+    for (int r=0; r<j->n; r++){
+        Src *s = &srcs[(j->id*7 + r) % NSRC];
+        uint8_t *img; size_t ilen;
+        int rc = motec_compile(m, s->src, s->len, &img, &ilen);
+        if (rc == 0){
+            if (!s->image || ilen != s->ilen || memcmp(img, s->image, ilen)) j->bad++;
+            free(img);
+        } else if (s->image || !same_diag(motec_diag(m), &s->diag)) j->bad++;
+    }
+    motec_free(m);
+    return NULL;
+}
+
+// Je Übersetzung: Quelltext in eine Datei, motec starten, Ergebnis lesen
+static void *proc_worker(void *arg){
+    Job *j = (Job*)arg;
+    char in[96], out[96];
+    snprintf(in, sizeof in, "%s/in.mo", j->dir);
+    snprintf(out, sizeof out, "%s/out.bin", j->dir);
+    uint8_t *buf = (uint8_t*)malloc(1 << 16);
+    for (int r=0; r<j->n; r++){
+        Src *s = &srcs[(j->id*7 + r) % NSRC];
+        FILE *f = fopen(in, "wb"); fwrite(s->src, 1, s->len, f); fclose(f);
+        remove(out);
+        char *argv[] = { (char*)MOTEC_PATH, in, out, NULL };
+        pid_t pid; int st = 0;
+        // Fehlermeldungen gehören zur Last, landen aber in /dev/null
+        posix_spawn_file_actions_t fa;
+        posix_spawn_file_actions_init(&fa);
+        posix_spawn_file_actions_addopen(&fa, 2, "/dev/null", O_WRONLY, 0);
+        if (posix_spawn(&pid, MOTEC_PATH, &fa, NULL, argv, environ)){ j->bad++; posix_spawn_file_actions_destroy(&fa); continue; }
+        posix_spawn_file_actions_destroy(&fa);
+        waitpid(pid, &st, 0);
+        int code = WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+        if (!s->image){ if (code != 2) j->bad++; continue; }
+        f = fopen(out, "rb");
+        size_t n = f ? fread(buf, 1, 1 << 16, f) : 0;
+        if (f) fclose(f);
+        if (code != 0 || n != s->ilen || memcmp(buf, s->image, n)) j->bad++;
+    }
+    free(buf);
+    return NULL;
+}
+
+static double run(int proc, int nthr, int per, int *bad){
+    pthread_t th[256]; Job jobs[256];
+    for (int t=0; t<nthr; t++){
+        jobs[t] = (Job){ .id=t, .n=per };
+        if (proc){
+            snprintf(jobs[t].dir, sizeof jobs[t].dir, "/tmp/bench_motec_XXXXXX");
+            if (!mkdtemp(jobs[t].dir)){ perror("mkdtemp"); exit(1); }
+        }
+    }
+    double t0 = now_s();
+    for (int t=0; t<nthr; t++) pthread_create(&th[t], NULL, proc ? proc_worker : lib_worker, &jobs[t]);
+    for (int t=0; t<nthr; t++) pthread_join(th[t], NULL);
+    double dt = now_s() - t0;
+    for (int t=0; t<nthr; t++){
+        *bad += jobs[t].bad;
+        if (proc){
+            char p[96];
+            snprintf(p, sizeof p, "%s/in.mo", jobs[t].dir); remove(p);
+            snprintf(p, sizeof p, "%s/out.bin", jobs[t].dir); remove(p);
+            rmdir(jobs[t].dir);
+        }
+    }
+    return nthr*(double)per / dt;
+}
+
+int main(int argc, char **argv){
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nthr = argc > 1 ? atoi(argv[1]) : (int)(ncpu > 1 ? ncpu : 1);
+    int per  = argc > 2 ? atoi(argv[2]) : 2000;
+    if (nthr < 1) nthr = 1;
+    if (nthr > 256) nthr = 256;
+
+    // Referenzen einzeln, mit einem frischen Kontext je Quelltext
+    int nerr = 0;
+    for (int k=0; k<NSRC; k++){
+        Src *s = &srcs[k];
+        make_src(s, k);
+        Motec *m = motec_new(NULL);
+        if (motec_compile(m, s->src, s->len, &s->image, &s->ilen)){ s->image = NULL; s->diag = *motec_diag(m); nerr++; }
+        motec_free(m);
+    }
+    printf("%d Quelltexte (%zu Bytes), %d mit Syntaxfehler, z. B. %d:%d: %s\n",
+           NSRC, srcs[0].len, nerr, srcs[7].diag.line, srcs[7].diag.col, srcs[7].diag.msg);
+
+    int bad = 0;
+    int pper = per/20 > 0 ? per/20 : 1;         // Prozesse sind langsam, weniger Durchläufe
+    double lib1 = run(0, 1, per, &bad);
+    double libn = run(0, nthr, per, &bad);
+    double proc = run(1, nthr, pper, &bad);
+    printf("libmotec, 1 Thread    : %9.0f Übersetzungen/s\n", lib1);
+    printf("libmotec, %2d Threads  : %9.0f Übersetzungen/s (%.2fx gegen 1 Thread)\n", nthr, libn, libn/lib1);
+    printf("motec-Prozess je Datei: %9.0f Übersetzungen/s mit %d parallel (%.1fx langsamer)\n", proc, nthr, libn/proc);
+    printf("  Ergebnis %s\n", bad ? "VERSCHIEDEN" : "identisch");
+    for (int k=0; k<NSRC; k++) free(srcs[k].image);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// bench_pid.c – PID-Regler in Q16.16 mit Strecke erster Ordnung:
+// Festkomma-Multiplikation als Bytecode-Funktion (bisher) gegen OP_FMUL
+#include <stdio.h>
+#include "bench_util.h"
+
+#define Q(x)  ((int32_t)((x) * 65536))
+#define SETP  Q(10.0)
+#define KP    Q(0.8)
+#define KI    Q(0.05)
+#define KD    Q(0.1)
+#define ALPHA Q(0.1)
+#define LOAD  1000                    // konstante Last auf der Strecke
+
+// Bisherige Emulation von (a*b) >> 16 nur mit 32-Bit-Operationen, exakt
+// (abgerundet) solange das Ergebnis in 32 Bit passt:
+//   a = ah*2^16 + al, b = bh*2^16 + bl mit al, bl in [0, 2^16), al = a1*256 + a0
+//   (a*b) >> 16 = ah*b + al*bh + (a1*bl + (a0*bl)/256) / 256
+// Slots 10..19 gehören der Funktion.
+static void floor_split(Code *c, uint8_t x, uint8_t h, uint8_t l){
+    op8(c, OP_LOADL, x); op32(c, OP_PUSHI, 65536); op(c, OP_DIV); op8(c, OP_STOREL, h);
+    op8(c, OP_LOADL, x); op8(c, OP_LOADL, h); op32(c, OP_PUSHI, 65536); op(c, OP_MUL); op(c, OP_SUB);
+    op8(c, OP_STOREL, l);
+    op8(c, OP_LOADL, l); op32(c, OP_PUSHI, 0); op(c, OP_LT); op8(c, OP_STOREL, 19);      // DIV rundet gegen 0
+    op8(c, OP_LOADL, h); op8(c, OP_LOADL, 19); op(c, OP_SUB); op8(c, OP_STOREL, h);
+    op8(c, OP_LOADL, l); op8(c, OP_LOADL, 19); op32(c, OP_PUSHI, 65536); op(c, OP_MUL); op(c, OP_ADD);
+    op8(c, OP_STOREL, l);
+}
+
+static void emit_fmul_emul(Code *c){
+    op8(c, OP_STOREL, 11); op8(c, OP_STOREL, 10);
+    floor_split(c, 10, 12, 13);
+    floor_split(c, 11, 14, 15);
+    op8(c, OP_LOADL, 13); op32(c, OP_PUSHI, 256); op(c, OP_DIV); op8(c, OP_STOREL, 16);
+    op8(c, OP_LOADL, 13); op8(c, OP_LOADL, 16); op32(c, OP_PUSHI, 256); op(c, OP_MUL); op(c, OP_SUB);
+    op8(c, OP_STOREL, 17);
+    op8(c, OP_LOADL, 12); op8(c, OP_LOADL, 11); op(c, OP_MUL);
+    op8(c, OP_LOADL, 13); op8(c, OP_LOADL, 14); op(c, OP_MUL); op(c, OP_ADD);
+    op8(c, OP_LOADL, 16); op8(c, OP_LOADL, 15); op(c, OP_MUL);
+    op8(c, OP_LOADL, 17); op8(c, OP_LOADL, 15); op(c, OP_MUL); op32(c, OP_PUSHI, 256); op(c, OP_DIV);
+    op(c, OP_ADD); op32(c, OP_PUSHI, 256); op(c, OP_DIV); op(c, OP_ADD);
+    op(c, OP_RET);
+}
+
+typedef struct { size_t at[8]; int n; } Calls;
+
+static void fmul(Code *c, int native, Calls *k){
+    if (native) op(c, OP_FMUL);
+    else k->at[k->n++] = op32(c, OP_CALLUSER, 0);
+}
+
+// locals: 0 Zähler, 1 y, 2 Integral, 3 e alt, 4 e, 5 u, 6 Prüfsumme über u, 7 Ableitung
+static Code build(int native, int32_t iters){
+    Code c = {0}; Calls k = {{0}, 0};
+    Loop l = loop_begin(&c, 0, iters);
+    op32(&c, OP_PUSHI, SETP); op8(&c, OP_LOADL, 1); op(&c, OP_SUB); op8(&c, OP_STOREL, 4);
+    op8(&c, OP_LOADL, 2); op32(&c, OP_PUSHI, KI); op8(&c, OP_LOADL, 4); fmul(&c, native, &k);
+    op(&c, OP_ADD); op8(&c, OP_STOREL, 2);
+    op8(&c, OP_LOADL, 4); op8(&c, OP_LOADL, 3); op(&c, OP_SUB); op8(&c, OP_STOREL, 7);
+    op32(&c, OP_PUSHI, KP); op8(&c, OP_LOADL, 4); fmul(&c, native, &k);
+    op8(&c, OP_LOADL, 2); op(&c, OP_ADD);
+    op32(&c, OP_PUSHI, KD); op8(&c, OP_LOADL, 7); fmul(&c, native, &k);
+    op(&c, OP_ADD); op8(&c, OP_STOREL, 5);
+    op8(&c, OP_LOADL, 4); op8(&c, OP_STOREL, 3);
+    op8(&c, OP_LOADL, 1);
+    op32(&c, OP_PUSHI, ALPHA); op8(&c, OP_LOADL, 5); op8(&c, OP_LOADL, 1); op(&c, OP_SUB); fmul(&c, native, &k);
+    op(&c, OP_ADD); op32(&c, OP_PUSHI, LOAD); op(&c, OP_SUB); op8(&c, OP_STOREL, 1);
+    op8(&c, OP_LOADL, 6); op8(&c, OP_LOADL, 5); op(&c, OP_ADD); op8(&c, OP_STOREL, 6);
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    if (!native){
+        int32_t f = (int32_t)c.len;
+        emit_fmul_emul(&c);
+        for (int i=0; i<k.n; i++) patch32(&c, k.at[i], f);
+    }
+    return c;
+}
+
+static double run(const Code *c, Val *y, Val *sum){
+    Val stack[32], locals[20] = {0};
+    uint32_t calls[4];
+    VM vm = { .code=c->data, .code_len=(uint32_t)c->len, .stack=stack, .stack_cap=32,
+              .locals=locals, .locals_cap=20, .callstack=calls, .call_cap=4 };
+    double t0 = now_s();
+    if (vm_run(&vm) != VM_OK) fprintf(stderr, "TRAP\n");
+    double t = now_s() - t0;
+    *y = locals[1]; *sum = locals[6];
+    return t;
+}
+
+int main(int argc, char **argv){
+    int32_t iters = argc > 1 ? atoi(argv[1]) : 1000000;
+    Code emu = build(0, iters), nat = build(1, iters);
+    Val ye, se, yn, sn;
+    double te = run(&emu, &ye, &se);
+    double tn = run(&nat, &yn, &sn);
+    int ok = ye == yn && se == sn;
+    printf("PID Q16.16, %d Regelschritte (4 Festkomma-Multiplikationen je Schritt)\n", iters);
+    printf("  Bytecode-Emulation : %8.2f ns/Schritt, %zu Bytes Code\n", te*1e9/iters, emu.len);
+    printf("  OP_FMUL            : %8.2f ns/Schritt, %zu Bytes Code (%.1fx)\n", tn*1e9/iters, nat.len, te/tn);
+    printf("  Ergebnis %s (y = %.4f)\n", ok ? "identisch" : "VERSCHIEDEN", yn / 65536.0);
+    free(emu.data); free(nat.data);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+// bench_snap.c – Parameterstudie nach langer Aufwärmphase:
+// Aufwärmphase je Szenario neu rechnen gegen Fork/Reset/Restore eines Snapshots
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/vm_snap.h"
+
+// Aufwärmphase: warm Iterationen über locals[1], dann HALT als Haltepunkt.
+// Danach Szenario: locals[3] (vom Host je Szenario gesetzt) fließt in eval
+// Iterationen ein, Ergebnis in locals[2].
+static Code build(int32_t warm, int32_t eval){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 1); op8(&c, OP_STOREL, 1);
+    Loop l = loop_begin(&c, 0, warm);
+    op8(&c, OP_LOADL, 1); op32(&c, OP_PUSHI, 1103515245); op(&c, OP_MUL);
+    op32(&c, OP_PUSHI, 12345); op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);                                 // vm_run kehrt hier mit ip dahinter zurück
+    op8(&c, OP_LOADL, 1); op8(&c, OP_STOREL, 2);
+    Loop e = loop_begin(&c, 0, eval);
+    op8(&c, OP_LOADL, 2); op8(&c, OP_LOADL, 3); op(&c, OP_MUL);
+    op32(&c, OP_PUSHI, 7); op(&c, OP_ADD); op8(&c, OP_STOREL, 2);
+    loop_end(&c, e, 0);
+    op(&c, OP_HALT);
+    return c;
+}
+
+typedef struct { Val stack[64], locals[8]; uint32_t calls[16]; VM vm; } Inst;
+
+static void inst_init(Inst *I, const Code *c){
+    memset(I, 0, sizeof(*I));
+    I->vm = (VM){ .code=c->data, .code_len=(uint32_t)c->len, .stack=I->stack, .stack_cap=64,
+                  .locals=I->locals, .locals_cap=8, .callstack=I->calls, .call_cap=16 };
+}
+
+static Val run_scenario(VM *vm, Val param){
+    vm->locals[3] = param;
+    if (vm_run(vm) != VM_OK) fprintf(stderr, "TRAP\n");
+    return vm->locals[2];
+}
+
+int main(int argc, char **argv){
+    int32_t warm = argc > 1 ? atoi(argv[1]) : 1000000;
+    int nscen = argc > 2 ? atoi(argv[2]) : 1000;
+    int32_t eval = 100;
+    Code c = build(warm, eval);
+    Val *ref = (Val*)malloc(nscen*sizeof(Val)), *got = (Val*)malloc(nscen*sizeof(Val));
+    int ok = 1;
+
+    // Referenz: Aufwärmphase je Szenario neu (nur für wenige Szenarien gemessen, dann hochgerechnet)
+    int nref = nscen < 20 ? nscen : 20;
+    Inst I;
+    double t0 = now_s();
+    for (int k=0; k<nref; k++){
+        inst_init(&I, &c);
+        vm_run(&I.vm);                               // bis zum Haltepunkt
+        ref[k] = run_scenario(&I.vm, k);
+    }
+    double t_rerun = (now_s() - t0) / nref;
+
+    // Einmal aufwärmen, Snapshot
+    inst_init(&I, &c);
+    t0 = now_s();
+    vm_run(&I.vm);
+    double t_warm = now_s() - t0;
+    t0 = now_s();
+    VmSnap *s = vm_snapshot(&I.vm);
+    double t_snap = now_s() - t0;
+    if (!s){ fprintf(stderr, "Snapshot fehlgeschlagen\n"); return 1; }
+
+    // a) je Szenario ein neuer Fork
+    t0 = now_s();
+    for (int k=0; k<nscen; k++){
+        VM *f = vm_fork(s, NULL);
+        got[k] = run_scenario(f, k);
+        vm_fork_free(f);
+    }
+    double t_fork = (now_s() - t0) / nscen;
+    for (int k=0; k<nref; k++) ok &= got[k] == ref[k];
+
+    // b) ein Fork, vor jedem Szenario zurückgesetzt
+    VM *f = vm_fork(s, NULL);
+    t0 = now_s();
+    for (int k=0; k<nscen; k++){ vm_fork_reset(f); got[k] = run_scenario(f, k); }
+    double t_reset = (now_s() - t0) / nscen;
+    vm_fork_free(f);
+    for (int k=0; k<nref; k++) ok &= got[k] == ref[k];
+
+    // c) in eine gewöhnliche VM zurückkopieren
+    Inst R; inst_init(&R, &c);
+    t0 = now_s();
+    for (int k=0; k<nscen; k++){ vm_restore(&R.vm, s); got[k] = run_scenario(&R.vm, k); }
+    double t_restore = (now_s() - t0) / nscen;
+    for (int k=0; k<nref; k++) ok &= got[k] == ref[k];
+
+    // d) speichern und wieder öffnen (Neustart eines Prozesses)
+    const char *path = "bench_snap.msnp";
+    vm_snap_save(s, path);
+    t0 = now_s();
+    VmSnap *s2 = vm_snap_open(path, c.data, c.len);
+    VM *f2 = s2 ? vm_fork(s2, NULL) : NULL;
+    double t_open = now_s() - t0;
+    if (f2){ ok &= run_scenario(f2, 0) == ref[0]; vm_fork_free(f2); } else ok = 0;
+    vm_snap_free(s2); remove(path);
+
+    printf("Aufwärmphase %d Iterationen (%.2f ms), %d Szenarien à %d Iterationen\n",
+           warm, t_warm*1e3, nscen, eval);
+    printf("  je Szenario neu aufwärmen   : %10.2f us/Szenario\n", t_rerun*1e6);
+    printf("  Snapshot anlegen            : %10.2f us (einmalig)\n", t_snap*1e6);
+    printf("  vm_fork + Lauf + Freigabe   : %10.2f us/Szenario (%.0fx)\n", t_fork*1e6, t_rerun/t_fork);
+    printf("  vm_fork_reset + Lauf        : %10.2f us/Szenario (%.0fx)\n", t_reset*1e6, t_rerun/t_reset);
+    printf("  vm_restore (Kopie) + Lauf   : %10.2f us/Szenario (%.0fx)\n", t_restore*1e6, t_rerun/t_restore);
+    printf("  Datei öffnen + erster Fork  : %10.2f us\n", t_open*1e6);
+    printf("  Ergebnisse %s\n", ok ? "identisch" : "VERSCHIEDEN");
+
+    vm_snap_free(s);
+    free(ref); free(got); free(c.data);
+    return ok ? 0 : 1;
+}
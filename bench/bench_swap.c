@@ -0,0 +1,110 @@
+// bench_swap.c – Austausch im Betrieb: mehrere VMs mit unterschiedlich viel
+// Zustand laufen reihum, ein zweiter Thread bereitet ständig neue Images vor.
+// Gemessen wird die Pause je Austausch (nur im VM-Thread), berichtet die
+// schlechteste je VM. Beide Fassungen rechnen dasselbe, liegen aber an
+// anderen Adressen, das Endergebnis muss also unverändert sein.
+#include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "bench_util.h"
+#include "../src/vm_swap.h"
+#include "../src/image.h"
+
+#define NVM 4
+static const uint32_t mem_words[NVM] = { 0, 1024, 16384, 262144 };
+
+// locals: 0 Zähler (n..1), 1 Summe; buf[i % mem] = Summe; yield(1) je Durchlauf
+static uint8_t *build(int variant, uint32_t mem, int32_t n, size_t *len){
+    Code c = {0};
+    for (int k=0; k<variant*3; k++){ op32(&c, OP_PUSHI, k); op(&c, OP_DROP); }   // verschiebt alle Adressen
+    op32(&c, OP_PUSHI, 0); op8(&c, OP_STOREL, 1);
+    Loop l = loop_begin(&c, 0, n);
+    op8(&c, OP_LOADL, 1); op8(&c, OP_LOADL, 0); op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+    if (mem){
+        op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, (int32_t)mem); op(&c, OP_MOD);
+        op8(&c, OP_LOADL, 1); op(&c, OP_STOREM);
+    }
+    op32(&c, OP_PUSHI, 1); op8(&c, OP_CALL, NAT_YIELD);
+    MoteYield y = { 1, (uint32_t)c.len };
+    op(&c, OP_DROP);
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+
+    MoteSlot s[3] = { { MOTE_SLOT_LOCAL, "i", 0, 1 }, { MOTE_SLOT_LOCAL, "acc", 1, 1 },
+                      { MOTE_SLOT_ARRAY, "buf", 0, mem } };
+    MoteMeta meta = { 2, mem };
+    uint8_t metabuf[MOTE_META_SIZE];
+    uint32_t slen, ylen;
+    uint8_t *sb = mote_slots_encode(s, mem ? 3 : 2, &slen), *yb = mote_yields_encode(&y, 1, &ylen);
+    MoteSection sect[4] = {
+        { {'M','E','T','A'}, metabuf, mote_meta_encode(&meta, metabuf) },
+        { {'C','O','D','E'}, c.data, (uint32_t)c.len },
+        { {'S','L','O','T'}, sb, slen },
+        { {'Y','E','L','D'}, yb, ylen },
+    };
+    uint8_t *img = mote_image_encode(sect, 4, len);
+    free(sb); free(yb); free(c.data);
+    return img;
+}
+
+static VmSwap *S[NVM];
+static int32_t iters;
+static atomic_int running = 1;
+static long prepared;
+
+// Neue Fassung abwechselnd vorbereiten, etwa alle 2 ms je VM
+static void *loader(void *arg){
+    (void)arg;
+    struct timespec ts = { 0, 2000000 };
+    for (int v=1; running; v ^= 1){
+        for (int k=0; k<NVM; k++){
+            size_t len; uint8_t *img = build(v, mem_words[k], iters, &len);
+            char err[160];
+            if (vm_swap_prepare(S[k], img, len, err, sizeof err) != 0) fprintf(stderr, "VM %d: %s\n", k, err);
+            else prepared++;
+        }
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv){
+    iters = argc > 1 ? atoi(argv[1]) : 200000;
+    VM vm[NVM]; VmRes r[NVM];
+    for (int k=0; k<NVM; k++){
+        size_t len; uint8_t *img = build(0, mem_words[k], iters, &len);
+        char err[160];
+        S[k] = vm_swap_open(&vm[k], img, len, NULL, err, sizeof err);
+        if (!S[k]){ fprintf(stderr, "%s\n", err); return 1; }
+        r[k] = VM_YIELD;
+    }
+    pthread_t th; pthread_create(&th, NULL, loader, NULL);
+
+    double t0 = now_s();
+    for (int live = NVM; live; ){
+        live = 0;
+        for (int k=0; k<NVM; k++){
+            if (r[k] != VM_YIELD) continue;
+            vm_swap_apply(S[k], &vm[k]);
+            r[k] = vm_run(&vm[k]);
+            live++;
+        }
+    }
+    double t = now_s() - t0;
+    running = 0; pthread_join(th, NULL);
+
+    int ok = 1;
+    Val expect = (Val)((int64_t)iters*(iters+1)/2);
+    printf("%d VMs, je %d yields, %.1f ms, %ld Images vorbereitet\n", NVM, iters, t*1e3, prepared);
+    printf("  VM  Speicher   Tausche   Pause max    Mittel   Ergebnis\n");
+    for (int k=0; k<NVM; k++){
+        VmSwapStats st; vm_swap_stats(S[k], &st);
+        int same = r[k] == VM_OK && vm[k].locals[1] == expect;
+        ok &= same;
+        printf("  %2d  %8u  %8u  %7.1f us  %6.2f us   %s\n", k, mem_words[k], st.swaps,
+               st.pause_max_ns*1e-3, st.swaps ? st.pause_sum_ns*1e-3/st.swaps : 0.0,
+               same ? "identisch" : "VERSCHIEDEN");
+        vm_swap_close(S[k]);
+    }
+    return ok ? 0 : 1;
+}
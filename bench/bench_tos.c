@@ -0,0 +1,137 @@
+// bench_tos.c – Rechenlastige Schleifen: vm_run (jeder Wert über vm->stack,
+// ip/sp über den VM-Zeiger) gegen vm_run_tos (oberster Wert, ip und sp in
+// Registern). Vorher eine Gleichheitsprüfung über Zufallsprogramme mit
+// kleinem Stack, damit auch Unter-/Überlauf und Traps verglichen werden.
+#include <stdio.h>
+#include "bench_util.h"
+#include "../src/vm_ops.h"
+#include "../src/vm_tos.h"
+
+#define MEM 256
+
+// 0: LCG           x = x*1103515245 + 12345, s += x >> 16
+// 1: Horner Q16.16 p = ((c3*t + c2)*t + c1)*t + c0, s += p ^ (p >> 7)
+// 2: Stack-Ops     x = i + (i > i*i), s ^= 7x über DUP/OVER/SWAP
+// 3: Array         mem[i & 255] += i, s += mem[(i*7) & 255]
+// locals[1] = Prüfsumme, locals[2] = Zustand
+static Code build(int kind, int32_t iters){
+    Code c = {0};
+    op32(&c, OP_PUSHI, 0); op8(&c, OP_STOREL, 1);
+    op32(&c, OP_PUSHI, 1); op8(&c, OP_STOREL, 2);
+    Loop l = loop_begin(&c, 0, iters);
+    switch (kind){
+    case 0:
+        op8(&c, OP_LOADL, 2); op32(&c, OP_PUSHI, 1103515245); op(&c, OP_MUL);
+        op32(&c, OP_PUSHI, 12345); op(&c, OP_ADD); op(&c, OP_DUP); op8(&c, OP_STOREL, 2);
+        op32(&c, OP_PUSHI, 16); op(&c, OP_SHR); op8(&c, OP_LOADL, 1); op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+        break;
+    case 1:
+        op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, 0xFFFF); op(&c, OP_BAND); op8(&c, OP_STOREL, 2);   // t in [0,1)
+        op32(&c, OP_PUSHI, 3 << 14);
+        op8(&c, OP_LOADL, 2); op(&c, OP_FMUL); op32(&c, OP_PUSHI, -(1 << 15)); op(&c, OP_ADD);
+        op8(&c, OP_LOADL, 2); op(&c, OP_FMUL); op32(&c, OP_PUSHI, 5 << 16); op(&c, OP_ADD);
+        op8(&c, OP_LOADL, 2); op(&c, OP_FMUL); op32(&c, OP_PUSHI, 1 << 16); op(&c, OP_ADD);
+        op(&c, OP_DUP); op32(&c, OP_PUSHI, 7); op(&c, OP_SHR); op(&c, OP_BXOR);
+        op8(&c, OP_LOADL, 1); op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+        break;
+    case 2:
+        op8(&c, OP_LOADL, 0); op(&c, OP_DUP); op(&c, OP_DUP); op(&c, OP_MUL);           // i i*i
+        op(&c, OP_OVER); op(&c, OP_OVER); op(&c, OP_GT); op(&c, OP_SWAP); op(&c, OP_DROP);  // i (i > i*i)
+        op(&c, OP_ADD); op(&c, OP_DUP); op32(&c, OP_PUSHI, 3); op(&c, OP_SHL); op(&c, OP_SWAP);
+        op(&c, OP_SUB); op8(&c, OP_LOADL, 1); op(&c, OP_BXOR); op8(&c, OP_STOREL, 1);        // s ^= 7x
+        break;
+    default:
+        op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, MEM-1); op(&c, OP_BAND);
+        op(&c, OP_DUP); op(&c, OP_LOADM); op8(&c, OP_LOADL, 0); op(&c, OP_ADD); op(&c, OP_STOREM);
+        op8(&c, OP_LOADL, 0); op32(&c, OP_PUSHI, 7); op(&c, OP_MUL); op32(&c, OP_PUSHI, MEM-1); op(&c, OP_BAND);
+        op(&c, OP_LOADM); op8(&c, OP_LOADL, 1); op(&c, OP_ADD); op8(&c, OP_STOREL, 1);
+        break;
+    }
+    loop_end(&c, l, 0);
+    op(&c, OP_HALT);
+    return c;
+}
+
+typedef struct {
+    Val stack[16], locals[4], mem[MEM];
+    uint32_t calls[4];
+    VM vm;
+    VmRes r;
+} Inst;
+
+static void inst_init(Inst *I, const uint8_t *code, size_t len, uint32_t stack_cap){
+    memset(I, 0, sizeof *I);
+    for (int k=0; k<MEM; k++) I->mem[k] = k*3 - 100;
+    I->vm = (VM){ .code=code, .code_len=(uint32_t)len, .stack=I->stack, .stack_cap=stack_cap,
+                  .locals=I->locals, .locals_cap=4, .callstack=I->calls, .call_cap=4,
+                  .mem=I->mem, .mem_cap=MEM };
+}
+
+// Sichtbarer Zustand gleich: Ergebnis, ip, sp, stack[0..sp), locals, mem
+static int same(const Inst *a, const Inst *b){
+    return a->r == b->r && a->vm.ip == b->vm.ip && a->vm.sp == b->vm.sp
+        && !memcmp(a->stack, b->stack, a->vm.sp*sizeof(Val))
+        && !memcmp(a->locals, b->locals, sizeof a->locals) && !memcmp(a->mem, b->mem, sizeof a->mem);
+}
+
+// Zufallsprogramme ohne Sprünge und Natives, Stack mit 3 Einträgen
+static int fuzz(int n){
+    static const Op ops[] = { OP_PUSHI, OP_PUSHI, OP_LOADL, OP_STOREL, OP_ADD, OP_SUB, OP_MUL, OP_DIV,
+        OP_LT, OP_EQ, OP_DUP, OP_DROP, OP_SWAP, OP_OVER, OP_GT, OP_GE, OP_LE, OP_NE, OP_NOT, OP_AND,
+        OP_OR, OP_LOADM, OP_STOREM, OP_MOD, OP_SHL, OP_SHR, OP_BAND, OP_BOR, OP_BXOR, OP_FMUL, OP_FDIV,
+        OP_ADD64, OP_MUL64 };
+    uint32_t seed = 12345;
+    int bad = 0;
+    for (int p=0; p<n; p++){
+        Code c = {0};
+        for (int k=0; k<40; k++){
+            seed = seed*1103515245u + 12345u;
+            Op o = ops[(seed >> 16) % (sizeof ops / sizeof ops[0])];
+            if (o == OP_PUSHI) op32(&c, o, (int32_t)(seed >> 8) % 300 - 20);
+            else if (o == OP_LOADL || o == OP_STOREL) op8(&c, o, (uint8_t)((seed >> 4) % 5));   // 4 -> Trap
+            else op(&c, o);
+        }
+        if (p & 1) op(&c, OP_HALT);                   // sonst Trap am Code-Ende
+        static Inst a, b;
+        inst_init(&a, c.data, c.len, 3); inst_init(&b, c.data, c.len, 3);
+        a.r = vm_run(&a.vm); b.r = vm_run_tos(&b.vm);
+        if (!same(&a, &b)){ if (!bad) fprintf(stderr, "Zufallsprogramm %d verschieden\n", p); bad++; }
+        free(c.data);
+    }
+    return bad;
+}
+
+typedef struct { double t; Inst I; } Res;
+
+static void run(const Code *c, int tos, Res *x){
+    inst_init(&x->I, c->data, c->len, 16);
+    double t0 = now_s();
+    x->I.r = tos ? vm_run_tos(&x->I.vm) : vm_run(&x->I.vm);
+    x->t = now_s() - t0;
+}
+
+int main(int argc, char **argv){
+    int32_t iters = argc > 1 ? atoi(argv[1]) : 2000000;
+    static const char *name[4] = { "LCG                ", "Horner Q16.16      ", "DUP/OVER/SWAP      ", "Array LOADM/STOREM " };
+    int nf = 20000, bad = fuzz(nf);
+    printf("Zufallsprogramme: %d von %d gleich\n", nf - bad, nf);
+    int ok = !bad;
+    printf("Top-of-Stack im Register, %d Iterationen je Schleife\n", iters);
+    for (int k=0; k<4; k++){
+        Code c = build(k, iters);
+        static Res v, s, a, b;
+        run(&c, 0, &v); run(&c, 1, &s);
+        for (int r=1; r<9; r++){                      // abwechselnd, jeweils Bestzeit
+            run(&c, 0, &a); run(&c, 1, &b);
+            if (a.t < v.t) v = a;
+            if (b.t < s.t) s = b;
+        }
+        int eq = v.I.r == VM_OK && same(&v.I, &s.I);
+        ok &= eq;
+        printf("  %s: vm_run %6.2f ns, vm_run_tos %6.2f ns je Iteration (%.2fx)%s\n",
+               name[k], v.t*1e9/iters, s.t*1e9/iters, v.t/s.t, eq ? "" : "  VERSCHIEDEN");
+        free(c.data);
+    }
+    printf("  Ergebnis %s\n", ok ? "identisch" : "VERSCHIEDEN");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#pragma once
+// Gemeinsame Helfer für die Benchmarks: Bytecode im Speicher bauen und Zeit messen.
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../src/vm.h"
+
+typedef struct { uint8_t *data; size_t len, cap; } Code;
+
+static inline void code_res(Code *c, size_t need){
+    if (need > c->cap){
+        size_t nc = c->cap ? c->cap*2 : 256;
+        while (nc < need) nc *= 2;
+        c->data = (uint8_t*)realloc(c->data, nc); c->cap = nc;
+    }
+}
+static inline void op(Code *c, Op o){ code_res(c, c->len+1); c->data[c->len++] = (uint8_t)o; }
+static inline void op8(Code *c, Op o, uint8_t a){ op(c, o); code_res(c, c->len+1); c->data[c->len++] = a; }
+static inline size_t op32(Code *c, Op o, int32_t a){
+    op(c, o); code_res(c, c->len+4);
+    memcpy(c->data+c->len, &a, 4); c->len += 4;
+    return c->len-4;                       // Position des Operanden zum Patchen
+}
+static inline void patch32(Code *c, size_t at, int32_t v){ memcpy(c->data+at, &v, 4); }
+
+// Schleifenrahmen: locals[slot] zählt von n herunter
+typedef struct { size_t head, exit_fix; } Loop;
+static inline Loop loop_begin(Code *c, uint8_t slot, int32_t n){
+    Loop l;
+    op32(c, OP_PUSHI, n); op8(c, OP_STOREL, slot);
+    l.head = c->len;
+    op8(c, OP_LOADL, slot);
+    l.exit_fix = op32(c, OP_JZ, 0);
+    return l;
+}
+static inline void loop_end(Code *c, Loop l, uint8_t slot){
+    op8(c, OP_LOADL, slot); op32(c, OP_PUSHI, 1); op(c, OP_SUB); op8(c, OP_STOREL, slot);
+    op32(c, OP_JMP, (int32_t)l.head);
+    patch32(c, l.exit_fix, (int32_t)c->len);
+}
+
+static inline double now_s(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
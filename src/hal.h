@@ -0,0 +1,43 @@
+// hal.h – Schnittstelle zwischen VM und Hardware
+//
+// Dynamisch (Standard): vm->hal zeigt auf eine struct HAL, jeder Native geht
+// über den Funktionszeiger. Eigene HALs (Trace, Benchmarks) legen die
+// struct HAL als erstes Feld in ihren Kontext; ctx ist dann derselbe Zeiger.
+//
+// Statisch (MOTE_STATIC_HAL): der Interpreter ruft die mote_hal_*-Funktionen
+// direkt auf, ctx bleibt vm->hal. Mit LTO landen sie in der Dispatch-Schleife.
+// Eine HAL mit eigenen Namen bindet vm_interp.h über VM_HAL_CALL.
+#pragma once
+#include <stdint.h>
+#include "vm.h"
+
+struct HAL {
+  void(*gpio_mode)(void*,int,int);
+  void(*gpio_write)(void*,int,int);
+  void(*sleep_ms)(void*,int);
+  int (*gpio_read)(void*,int);
+  void(*print_int)(void*,int);
+  void(*gpio_mode_mask)(void*,int,uint32_t,int);
+  void(*gpio_write_mask)(void*,int,uint32_t,uint32_t);
+  uint32_t(*gpio_read_port)(void*,int);
+  int (*irq_attach)(void*,int,int);          // Flankenerkennung für pin aktivieren
+  int (*event_poll)(void*,int*,int*);        // nicht blockierend: 1 = Ereignis (pin, edge)
+  void(*event_wait)(void*,int);              // blockiert bis ein Ereignis ansteht
+  int (*adc_read)(void*,int,Val*,int);       // bis zu n Werte 0..VM_ADC_MAX von Kanal ch, Rückgabe Anzahl
+};
+
+// Host-HAL (hal_stub.c) unter festen Namen
+void     mote_hal_gpio_mode(void*,int,int);
+void     mote_hal_gpio_write(void*,int,int);
+void     mote_hal_sleep_ms(void*,int);
+int      mote_hal_gpio_read(void*,int);
+void     mote_hal_print_int(void*,int);
+void     mote_hal_gpio_mode_mask(void*,int,uint32_t,int);
+void     mote_hal_gpio_write_mask(void*,int,uint32_t,uint32_t);
+uint32_t mote_hal_gpio_read_port(void*,int);
+int      mote_hal_irq_attach(void*,int,int);
+int      mote_hal_event_poll(void*,int*,int*);
+void     mote_hal_event_wait(void*,int);
+int      mote_hal_adc_read(void*,int,Val*,int);
+
+void* mote_bind_hal();
@@ -1,18 +1,35 @@
-#include "vm.h"
+#include "hal.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <time.h>
 #endif
 
-static void hal_gpio_mode(void*ctx,int pin,int mode){
+// Pin-Zustand als Bitfelder je Port (pin = port*32 + bit)
+#define HAL_PORTS 8
+static uint32_t port_out[HAL_PORTS], port_dir[HAL_PORTS];
+
+static int pin_ok(int pin){ return pin>=0 && pin<HAL_PORTS*32; }
+
+void mote_hal_gpio_mode(void*ctx,int pin,int mode){
   (void)ctx; printf("[HAL] gpio_mode pin=%d mode=%d\n", pin, mode);
+  if (pin_ok(pin)){
+    uint32_t bit = 1u << (pin&31);
+    port_dir[pin>>5] = mode ? port_dir[pin>>5]|bit : port_dir[pin>>5]&~bit;
+  }
 }
-static void hal_gpio_write(void*ctx,int pin,int val){
+void mote_hal_gpio_write(void*ctx,int pin,int val){
   (void)ctx; printf("[HAL] gpio_write pin=%d val=%d\n", pin, val);
+  if (pin_ok(pin)){
+    uint32_t bit = 1u << (pin&31);
+    port_out[pin>>5] = val ? port_out[pin>>5]|bit : port_out[pin>>5]&~bit;
+  }
 }
-static void hal_sleep_ms(void*ctx,int ms){
+void mote_hal_sleep_ms(void*ctx,int ms){
   (void)ctx;
 #ifdef _WIN32
   Sleep(ms);
@@ -21,20 +38,213 @@ static void hal_sleep_ms(void*ctx,int ms){
 #endif
 }
 
-static int hal_gpio_read(void*ctx,int pin){
-  (void)ctx; (void)pin;
-  static int counter=0, state=1;
+static int counter=0, state=1;
+static int next_input(void){
   if (++counter % 200 == 0) state = !state;   // wechselt periodisch
-  printf("[HAL] gpio_read pin=%d -> %d\n", pin, state);
   return state;
 }
 
+int mote_hal_gpio_read(void*ctx,int pin){
+  (void)ctx; (void)pin;
+  int v = next_input();
+  printf("[HAL] gpio_read pin=%d -> %d\n", pin, v);
+  return v;
+}
+
+void mote_hal_print_int(void*ctx,int v){
+  (void)ctx; printf("%d\n", v);
+}
+
+// ---- Port-weite Zugriffe: ein Registerzugriff statt einer Schleife über Pins ----
+void mote_hal_gpio_mode_mask(void*ctx,int port,uint32_t mask,int mode){
+  (void)ctx;
+  printf("[HAL] gpio_mode_mask port=%d mask=0x%08X mode=%d\n", port, mask, mode);
+  if (port>=0 && port<HAL_PORTS) port_dir[port] = mode ? port_dir[port]|mask : port_dir[port]&~mask;
+}
+void mote_hal_gpio_write_mask(void*ctx,int port,uint32_t mask,uint32_t val){
+  (void)ctx;
+  if (port<0 || port>=HAL_PORTS) return;
+  port_out[port] = (port_out[port] & ~mask) | (val & mask);
+  printf("[HAL] gpio_write_mask port=%d mask=0x%08X val=0x%08X -> 0x%08X\n", port, mask, val, port_out[port]);
+}
+uint32_t mote_hal_gpio_read_port(void*ctx,int port){
+  (void)ctx;
+  // Eingänge folgen demselben Takt wie gpio_read, Ausgänge lesen ihren Latch zurück
+  uint32_t in = next_input() ? 0xFFFFFFFFu : 0;
+  uint32_t v = port>=0 && port<HAL_PORTS ? (in & ~port_dir[port]) | (port_out[port] & port_dir[port]) : 0;
+  printf("[HAL] gpio_read_port port=%d -> 0x%08X\n", port, v);
+  return v;
+}
+
+// ---- Interrupts: synthetische Rechteckquelle je registriertem Pin ----
+// Jeder Pin wechselt alle MOTE_IRQ_PERIOD_MS (Standard 500) den Pegel. Die
+// Flanken landen in einer Ereignis-Queue, die die VM an sicheren Punkten leert.
+#define HAL_MAX_IRQ 8
+#define HAL_QUEUE   32
+
+static struct { int pin, edge, level; double next_ms; } irq_src[HAL_MAX_IRQ];
+static int nirq_src;
+static struct { int pin, edge; } evq[HAL_QUEUE];
+static unsigned evq_head, evq_tail;
+static double irq_period_ms = -1;
+
+static double now_ms(void){
+#ifdef _WIN32
+  return (double)GetTickCount64();
+#else
+  struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1e3 + ts.tv_nsec*1e-6;
+#endif
+}
+
+static void irq_generate(double now){
+  for (int i=0;i<nirq_src;i++){
+    while (now >= irq_src[i].next_ms){
+      irq_src[i].level = !irq_src[i].level;
+      int edge = irq_src[i].level ? EDGE_RISING : EDGE_FALLING;
+      if ((irq_src[i].edge & edge) && evq_tail - evq_head < HAL_QUEUE){
+        evq[evq_tail % HAL_QUEUE].pin = irq_src[i].pin;
+        evq[evq_tail % HAL_QUEUE].edge = edge;
+        evq_tail++;
+      }
+      irq_src[i].next_ms += irq_period_ms;
+    }
+  }
+}
+
+int mote_hal_irq_attach(void*ctx,int pin,int edge){
+  (void)ctx;
+  if (irq_period_ms < 0){
+    const char *e = getenv("MOTE_IRQ_PERIOD_MS");
+    irq_period_ms = e && atof(e) > 0 ? atof(e) : 500;
+  }
+  int i=0;
+  while (i<nirq_src && irq_src[i].pin!=pin) i++;
+  if (i==HAL_MAX_IRQ) return -1;
+  if (i==nirq_src){ nirq_src++; irq_src[i].level = 0; irq_src[i].next_ms = now_ms() + irq_period_ms; }
+  irq_src[i].pin = pin; irq_src[i].edge = edge;
+  printf("[HAL] irq_attach pin=%d edge=%d\n", pin, edge);
+  return 0;
+}
+
+int mote_hal_event_poll(void*ctx,int*pin,int*edge){
+  (void)ctx;
+  if (!nirq_src) return 0;
+  if (evq_head == evq_tail) irq_generate(now_ms());
+  if (evq_head == evq_tail) return 0;
+  *pin = evq[evq_head % HAL_QUEUE].pin;
+  *edge = evq[evq_head % HAL_QUEUE].edge;
+  evq_head++;
+  printf("[HAL] event pin=%d edge=%s\n", *pin, *edge==EDGE_RISING ? "rising" : "falling");
+  return 1;
+}
+
+// Schläft bis zur nächsten Flanke statt zu pollen
+void mote_hal_event_wait(void*ctx,int timeout_ms){
+  (void)ctx;
+  double start = now_ms();
+  while (evq_head == evq_tail && nirq_src){
+    double now = now_ms();
+    irq_generate(now);
+    if (evq_head != evq_tail) break;
+    double next = irq_src[0].next_ms;
+    for (int i=1;i<nirq_src;i++) if (irq_src[i].next_ms < next) next = irq_src[i].next_ms;
+    if (timeout_ms >= 0 && start + timeout_ms < next) next = start + timeout_ms;
+    if (next > now) mote_hal_sleep_ms(NULL, (int)(next - now) + 1);
+    if (timeout_ms >= 0 && now_ms() >= start + timeout_ms) break;
+  }
+}
+
+// ---- Sample-Streams: ein Ringpuffer je Kanal, gefüllt wie per DMA ----
+// Quelle ist ein synthetisches Signal (Sinus je Kanal mit eigener Frequenz
+// plus Rauschen, 12 Bit, Periode HAL_ADC_PERIOD Werte) oder eine Replay-Datei
+// aus MOTE_ADC_REPLAY: Zeilen mit Ganzzahlen, Spalte k = Kanal k, begrenzt auf
+// 0..VM_ADC_MAX. Am Dateiende endet der Stream.
+#define HAL_ADC_CH     8
+#define HAL_ADC_RING   1024
+#define HAL_ADC_PERIOD 4096
+
+static struct { int32_t ring[HAL_ADC_RING]; unsigned head, tail; uint32_t k; } adc[HAL_ADC_CH];
+static int32_t adc_sine[HAL_ADC_PERIOD];
+static int32_t *replay[HAL_ADC_CH]; static uint32_t replay_len[HAL_ADC_CH];
+static int adc_mode = -1;        // -1 unbestimmt, 0 synthetisch, 1 Replay
+
+static void adc_replay_load(FILE *f){
+  uint32_t cap = 0;
+  char line[1024];
+  while (fgets(line, sizeof line, f)){
+    char *p = line, *e;
+    int col = 0;
+    for (long v = strtol(p, &e, 10); e != p && col < HAL_ADC_CH; v = strtol(p, &e, 10), col++){
+      if (replay_len[col] == cap || !replay[col]){
+        uint32_t nc = cap ? cap*2 : 4096;
+        for (int c=0;c<HAL_ADC_CH;c++) replay[c] = (int32_t*)realloc(replay[c], nc*sizeof(int32_t));
+        cap = nc;
+      }
+      replay[col][replay_len[col]++] = (int32_t)(v < 0 ? 0 : v > VM_ADC_MAX ? VM_ADC_MAX : v);   // Vertrag in hal.h
+      p = e;
+    }
+  }
+}
+
+static void adc_init(void){
+  const char *path = getenv("MOTE_ADC_REPLAY");
+  FILE *f = path ? fopen(path, "r") : NULL;
+  if (f){ adc_replay_load(f); fclose(f); adc_mode = 1; return; }
+  if (path) fprintf(stderr, "[HAL] %s nicht lesbar, synthetisches Signal\n", path);
+  // Sinustabelle per Drehung, ohne libm
+  double s = 0, c = 1, ds = 0.0015339801862847655, dc = 0.99999882345170188;   // 2*pi/4096
+  for (int i=0;i<HAL_ADC_PERIOD;i++){
+    adc_sine[i] = (int32_t)(s * 1500);
+    double t = s*dc + c*ds; c = c*dc - s*ds; s = t;
+  }
+  adc_mode = 0;
+}
+
+// Wert Nummer k von Kanal ch; periodisch, damit Messungen vergleichbar bleiben
+static int32_t adc_synth(int ch, uint32_t k){
+  uint32_t i = k % HAL_ADC_PERIOD;
+  uint32_t h = (i * 2654435761u) ^ ((uint32_t)ch * 0x9E3779B9u);
+  h ^= h >> 15; h *= 0x2C1B3C6Du; h ^= h >> 12;
+  return 2048 + adc_sine[(i * (uint32_t)(ch+1)) % HAL_ADC_PERIOD] + (int32_t)(h & 127) - 64;
+}
+
+// Ringpuffer auffüllen, soweit die Quelle Werte hat
+static void adc_pump(int ch){
+  while (adc[ch].tail - adc[ch].head < HAL_ADC_RING){
+    int32_t v;
+    if (adc_mode == 1){
+      if (adc[ch].k >= replay_len[ch]) break;
+      v = replay[ch][adc[ch].k];
+    } else v = adc_synth(ch, adc[ch].k);
+    adc[ch].k++;
+    adc[ch].ring[adc[ch].tail++ % HAL_ADC_RING] = v;
+  }
+}
+
+int mote_hal_adc_read(void*ctx,int ch,Val*dst,int n){
+  (void)ctx;
+  if (adc_mode < 0) adc_init();
+  if (ch < 0 || ch >= HAL_ADC_CH || n <= 0) return 0;
+  int got = 0;
+  while (got < n){
+    if (adc[ch].head == adc[ch].tail) adc_pump(ch);
+    unsigned avail = adc[ch].tail - adc[ch].head;
+    if (!avail) break;
+    // zusammenhängender Abschnitt bis zum Ringende
+    unsigned h = adc[ch].head % HAL_ADC_RING, run = HAL_ADC_RING - h;
+    if (run > avail) run = avail;
+    if (run > (unsigned)(n - got)) run = (unsigned)(n - got);
+    memcpy(dst + got, adc[ch].ring + h, run * sizeof(int32_t));
+    adc[ch].head += run; got += (int)run;
+  }
+  return got;
+}
+
 void* mote_bind_hal(){
-  static struct {
-    void(*gpio_mode)(void*,int,int);
-    void(*gpio_write)(void*,int,int);
-    void(*sleep_ms)(void*,int);
-    int (*gpio_read)(void*,int);              // NEU
-  } vtbl = { hal_gpio_mode, hal_gpio_write, hal_sleep_ms, hal_gpio_read };
+  static struct HAL vtbl = {
+    mote_hal_gpio_mode, mote_hal_gpio_write, mote_hal_sleep_ms, mote_hal_gpio_read,
+    mote_hal_print_int, mote_hal_gpio_mode_mask, mote_hal_gpio_write_mask, mote_hal_gpio_read_port,
+    mote_hal_irq_attach, mote_hal_event_poll, mote_hal_event_wait, mote_hal_adc_read };
   return &vtbl;
 }
@@ -0,0 +1,145 @@
+#include "image.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint16_t rd_u16(const uint8_t *p){ return (uint16_t)(p[0] | p[1]<<8); }
+static uint32_t rd_u32(const uint8_t *p){ return (uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24; }
+static void wr_u16(uint8_t *p, uint16_t v){ p[0]=(uint8_t)v; p[1]=(uint8_t)(v>>8); }
+static void wr_u32(uint8_t *p, uint32_t v){ for(int i=0;i<4;i++) p[i]=(uint8_t)(v>>(8*i)); }
+
+static void meta_decode(MoteMeta *m, const uint8_t *p, uint32_t len){
+    // Felder werden nur gelesen, wenn die Sektion lang genug ist (ältere Images)
+    if (len >= 2) m->nlocals = rd_u16(p);
+    if (len >= 6) m->mem = rd_u32(p+2);
+}
+
+int mote_image_parse(MoteImage *img, const uint8_t *data, size_t len){
+    memset(img, 0, sizeof(*img));
+    if (len < 4 || memcmp(data, "MOTE", 4) != 0){
+        img->code = data; img->code_len = len;   // rohes Image
+        return 0;
+    }
+    if (len < 8 || rd_u16(data+4) != MOTE_IMAGE_VERSION) return -1;
+    int n = rd_u16(data+6);
+    if (n > MOTE_MAX_SECTIONS) return -1;
+
+    size_t off = 8;
+    for (int i=0;i<n;i++){
+        if (off + 8 > len) return -1;
+        MoteSection *s = &img->sect[i];
+        memcpy(s->tag, data+off, 4);
+        s->len = rd_u32(data+off+4);
+        off += 8;
+        if (s->len > len - off) return -1;
+        s->data = data+off;
+        off += s->len;
+    }
+    img->nsect = n;
+
+    const MoteSection *code = mote_image_find(img, "CODE");
+    if (!code) return -1;
+    img->code = code->data; img->code_len = code->len;
+
+    const MoteSection *meta = mote_image_find(img, "META");
+    if (meta) meta_decode(&img->meta, meta->data, meta->len);
+    return 0;
+}
+
+const MoteSection *mote_image_find(const MoteImage *img, const char tag[4]){
+    for (int i=0;i<img->nsect;i++)
+        if (!memcmp(img->sect[i].tag, tag, 4)) return &img->sect[i];
+    return NULL;
+}
+
+uint8_t *mote_image_encode(const MoteSection *s, int n, size_t *out_len){
+    size_t len = 8;
+    for (int i=0;i<n;i++) len += 8 + s[i].len;
+    uint8_t *out = (uint8_t*)malloc(len);
+    if (!out) return NULL;
+    memcpy(out, "MOTE", 4);
+    wr_u16(out+4, MOTE_IMAGE_VERSION);
+    wr_u16(out+6, (uint16_t)n);
+    size_t off = 8;
+    for (int i=0;i<n;i++){
+        memcpy(out+off, s[i].tag, 4);
+        wr_u32(out+off+4, s[i].len);
+        if (s[i].len) memcpy(out+off+8, s[i].data, s[i].len);
+        off += 8 + s[i].len;
+    }
+    *out_len = len;
+    return out;
+}
+
+uint32_t mote_meta_encode(const MoteMeta *m, uint8_t *buf){
+    wr_u16(buf, m->nlocals);
+    wr_u32(buf+2, m->mem);
+    return MOTE_META_SIZE;
+}
+
+int mote_slots_decode(const MoteSection *s, MoteSlot **out){
+    int n = 0, cap = 0;
+    MoteSlot *v = NULL;
+    uint32_t off = 0, len = s ? s->len : 0;
+    while (off < len){
+        if (len - off < 2 || len - off - 2 < (uint32_t)s->data[off+1] + 8u){ free(v); *out = NULL; return -1; }
+        if (n == cap){ cap = cap ? cap*2 : 16; v = (MoteSlot*)realloc(v, cap*sizeof(MoteSlot)); }
+        MoteSlot *e = &v[n++];
+        uint8_t nl = s->data[off+1];
+        if (nl >= sizeof(e->name)) nl = sizeof(e->name)-1;
+        e->kind = s->data[off];
+        memcpy(e->name, s->data+off+2, nl); e->name[nl] = 0;
+        off += 2 + s->data[off+1];
+        e->at = rd_u32(s->data+off); e->len = rd_u32(s->data+off+4);
+        off += 8;
+    }
+    *out = v ? v : (MoteSlot*)malloc(sizeof(MoteSlot));
+    return n;
+}
+
+int mote_yields_decode(const MoteSection *s, MoteYield **out){
+    uint32_t len = s ? s->len : 0;
+    if (len % 8){ *out = NULL; return -1; }
+    int n = (int)(len / 8);
+    MoteYield *v = (MoteYield*)malloc((n ? n : 1)*sizeof(MoteYield));
+    for (int i=0;i<n;i++){ v[i].id = rd_u32(s->data+8*i); v[i].addr = rd_u32(s->data+8*i+4); }
+    *out = v;
+    return n;
+}
+
+int mote_loops_decode(const MoteSection *s, MoteLoop **out){
+    uint32_t len = s ? s->len : 0;
+    if (len % 8){ *out = NULL; return -1; }
+    int n = (int)(len / 8);
+    MoteLoop *v = (MoteLoop*)malloc((n ? n : 1)*sizeof(MoteLoop));
+    for (int i=0;i<n;i++){ v[i].addr = rd_u32(s->data+8*i); v[i].bound = rd_u32(s->data+8*i+4); }
+    *out = v;
+    return n;
+}
+
+uint8_t *mote_slots_encode(const MoteSlot *v, int n, uint32_t *out_len){
+    uint32_t len = 0;
+    for (int i=0;i<n;i++) len += 10 + (uint32_t)strlen(v[i].name);
+    uint8_t *out = (uint8_t*)malloc(len ? len : 1), *p = out;
+    for (int i=0;i<n;i++){
+        size_t nl = strlen(v[i].name);
+        p[0] = v[i].kind; p[1] = (uint8_t)nl;
+        memcpy(p+2, v[i].name, nl); p += 2 + nl;
+        wr_u32(p, v[i].at); wr_u32(p+4, v[i].len); p += 8;
+    }
+    *out_len = len;
+    return out;
+}
+
+uint8_t *mote_yields_encode(const MoteYield *v, int n, uint32_t *out_len){
+    uint8_t *out = (uint8_t*)malloc(n ? 8*(size_t)n : 1);
+    for (int i=0;i<n;i++){ wr_u32(out+8*i, v[i].id); wr_u32(out+8*i+4, v[i].addr); }
+    *out_len = 8*(uint32_t)n;
+    return out;
+}
+
+uint8_t *mote_loops_encode(const MoteLoop *v, int n, uint32_t *out_len){
+    uint8_t *out = (uint8_t*)malloc(n ? 8*(size_t)n : 1);
+    for (int i=0;i<n;i++){ wr_u32(out+8*i, v[i].addr); wr_u32(out+8*i+4, v[i].bound); }
+    *out_len = 8*(uint32_t)n;
+    return out;
+}
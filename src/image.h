@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Mote-Image-Format
+//
+//   Offset  Größe
+//   0       4     Magic "MOTE"
+//   4       2     Version (MOTE_IMAGE_VERSION)
+//   6       2     Anzahl Sektionen
+//   8       ...   je Sektion: 4 Byte Tag, u32 Länge, Nutzdaten
+//
+// Sektionen (little endian):
+//   "META"  u16 nlocals   – benötigte Locals-Slots
+//           u32 mem       – Worte linearer Speicher (Arrays)
+//   "CODE"  Bytecode
+//   "SLOT"  Zustand für den Austausch im Betrieb (vm_swap.h), je Eintrag:
+//           u8 Art (MOTE_SLOT_*), u8 Namenslänge, Name, u32 Slot bzw. Basis,
+//           u32 Länge in Worten
+//   "YELD"  Yield-Stellen im Hauptprogramm, je Eintrag u32 id, u32 Adresse
+//           direkt hinter dem CALL yield (Code-Referenz: mote-opt passt sie an)
+//   "LOOP"  Schleifenschranken aus dem Quelltext (while/for ... bound N), je
+//           Eintrag u32 Adresse des Schleifenkopfs (Ziel des Rücksprungs),
+//           u32 höchste Anzahl Durchläufe je Eintritt (Code-Referenz wie YELD)
+//
+// Images ohne Header (z. B. aus asm_min.py) bestehen nur aus Bytecode und
+// werden weiterhin akzeptiert: 'M' (0x4D) ist kein gültiger Opcode.
+
+#define MOTE_IMAGE_VERSION 1
+#define MOTE_MAX_SECTIONS  16
+
+typedef struct {
+    char tag[4];
+    const uint8_t *data;
+    uint32_t len;
+} MoteSection;
+
+typedef struct {
+    uint16_t nlocals;      // 0 = unbekannt (kein META)
+    uint32_t mem;          // Worte linearer Speicher, 0 = keiner
+} MoteMeta;
+
+typedef struct {
+    MoteSection sect[MOTE_MAX_SECTIONS];
+    int nsect;             // 0 bei Images ohne Header
+    const uint8_t *code;
+    size_t code_len;
+    MoteMeta meta;
+} MoteImage;
+
+// Zerlegt ein Image; die Sektionen zeigen in den übergebenen Puffer.
+// Rückgabe 0 bei Erfolg, -1 bei defektem Header.
+int mote_image_parse(MoteImage *img, const uint8_t *data, size_t len);
+
+// Sucht eine Sektion, NULL wenn nicht vorhanden
+const MoteSection *mote_image_find(const MoteImage *img, const char tag[4]);
+
+// Serialisiert Sektionen in einen neuen Puffer (free() durch Aufrufer)
+uint8_t *mote_image_encode(const MoteSection *s, int n, size_t *out_len);
+
+// Einträge von SLOT und YELD
+enum { MOTE_SLOT_LOCAL=0, MOTE_SLOT_ARRAY=1 };
+typedef struct { uint8_t kind; char name[64]; uint32_t at, len; } MoteSlot;
+typedef struct { uint32_t id, addr; } MoteYield;
+typedef struct { uint32_t addr, bound; } MoteLoop;
+
+// Zerlegen in ein neues Feld (free() durch Aufrufer, auch bei 0 Einträgen);
+// Rückgabe Anzahl, -1 bei defekter Sektion. s == NULL ergibt 0 Einträge.
+int mote_slots_decode(const MoteSection *s, MoteSlot **out);
+int mote_yields_decode(const MoteSection *s, MoteYield **out);
+int mote_loops_decode(const MoteSection *s, MoteLoop **out);
+
+// Nutzdaten erzeugen (free() durch Aufrufer)
+uint8_t *mote_slots_encode(const MoteSlot *v, int n, uint32_t *out_len);
+uint8_t *mote_yields_encode(const MoteYield *v, int n, uint32_t *out_len);
+uint8_t *mote_loops_encode(const MoteLoop *v, int n, uint32_t *out_len);
+
+// META-Nutzdaten erzeugen; buf muss mindestens MOTE_META_SIZE Bytes haben
+#define MOTE_META_SIZE 6
+uint32_t mote_meta_encode(const MoteMeta *m, uint8_t *buf);
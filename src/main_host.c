@@ -1,27 +1,58 @@
 #include "vm.h"
+#include "hal.h"
+#include "vm_swap.h"
+#include "vm_tos.h"
 #include <stdio.h>
 #include <stdlib.h>
-
-extern void* mote_bind_hal();
+#include <string.h>
 
 int main(int argc, char**argv){
-  if (argc!=2){ fprintf(stderr,"Usage: %s program.bin\n", argv[0]); return 1; }
-  FILE*f=fopen(argv[1],"rb"); if(!f){perror("open"); return 1;}
+  // --tos: Interpreter mit Top-of-Stack im Register (vm_tos.h), gleiche Ergebnisse
+  int swap = 0, a = 1;
+  VmRes (*run)(VM*) = vm_run;
+  for (; a < argc-1; a++){
+    if (!strcmp(argv[a],"--swap")) swap = 1;
+    else if (!strcmp(argv[a],"--tos")) run = vm_run_tos;
+    else break;
+  }
+  if (a != argc-1){ fprintf(stderr,"Usage: %s [--swap] [--tos] program.bin\n", argv[0]); return 1; }
+  const char *path = argv[a];
+  FILE*f=fopen(path,"rb"); if(!f){perror("open"); return 1;}
   fseek(f,0,SEEK_END); long n=ftell(f); fseek(f,0,SEEK_SET);
   uint8_t*code=(uint8_t*)malloc(n); fread(code,1,n,f); fclose(f);
 
-  Val stack[256]={0};
-  Val locals[8]={0};
+  // Stack- und Call-Tiefe aus der Ladezeit-Analyse (sonst 256 wie bisher),
+  // Locals und linearer Speicher aus dem META-Eintrag; rohe Images bekommen
+  // den vollen 8-Bit-Indexraum und keinen linearen Speicher (vm_swap.c)
+  VM vm; char err[160];
+  VmSwap *S = vm_swap_open(&vm, code, (size_t)n, mote_bind_hal(), err, sizeof err);
+  if (!S){ fprintf(stderr,"%s: %s\n", path, err); return 1; }
 
-  VM vm = {
-    .code=code, .code_len=(size_t)n, .ip=0,
-    .stack=stack, .sp=0, .stack_cap=256,
-    .locals=locals, .locals_cap=8,
-    .hal=mote_bind_hal()
-  };
+  // --swap: Änderungen an der Datei im Hintergrund laden und an einem yield() einsetzen
+  if (swap){
+    const char *e = getenv("MOTE_SWAP_POLL_MS");
+    if (vm_swap_watch(S, path, e ? atoi(e) : 200) != 0) fprintf(stderr,"%s: Überwachung nicht möglich\n", path);
+  }
 
-  VmRes r = vm_run(&vm);
-  printf("VM exit: %s, sp=%zu\n", r==VM_OK?"OK":"TRAP", vm.sp);
-  free(code);
+  VmSwapStats st;
+  VmRes r = run(&vm);
+  for (;;){
+    if (r == VM_WAIT) vm_wait_event(&vm, -1);   // wait_event(): ohne CPU-Last auf das nächste Ereignis warten
+    else if (r == VM_YIELD){
+      if (vm_swap_apply(S, &vm) > 0){
+        vm_swap_stats(S, &st);
+        fprintf(stderr,"[swap] eingesetzt an yield %u, Pause %.1f us (max %.1f us)\n",
+                st.yield_id, st.pause_last_ns*1e-3, st.pause_max_ns*1e-3);
+      }
+    }
+    else break;
+    r = run(&vm);
+  }
+  printf("VM exit: %s, sp=%u\n", r==VM_OK?"OK":"TRAP", vm.sp);
+  vm_swap_stats(S, &st);
+  if (st.swaps)
+    printf("Hot-Swap: %u getauscht, Pause max %.1f us, Mittel %.1f us\n",
+           st.swaps, st.pause_max_ns*1e-3, st.pause_sum_ns*1e-3/st.swaps);
+  vm_swap_close(S);
   return r==VM_OK?0:2;
 }
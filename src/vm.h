@@ -12,27 +12,81 @@ typedef enum {
     OP_DUP, OP_DROP, OP_SWAP, OP_OVER,
     OP_GT, OP_GE, OP_LE, OP_NE,
     OP_NOT, OP_AND, OP_OR, OP_CALLUSER=24,
-    OP_RET=25
+    OP_RET=25,
+    // Linearer Speicher: LOADM (addr -- wert), STOREM (addr wert --), außerhalb -> Trap
+    OP_LOADM=26, OP_STOREM=27,
+    // Ganzzahl: MOD (Divisor 0 -> Trap), Schiebeweite modulo 32, SHR arithmetisch
+    OP_MOD=28, OP_SHL=29, OP_SHR=30, OP_BAND=31, OP_BOR=32, OP_BXOR=33,
+    // Q16.16 mit Sättigung (FDIV durch 0 sättigt nach dem Vorzeichen des Dividenden)
+    OP_FMUL=34, OP_FDIV=35,
+    // 64 Bit als Slot-Paar (lo hi): (a_lo a_hi b_lo b_hi -- r_lo r_hi), modulo 2^64
+    OP_ADD64=36, OP_MUL64=37
 } Op;
 
-typedef struct {
-  const uint8_t *code; 
-  size_t code_len; 
-  size_t ip;
+// Native-Indizes für OP_CALL (motec_core.h führt dieselbe Liste)
+typedef enum {
+    NAT_GPIO_MODE=0, NAT_GPIO_WRITE=1, NAT_SLEEP_MS=2, NAT_GPIO_READ=3,
+    NAT_PRINT_INT=4,
+    // Port-weite GPIO: ein Port umfasst 32 Pins (pin = port*32 + bit)
+    NAT_GPIO_MODE_MASK=5, NAT_GPIO_WRITE_MASK=6, NAT_GPIO_READ_PORT=7,
+    // Interrupts: Handler für eine Pin-Flanke registrieren, auf Ereignis warten
+    NAT_GPIO_ON_EDGE=8, NAT_WAIT_EVENT=9,
+    // Blockoperationen auf dem linearen Speicher (Adressen und Längen in Worten)
+    NAT_MEM_FILL=10, NAT_MEM_COPY=11, NAT_MEM_SUM=12, NAT_MEM_MAX=13,
+    // Sample-Streams der HAL (adc_read): Filter laufen nativ über ganze Blöcke
+    NAT_ADC_SAMPLE=14, NAT_ADC_READ=15, NAT_ADC_BLOCK_AVG=16, NAT_COUNT_ABOVE=17,
+    NAT_FIR_APPLY=18,
+    // Sichere Stelle für den Austausch des Programms (vm_swap.h)
+    NAT_YIELD=19
+} Native;
 
-  Val *stack; 
-  size_t sp; 
-  size_t stack_cap;
+// Flanken für gpio_on_edge (Bitmaske)
+enum { EDGE_RISING=1, EDGE_FALLING=2, EDGE_BOTH=3 };
 
-  Val *locals; 
-  size_t locals_cap;
+#define VM_MAX_IRQ 8
 
-  void *hal;
+// Wertebereich der Samples: ADC_CHUNK Werte summieren sich ohne int32-Überlauf
+#define VM_ADC_MAX 65535
 
-  size_t callstack[256]; // Call-Stack für Rücksprungadressen
-  size_t csp;            // Call-Stack-Pointer
-} VM;
+// Sample-Streams: Kanal ch liefert fortlaufend Messwerte (ADC-Rohwerte
+// 0..VM_ADC_MAX) aus einem Ringpuffer der HAL. Endet ein Stream (Replay-Datei), wird
+// über die tatsächlich gelesenen Werte gerechnet.
+//   adc_sample(ch)                    nächster Wert, 0 am Ende
+//   adc_read(ch, dst, n)              nächste n Werte nach mem[dst..], Rückgabe Anzahl
+//   adc_block_avg(ch, n)              Mittelwert der nächsten n Werte
+//   count_above(ch, n, schwelle)      wie viele der nächsten n Werte > schwelle
+//   fir_apply(ch, n, coef, taps, dst) FIR über die nächsten n Werte nach mem[dst..],
+//       Rückgabe Anzahl. mem[coef..coef+taps) sind Q15-Koeffizienten, dahinter
+//       taps-1 Worte Verlauf (anfangs 0, älterer Wert zuerst), den der Aufruf
+//       fortschreibt: y[i] = (sum c[k]*x[i-k]) >> 15, Summe modulo 2^32.
+#define VM_FIR_TAPS 64
+
+typedef struct { int16_t pin; uint8_t edge; uint32_t addr; } VmIrq;
 
+// Zustand einer Instanz. Heiße Felder (jede Instruktion) liegen vorne in
+// einer Cache-Zeile, selten benutzte dahinter. Stack, Locals und Call-Stack
+// gehören dem Aufrufer und werden nach dem Bedarf des Programms bemessen
+// (vm_analyze.h); vm_pool.h legt viele Instanzen kompakt in Slabs an.
+typedef struct {
+  // heiß
+  uint32_t ip, sp, csp;
+  uint8_t nirq, in_irq;
+  const uint8_t *code;
+  Val *stack;
+  Val *locals;
+  uint32_t *callstack;   // Rücksprungadressen als Code-Offsets (Bit 31: Interrupt-Rahmen)
+  Val *mem;              // linearer Speicher (Arrays), Größe aus dem META-Eintrag
+
+  // kalt
+  uint32_t code_len, stack_cap, locals_cap, call_cap, mem_cap;
+  void *hal;
+  VmIrq *irq;            // VM_MAX_IRQ Einträge für gpio_on_edge; NULL = keine Interrupts
+} VM;
 
-typedef enum { VM_OK=0, VM_TRAP=1 } VmRes;
+// VM_WAIT: wait_event() ohne anstehendes Ereignis. Der Host wartet per
+// vm_wait_event() ohne CPU-Last und setzt danach mit vm_run() fort.
+// VM_YIELD: yield(id) wurde ausgeführt (ip steht dahinter). Der Host kann
+// hier ein neues Image einsetzen (vm_swap_apply) und setzt mit vm_run() fort.
+typedef enum { VM_OK=0, VM_TRAP=1, VM_WAIT=2, VM_YIELD=3 } VmRes;
 VmRes vm_run(VM *vm);
+void vm_wait_event(VM *vm, int timeout_ms);   // timeout_ms < 0: unbegrenzt
@@ -0,0 +1,242 @@
+// vm_analyze.c – Stack- und Call-Tiefe eines Programms (siehe vm_analyze.h)
+#include <stdlib.h>
+#include <string.h>
+#include "vm_analyze.h"
+#include "vm_ops.h"
+
+#define UNSEEN INT32_MIN
+
+typedef struct {
+    int state;                 // 0 neu, 1 in Arbeit, 2 fertig
+    uint32_t entry;
+    int32_t min, max, net;     // relativ zur Tiefe beim Aufruf
+    uint32_t calls;            // Call-Tiefe inklusive eigenem Rahmen der Aufrufe darin
+} Fn;
+
+typedef struct {
+    const uint8_t *code;
+    size_t len;
+    uint8_t *insn;             // 1 = Instruktionsanfang (lineare Dekodierung)
+    int *fidx;                 // Adresse -> Index in fn, -1
+    Fn *fn; int nfn;
+    uint32_t *handlers; int nhandlers;
+    uint8_t *is_handler;       // Adresse schon in handlers
+    int bad_handler;           // Handler-Adresse außerhalb des Codes
+    int32_t *d;                // Tiefe je Adresse im laufenden Durchlauf, UNSEEN
+    uint32_t *work;            // besuchte Adressen des Durchlaufs, danach zurückgesetzt
+    int nest;                  // verschachtelte Callee-Analysen
+} An;
+
+static int32_t rd_i32(const uint8_t *p){ int32_t v; memcpy(&v,p,4); return v; }
+
+static int fn_get(An *A, uint32_t entry){
+    if (entry >= A->len || !A->insn[entry]) return -1;
+    if (A->fidx[entry] < 0){
+        A->fidx[entry] = A->nfn;
+        Fn *f = &A->fn[A->nfn++];
+        memset(f, 0, sizeof(*f));
+        f->entry = entry; f->net = UNSEEN;
+    }
+    return A->fidx[entry];
+}
+
+// Alle von entry aus erreichbaren CALLUSER-Ziele (mit Wiederholungen), malloc;
+// d/work werden benutzt und zurückgesetzt. -1 bei Speichermangel.
+static int callees(An *A, uint32_t entry, uint32_t **out){
+    int32_t *d = A->d; uint32_t *work = A->work;
+    size_t wn = 0, rd = 0; int nc = 0;
+    d[entry] = 0; work[wn++] = entry;
+    while (rd < wn){
+        uint32_t pc = work[rd++];
+        uint8_t op = A->code[pc];
+        int ol = vm_op_operand_len(op);
+        if (ol < 0 || pc + 1 + (size_t)ol > A->len) continue;
+        int32_t arg = ol == 4 ? rd_i32(A->code+pc+1) : 0;
+        uint32_t succ[2]; int ns = 0;
+        if (op == OP_CALLUSER) nc++;
+        if (op == OP_JMP || op == OP_JZ) succ[ns++] = (uint32_t)arg;
+        if (op != OP_JMP && op != OP_HALT && op != OP_RET) succ[ns++] = pc + 1 + ol;
+        for (int k=0; k<ns; k++)
+            if (succ[k] < A->len && A->insn[succ[k]] && d[succ[k]] == UNSEEN){ d[succ[k]] = 0; work[wn++] = succ[k]; }
+    }
+    *out = (uint32_t*)malloc((nc ? nc : 1) * sizeof(uint32_t));
+    nc = 0;
+    for (size_t i=0; i<wn; i++){
+        uint32_t pc = work[i];
+        if (*out && A->code[pc] == OP_CALLUSER && pc + 5 <= A->len) (*out)[nc++] = (uint32_t)rd_i32(A->code+pc+1);
+        d[pc] = UNSEEN;
+    }
+    return *out ? nc : -1;
+}
+
+// Durchläuft eine Funktion mit relativer Tiefe; 0 ok, -1 nicht bestimmbar.
+// Erst die Callees (verschachtelt, höchstens VM_DEFAULT_CALLS tief – tiefer
+// trapt die VM ohnehin), dann der eigene Durchlauf ohne Verschachtelung, sodass
+// d und work nur einmal im An existieren.
+static int analyze_fn(An *A, int id){
+    Fn *f = &A->fn[id];
+    if (f->state == 2) return 0;
+    if (f->state == 1) return -1;              // Rekursion
+    if (A->nest >= VM_DEFAULT_CALLS) return -1;
+    f->state = 1;
+
+    uint32_t *cs; int nc = callees(A, f->entry, &cs), ok = nc >= 0;
+    A->nest++;
+    for (int k=0; k<nc && ok; k++){
+        int c = fn_get(A, cs[k]);
+        if (c < 0 || analyze_fn(A, c) < 0) ok = 0;
+    }
+    A->nest--;
+    free(cs);
+    if (!ok){ f->state = 2; f->net = UNSEEN; return -1; }
+
+    int32_t *d = A->d; uint32_t *work = A->work;
+    size_t wn = 0, rd = 0;
+    int32_t min = 0, max = 0, net = UNSEEN; uint32_t calls = 0;
+    d[f->entry] = 0; work[wn++] = f->entry;
+
+    while (rd < wn && ok){
+        uint32_t pc = work[rd++];
+        int32_t depth = d[pc];
+        uint8_t op = A->code[pc];
+        int ol = vm_op_operand_len(op);
+        if (ol < 0 || pc + 1 + (size_t)ol > A->len){ ok = 0; break; }
+        int32_t arg = ol == 4 ? rd_i32(A->code+pc+1) : ol == 1 ? A->code[pc+1] : 0;
+        uint32_t succ[2]; int ns = 0;
+        uint32_t next = pc + 1 + ol;
+
+        switch (op){
+            case OP_HALT: break;
+            case OP_RET:
+                if (net != UNSEEN && net != depth) ok = 0;
+                net = depth;
+                break;
+            case OP_JMP: succ[ns++] = (uint32_t)arg; break;
+            case OP_CALLUSER: {
+                int c = fn_get(A, (uint32_t)arg);
+                if (c < 0 || analyze_fn(A, c) < 0){ ok = 0; break; }
+                const Fn *g = &A->fn[c];
+                if (g->net == UNSEEN){ ok = 0; break; }   // kehrt nie zurück: kein Fortsetzungspfad bekannt
+                if (depth + g->min < min) min = depth + g->min;
+                if (depth + g->max > max) max = depth + g->max;
+                if (1 + g->calls > calls) calls = 1 + g->calls;
+                depth += g->net;
+                succ[ns++] = next;
+            } break;
+            default: {
+                int pop, push;
+                if (vm_op_stack_effect(op, arg, &pop, &push) < 0){ ok = 0; break; }
+                if (op == OP_CALL && arg == NAT_GPIO_ON_EDGE){
+                    // Handler-Adresse muss als PUSHI direkt davor stehen
+                    if (pc < 5 || !A->insn[pc-5] || A->code[pc-5] != OP_PUSHI){ ok = 0; break; }
+                    uint32_t h = (uint32_t)rd_i32(A->code+pc-4);
+                    // geteilter Code registriert dieselbe Adresse mehrfach: nur einmal eintragen
+                    if (h >= A->len) A->bad_handler = 1;
+                    else if (!A->is_handler[h]){
+                        if ((size_t)A->nhandlers >= A->len){ ok = 0; break; }
+                        A->is_handler[h] = 1; A->handlers[A->nhandlers++] = h;
+                    }
+                }
+                depth -= pop;
+                if (depth < min) min = depth;
+                depth += push;
+                if (depth > max) max = depth;
+                if (op == OP_JZ) succ[ns++] = (uint32_t)arg;
+                succ[ns++] = next;
+            } break;
+        }
+        for (int k=0; k<ns && ok; k++){
+            uint32_t s = succ[k];
+            if (s >= A->len) continue;            // Sprung ans Codeende: Trap, kein Stackbedarf
+            if (!A->insn[s]){ ok = 0; break; }
+            if (d[s] == UNSEEN){ d[s] = depth; work[wn++] = s; }
+            else if (d[s] != depth) ok = 0;       // uneinheitliche Tiefe (auch wachsende Schleifen)
+        }
+    }
+    for (size_t i=0; i<wn; i++) d[work[i]] = UNSEEN;   // nur Besuchtes zurücksetzen
+    f->min = min; f->max = max; f->net = net; f->calls = calls;
+    f->state = 2;
+    return ok ? 0 : -1;
+}
+
+// Instruktionsanfänge markieren (lineare Dekodierung); 0 ok, -1 ungültiger Opcode
+// oder Speichermangel (an_free räumt in beiden Fällen auf)
+static int an_init(An *A, const uint8_t *code, size_t len, uint32_t *locals_max){
+    memset(A, 0, sizeof(*A));
+    A->code = code; A->len = len;
+    A->insn = (uint8_t*)calloc(len, 1);
+    A->is_handler = (uint8_t*)calloc(len, 1);
+    A->fidx = (int*)malloc(len * sizeof(int));
+    A->fn = (Fn*)malloc(len * sizeof(Fn));
+    A->handlers = (uint32_t*)malloc(len * sizeof(uint32_t));
+    A->d = (int32_t*)malloc(len * sizeof(int32_t));
+    A->work = (uint32_t*)malloc(len * sizeof(uint32_t));
+    if (!A->insn || !A->is_handler || !A->fidx || !A->fn || !A->handlers || !A->d || !A->work) return -1;
+    for (size_t i=0;i<len;i++){ A->fidx[i] = -1; A->d[i] = UNSEEN; }
+
+    for (size_t ip=0; ip<len; ){
+        int ol = vm_op_operand_len(code[ip]);
+        if (ol < 0) return -1;
+        A->insn[ip] = 1;
+        if ((code[ip] == OP_LOADL || code[ip] == OP_STOREL) && ip+1 < len && code[ip+1]+1u > *locals_max)
+            *locals_max = code[ip+1]+1u;
+        ip += 1 + ol;
+    }
+    return 0;
+}
+
+static void an_free(An *A){
+    free(A->insn); free(A->is_handler); free(A->fidx); free(A->fn); free(A->handlers); free(A->d); free(A->work);
+}
+
+int vm_analyze(const uint8_t *code, size_t len, VmNeeds *out){
+    out->stack_max = VM_DEFAULT_STACK;
+    out->call_max = VM_DEFAULT_CALLS;
+    out->locals_max = 0;
+    out->irq = 1;
+    out->mem_words = 0;
+    if (!len) return -1;
+
+    An A;
+    int ok = an_init(&A, code, len, &out->locals_max) == 0;
+
+    if (ok){
+        int top = fn_get(&A, 0);
+        ok = top >= 0 && analyze_fn(&A, top) == 0 && A.fn[top].min >= 0 && !A.bad_handler;
+        if (ok){
+            uint32_t stack = (uint32_t)A.fn[top].max, calls = A.fn[top].calls;
+            // Handler laufen nie verschachtelt: der teuerste kommt einmal oben drauf
+            uint32_t hs = 0, hc = 0;
+            for (int k=0; k<A.nhandlers && ok; k++){
+                int h = fn_get(&A, A.handlers[k]);
+                if (h < 0 || analyze_fn(&A, h) < 0 || A.fn[h].min < -1){ ok = 0; break; }
+                uint32_t s = 1 + (uint32_t)(A.fn[h].max > 0 ? A.fn[h].max : 0);   // Pin-Parameter
+                if (s > hs) hs = s;
+                if (1 + A.fn[h].calls > hc) hc = 1 + A.fn[h].calls;
+            }
+            if (ok){ out->stack_max = stack + hs; out->call_max = calls + hc; out->irq = A.nhandlers > 0; }
+        }
+    }
+    an_free(&A);
+    if (!ok) out->locals_max = 256;           // voller 8-Bit-Indexraum
+    return ok ? 0 : -1;
+}
+
+int vm_analyze_fn(const uint8_t *code, size_t len, uint32_t entry, VmFnNeeds *out){
+    out->stack_max = VM_DEFAULT_STACK;
+    out->call_max = VM_DEFAULT_CALLS;
+    if (!len) return -1;
+
+    An A; uint32_t locals = 0;
+    int ok = an_init(&A, code, len, &locals) == 0;
+    if (ok){
+        int f = fn_get(&A, entry);
+        ok = f >= 0 && analyze_fn(&A, f) == 0;
+        if (ok){
+            out->stack_max = (uint32_t)(A.fn[f].max > 0 ? A.fn[f].max : 0);
+            out->call_max = A.fn[f].calls;
+        }
+    }
+    an_free(&A);
+    return ok ? 0 : -1;
+}
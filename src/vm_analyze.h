@@ -0,0 +1,40 @@
+#pragma once
+#include "vm.h"
+
+// Ladezeit-Analyse: wie viel Operanden-Stack und Call-Stack braucht ein
+// Programm höchstens? Damit werden Instanzen passend statt pauschal mit
+// 256 Einträgen angelegt.
+//
+// Jede Funktion (CALLUSER-Ziel, Interrupt-Handler) wird einmal mit relativer
+// Stacktiefe durchlaufen; ein Aufruf kostet am Aufrufort Tiefe + Maximum des
+// Callee. Interrupt-Handler können an jedem sicheren Punkt einspringen und
+// werden auf das Maximum des Hauptprogramms aufgeschlagen.
+//
+// Nicht bestimmbar (Rückgabe -1) sind Rekursion, Schleifen mit wachsendem
+// Stack, uneinheitliche Tiefe an Verzweigungen, Handler-Adressen, die nicht
+// als Konstante vor gpio_on_edge stehen, Aufrufketten tiefer als
+// VM_DEFAULT_CALLS sowie Stack-Unterlauf. Der Aufrufer fällt dann auf
+// VM_DEFAULT_* zurück; out ist in jedem Fall befüllt.
+
+#define VM_DEFAULT_STACK 256
+#define VM_DEFAULT_CALLS 256
+
+typedef struct {
+    uint32_t stack_max;    // höchste Operanden-Stacktiefe
+    uint32_t call_max;     // höchste Call-Stacktiefe (inklusive Interrupt-Rahmen)
+    uint32_t locals_max;   // höchster LOADL/STOREL-Index + 1
+    uint8_t irq;           // Programm registriert Interrupt-Handler (im Zweifel 1)
+    uint32_t mem_words;    // linearer Speicher; steht im META-Eintrag, nicht im Code (hier 0)
+} VmNeeds;
+
+int vm_analyze(const uint8_t *code, size_t len, VmNeeds *out);
+
+// Dasselbe für eine einzelne Funktion ab entry (Hauptprogramm: 0), ohne
+// Interrupt-Handler: Stacktiefe über der beim Aufruf, Call-Tiefe der Aufrufe
+// darin (ohne den eigenen Rahmen). -1 wie oben, out dann auf VM_DEFAULT_*.
+typedef struct {
+    uint32_t stack_max;
+    uint32_t call_max;
+} VmFnNeeds;
+
+int vm_analyze_fn(const uint8_t *code, size_t len, uint32_t entry, VmFnNeeds *out);
@@ -0,0 +1,441 @@
+// vm_batch.c – Gleichschritt-Interpreter über viele Instanzen (siehe vm_batch.h)
+#include <stdlib.h>
+#include <string.h>
+#include "vm_batch.h"
+#include "hal.h"
+#include "vm_ops.h"
+
+#define ROW(base, i) ((base) + (size_t)(i)*B->width)
+
+static int32_t rd_i32(const uint8_t *p){ int32_t v; memcpy(&v, p, 4); return v; }
+
+int vm_batch_init(VmBatch *B, const uint8_t *code, size_t code_len, size_t lanes,
+                  size_t stack_cap, size_t locals_cap, size_t mem_cap){
+    memset(B, 0, sizeof(*B));
+    size_t W = (lanes + VSIMD_WIDTH-1) / VSIMD_WIDTH * VSIMD_WIDTH;
+    if (!W) W = VSIMD_WIDTH;
+    size_t rows = stack_cap + locals_cap + mem_cap + VM_BATCH_CALLS + 4;
+    size_t bytes = 32 + rows*W*sizeof(Val) + 3*W*sizeof(uint32_t) + W + W*sizeof(void*);
+    uint8_t *m = (uint8_t*)calloc(1, bytes);
+    if (!m) return -1;
+    B->alloc = m;
+    Val *r = (Val*)(((uintptr_t)m + 31) & ~(uintptr_t)31);   // Zeilen 32-Byte-ausgerichtet
+    B->stack = r;      r += stack_cap*W;
+    B->locals = r;     r += locals_cap*W;
+    B->mem = r;        r += mem_cap*W;
+    B->callstack = r;  r += VM_BATCH_CALLS*W;
+    B->act = r;   r += W;
+    B->gmask = r; r += W;
+    B->zmask = r; r += W;
+    B->tmp = r;   r += W;
+    B->ip  = (uint32_t*)r;
+    B->sp  = B->ip + W;
+    B->csp = B->sp + W;
+    B->status = (int8_t*)(B->csp + W);
+    B->hal = (void**)calloc(W, sizeof(void*));
+    if (!B->hal){ free(m); return -1; }
+
+    B->code = code; B->code_len = code_len;
+    B->lanes = lanes; B->width = W;
+    B->stack_cap = stack_cap; B->locals_cap = locals_cap; B->mem_cap = mem_cap;
+    B->ops = vsimd_ops();
+    for (size_t l=0; l<W; l++){
+        B->status[l] = l < lanes ? -1 : VM_OK;
+        B->act[l] = l < lanes ? -1 : 0;
+    }
+    return 0;
+}
+
+void vm_batch_free(VmBatch *B){
+    free(B->alloc); free(B->hal);
+    memset(B, 0, sizeof(*B));
+}
+
+static void lane_finish(VmBatch *B, size_t l, VmRes r){ B->status[l] = (int8_t)r; B->act[l] = 0; }
+
+static inline int mem_range(const VmBatch *B, uint32_t a, uint32_t n){
+    return a <= B->mem_cap && n <= B->mem_cap - a;
+}
+
+static Val alu(Op op, Val a, Val b){
+    switch (op){
+        case OP_ADD: return (Val)((uint32_t)a + (uint32_t)b);
+        case OP_SUB: return (Val)((uint32_t)a - (uint32_t)b);
+        case OP_MUL: return (Val)((uint32_t)a * (uint32_t)b);
+        case OP_LT:  return a <  b;
+        case OP_EQ:  return a == b;
+        case OP_GT:  return a >  b;
+        case OP_GE:  return a >= b;
+        case OP_LE:  return a <= b;
+        case OP_NE:  return a != b;
+        case OP_AND: return a != 0 && b != 0;
+        case OP_OR:  return a != 0 || b != 0;
+        case OP_BAND: return a & b;
+        case OP_BOR:  return a | b;
+        case OP_BXOR: return a ^ b;
+        case OP_SHL:  return vm_shl(a, b);
+        case OP_SHR:  return vm_shr(a, b);
+        case OP_FMUL: return vm_fmul(a, b);
+        case OP_FDIV: return vm_fdiv(a, b);
+        default:     return 0;
+    }
+}
+
+// Eine Instruktion für eine einzelne Lane, Semantik wie vm_run()
+static void lane_step(VmBatch *B, size_t l){
+    const uint8_t *c = B->code; size_t len = B->code_len, W = B->width;
+    struct HAL *H = (struct HAL*)B->hal[l];
+    uint32_t ip = B->ip[l];
+#define LPOP()   (B->sp[l] ? B->stack[(size_t)(--B->sp[l])*W + l] : 0)
+#define LPUSH(v) do { Val v_ = (v); if (B->sp[l] < B->stack_cap) B->stack[(size_t)(B->sp[l]++)*W + l] = v_; } while (0)
+#define LFETCH() (ip < len ? c[ip++] : 0)
+#define TRAP()   do { B->ip[l] = ip; lane_finish(B, l, VM_TRAP); return; } while (0)
+
+    if (ip >= len) TRAP();
+    Op op = (Op)c[ip++];
+    switch (op){
+        case OP_HALT: B->ip[l] = ip; lane_finish(B, l, VM_OK); return;
+
+        case OP_PUSHI:
+            if (ip + 4 > len) TRAP();
+            LPUSH(rd_i32(c+ip)); ip += 4;
+            break;
+        case OP_LOADL: {
+            uint8_t idx = LFETCH();
+            if (idx >= B->locals_cap) TRAP();
+            LPUSH(B->locals[(size_t)idx*W + l]);
+        } break;
+        case OP_STOREL: {
+            uint8_t idx = LFETCH();
+            if (idx >= B->locals_cap) TRAP();
+            B->locals[(size_t)idx*W + l] = LPOP();
+        } break;
+
+        case OP_ADD: case OP_SUB: case OP_MUL:
+        case OP_LT: case OP_EQ: case OP_GT: case OP_GE: case OP_LE: case OP_NE:
+        case OP_AND: case OP_OR:
+        case OP_BAND: case OP_BOR: case OP_BXOR: case OP_SHL: case OP_SHR:
+        case OP_FMUL: case OP_FDIV: { Val b = LPOP(), a = LPOP(); LPUSH(alu(op, a, b)); } break;
+        case OP_DIV: { Val b = LPOP(), a = LPOP(); if (b == 0) TRAP(); LPUSH(a/b); } break;
+        case OP_MOD: { Val b = LPOP(), a = LPOP(); if (b == 0) TRAP(); LPUSH(vm_mod(a, b)); } break;
+        case OP_ADD64: case OP_MUL64: {
+            Val bh = LPOP(), bl = LPOP(), ah = LPOP(), al = LPOP();
+            uint64_t x = vm_pair(al, ah), y = vm_pair(bl, bh);
+            uint64_t r = op == OP_ADD64 ? x + y : x * y;
+            LPUSH((Val)(uint32_t)r); LPUSH((Val)(uint32_t)(r >> 32));
+        } break;
+        case OP_NOT: { Val a = LPOP(); LPUSH(a == 0); } break;
+
+        case OP_DUP:  { Val v = LPOP(); LPUSH(v); LPUSH(v); } break;
+        case OP_DROP: { (void)LPOP(); } break;
+        case OP_SWAP: { Val b = LPOP(), a = LPOP(); LPUSH(b); LPUSH(a); } break;
+        case OP_OVER: { Val b = LPOP(), a = LPOP(); LPUSH(a); LPUSH(b); LPUSH(a); } break;
+
+        case OP_JMP:
+            if (ip + 4 > len) TRAP();
+            ip = (uint32_t)rd_i32(c+ip);
+            break;
+        case OP_JZ: {
+            if (ip + 4 > len) TRAP();
+            uint32_t addr = (uint32_t)rd_i32(c+ip); ip += 4;
+            if (LPOP() == 0) ip = addr;
+        } break;
+
+        case OP_CALL: {
+            uint8_t idx = LFETCH();
+            switch (idx){
+                case NAT_GPIO_MODE:  { int pin=LPOP(), mode=LPOP(); H->gpio_mode(H,pin,mode); LPUSH(0);} break;
+                case NAT_GPIO_WRITE: { int pin=LPOP(), val=LPOP();  H->gpio_write(H,pin,val); LPUSH(0);} break;
+                case NAT_SLEEP_MS:   { int ms=LPOP();                H->sleep_ms(H,ms);        LPUSH(0);} break;
+                case NAT_GPIO_READ:  { int pin=LPOP(); int v=H->gpio_read(H,pin); LPUSH(v);} break;
+                case NAT_PRINT_INT:  { int v=LPOP();                 H->print_int(H,v);        LPUSH(0);} break;
+                case NAT_GPIO_MODE_MASK: {
+                    int mode=LPOP(); uint32_t mask=(uint32_t)LPOP(); int port=LPOP();
+                    H->gpio_mode_mask(H,port,mask,mode); LPUSH(0);
+                } break;
+                case NAT_GPIO_WRITE_MASK: {
+                    uint32_t val=(uint32_t)LPOP(), mask=(uint32_t)LPOP(); int port=LPOP();
+                    H->gpio_write_mask(H,port,mask,val); LPUSH(0);
+                } break;
+                case NAT_GPIO_READ_PORT: { int port=LPOP(); LPUSH((Val)H->gpio_read_port(H,port)); } break;
+                // Blockoperationen: die Spalte einer Lane ist nicht zusammenhängend, daher skalar
+                case NAT_MEM_FILL: {
+                    Val v=LPOP(); uint32_t n=(uint32_t)LPOP(), a=(uint32_t)LPOP();
+                    if (!mem_range(B,a,n)) TRAP();
+                    for (uint32_t i=0;i<n;i++) B->mem[(size_t)(a+i)*W + l] = v;
+                    LPUSH(0);
+                } break;
+                case NAT_MEM_COPY: {
+                    uint32_t n=(uint32_t)LPOP(), s=(uint32_t)LPOP(), d=(uint32_t)LPOP();
+                    if (!mem_range(B,s,n) || !mem_range(B,d,n)) TRAP();
+                    if (d < s) for (uint32_t i=0;i<n;i++)  B->mem[(size_t)(d+i)*W + l] = B->mem[(size_t)(s+i)*W + l];
+                    else       for (uint32_t i=n;i-- > 0;) B->mem[(size_t)(d+i)*W + l] = B->mem[(size_t)(s+i)*W + l];
+                    LPUSH(0);
+                } break;
+                case NAT_MEM_SUM: case NAT_MEM_MAX: {
+                    uint32_t n=(uint32_t)LPOP(), a=(uint32_t)LPOP();
+                    if (!mem_range(B,a,n)) TRAP();
+                    uint32_t s = 0; Val mx = INT32_MIN;
+                    for (uint32_t i=0;i<n;i++){
+                        Val v = B->mem[(size_t)(a+i)*W + l];
+                        s += (uint32_t)v; if (v > mx) mx = v;
+                    }
+                    LPUSH(idx == NAT_MEM_SUM ? (Val)s : mx);
+                } break;
+                case NAT_YIELD: { (void)LPOP(); LPUSH(0); } break;   // kein Austausch im Batch
+                default: TRAP();          // auch gpio_on_edge/wait_event und Sample-Streams: im Batch nicht unterstützt
+            }
+        } break;
+
+        case OP_CALLUSER: {
+            if (ip + 4 > len) TRAP();
+            uint32_t addr = (uint32_t)rd_i32(c+ip); ip += 4;
+            if (B->csp[l] >= VM_BATCH_CALLS) TRAP();
+            B->callstack[(size_t)(B->csp[l]++)*W + l] = (Val)ip;
+            ip = addr;
+        } break;
+        case OP_RET:
+            if (B->csp[l] == 0){ B->ip[l] = ip; lane_finish(B, l, VM_OK); return; }
+            ip = (uint32_t)B->callstack[(size_t)(--B->csp[l])*W + l];
+            break;
+
+        case OP_LOADM: {
+            uint32_t a = (uint32_t)LPOP();
+            if (a >= B->mem_cap) TRAP();
+            LPUSH(B->mem[(size_t)a*W + l]);
+        } break;
+        case OP_STOREM: {
+            Val v = LPOP(); uint32_t a = (uint32_t)LPOP();
+            if (a >= B->mem_cap) TRAP();
+            B->mem[(size_t)a*W + l] = v;
+        } break;
+
+        default: TRAP();
+    }
+    B->ip[l] = ip;
+#undef LPOP
+#undef LPUSH
+#undef LFETCH
+#undef TRAP
+}
+
+// ---------------- Gruppenschritt ----------------
+
+// Lanes mit gleichem (ip, sp, csp)
+typedef struct {
+    uint32_t ip, sp, csp;
+    size_t n;                     // Anzahl Lanes in mask
+    const int32_t *mask;
+    int full;                     // alle width Lanes dabei: Kernels ohne Maske
+} Group;
+
+enum { G_NEXT, G_SPLIT };   // G_SPLIT: Zustand steht wieder in den Lane-Arrays
+
+#define FOR_GROUP(l) for (size_t l=0; l<B->width; l++) if (G->mask[l])
+
+static void group_store(VmBatch *B, const Group *G){
+    FOR_GROUP(l){ B->ip[l] = G->ip; B->sp[l] = G->sp; B->csp[l] = G->csp; }
+}
+
+static void group_finish(VmBatch *B, Group *G, uint32_t ip){
+    G->ip = ip;
+    group_store(B, G);
+    FOR_GROUP(l) lane_finish(B, l, VM_OK);
+}
+
+// Einzeln ausführen; laufen danach alle Lanes weiter gleich, bleibt die Gruppe bestehen
+static int group_scalar(VmBatch *B, Group *G){
+    group_store(B, G);
+    size_t first = B->width; int done = 0;
+    FOR_GROUP(l){
+        lane_step(B, l);
+        if (B->status[l] >= 0) done = 1;        // beendete Lane verlässt die Maske
+        else if (first == B->width) first = l;
+    }
+    if (done) return G_SPLIT;
+    int same = 1;
+    FOR_GROUP(l){
+        if (B->ip[l] != B->ip[first] || B->sp[l] != B->sp[first] ||
+            B->csp[l] != B->csp[first]){ same = 0; break; }
+    }
+    if (!same) return G_SPLIT;
+    G->ip = B->ip[first]; G->sp = B->sp[first]; G->csp = B->csp[first];
+    return G_NEXT;
+}
+
+// Eine Instruktion für alle Lanes der Gruppe. Häufige Fälle laufen als
+// Vektorbefehl; Randfälle (Über-/Unterlauf, Traps, Natives, DIV) einzeln.
+static int group_step(VmBatch *B, Group *G){
+    const VsimdOps *V = B->ops;
+    const uint8_t *c = B->code; size_t len = B->code_len, W = B->width;
+    const int32_t *m = G->full ? NULL : G->mask;
+    uint32_t ip = G->ip, sp = G->sp, csp = G->csp;
+    if (ip >= len) return group_scalar(B, G);
+
+    Op op = (Op)c[ip];
+    switch (op){
+        case OP_HALT: group_finish(B, G, ip+1); return G_SPLIT;
+
+        case OP_PUSHI:
+            if (ip+5 > len || sp >= B->stack_cap) break;
+            V->fill(ROW(B->stack, sp), rd_i32(c+ip+1), m, W);
+            G->sp = sp+1; G->ip = ip+5;
+            return G_NEXT;
+        case OP_LOADL:
+            if (ip+2 > len || c[ip+1] >= B->locals_cap || sp >= B->stack_cap) break;
+            V->copy(ROW(B->stack, sp), ROW(B->locals, c[ip+1]), m, W);
+            G->sp = sp+1; G->ip = ip+2;
+            return G_NEXT;
+        case OP_STOREL:
+            if (ip+2 > len || c[ip+1] >= B->locals_cap || sp == 0) break;
+            V->copy(ROW(B->locals, c[ip+1]), ROW(B->stack, sp-1), m, W);
+            G->sp = sp-1; G->ip = ip+2;
+            return G_NEXT;
+
+        case OP_ADD: case OP_SUB: case OP_MUL:
+        case OP_LT: case OP_EQ: case OP_GT: case OP_GE: case OP_LE: case OP_NE:
+        case OP_AND: case OP_OR:
+        case OP_BAND: case OP_BOR: case OP_BXOR: case OP_SHL: case OP_SHR:
+            if (sp < 2) break;
+            V->binop(op, ROW(B->stack, sp-2), ROW(B->stack, sp-1), m, W);
+            G->sp = sp-1; G->ip = ip+1;
+            return G_NEXT;
+        case OP_NOT:
+            if (sp < 1) break;
+            V->not_(ROW(B->stack, sp-1), m, W);
+            G->ip = ip+1;
+            return G_NEXT;
+
+        case OP_DUP:
+            if (sp < 1 || sp >= B->stack_cap) break;
+            V->copy(ROW(B->stack, sp), ROW(B->stack, sp-1), m, W);
+            G->sp = sp+1; G->ip = ip+1;
+            return G_NEXT;
+        case OP_DROP:
+            if (sp) G->sp = sp-1;
+            G->ip = ip+1;
+            return G_NEXT;
+        case OP_SWAP:
+            if (sp < 2) break;
+            V->copy(B->tmp, ROW(B->stack, sp-1), NULL, W);
+            V->copy(ROW(B->stack, sp-1), ROW(B->stack, sp-2), m, W);
+            V->copy(ROW(B->stack, sp-2), B->tmp, m, W);
+            G->ip = ip+1;
+            return G_NEXT;
+        case OP_OVER:
+            if (sp < 2 || sp >= B->stack_cap) break;
+            V->copy(ROW(B->stack, sp), ROW(B->stack, sp-2), m, W);
+            G->sp = sp+1; G->ip = ip+1;
+            return G_NEXT;
+
+        case OP_JMP:
+            if (ip+5 > len) break;
+            G->ip = (uint32_t)rd_i32(c+ip+1);
+            return G_NEXT;
+        case OP_JZ: {
+            if (ip+5 > len || sp == 0) break;
+            uint32_t taken = (uint32_t)rd_i32(c+ip+1), fall = ip+5;
+            size_t k = V->zero_mask(ROW(B->stack, sp-1), m, B->zmask, W);
+            G->sp = sp-1;
+            if (k == 0){ G->ip = fall; return G_NEXT; }
+            if (k == G->n){ G->ip = taken; return G_NEXT; }
+            FOR_GROUP(l){ B->ip[l] = B->zmask[l] ? taken : fall; B->sp[l] = sp-1; B->csp[l] = csp; }
+            return G_SPLIT;
+        }
+
+        case OP_CALLUSER:
+            if (ip+5 > len || csp >= VM_BATCH_CALLS) break;
+            V->fill(ROW(B->callstack, csp), (Val)(ip+5), m, W);
+            G->csp = csp+1; G->ip = (uint32_t)rd_i32(c+ip+1);
+            return G_NEXT;
+        case OP_RET: {
+            if (csp == 0){ group_finish(B, G, ip+1); return G_SPLIT; }
+            const Val *ra = ROW(B->callstack, csp-1);
+            Val r0 = 0; int first = 1, same = 1;
+            FOR_GROUP(l){
+                if (first){ r0 = ra[l]; first = 0; }
+                else if (ra[l] != r0){ same = 0; break; }
+            }
+            G->csp = csp-1;
+            if (same){ G->ip = (uint32_t)r0; return G_NEXT; }
+            FOR_GROUP(l){ B->ip[l] = (uint32_t)ra[l]; B->sp[l] = sp; B->csp[l] = csp-1; }
+            return G_SPLIT;
+        }
+
+        // Gather/Scatter; liegt eine Adresse außerhalb, entscheidet lane_step über den Trap
+        case OP_LOADM: {
+            if (sp == 0) break;
+            Val *a = ROW(B->stack, sp-1);
+            int ok = 1;
+            FOR_GROUP(l) if ((uint32_t)a[l] >= B->mem_cap){ ok = 0; break; }
+            if (!ok) break;
+            FOR_GROUP(l) a[l] = B->mem[(size_t)(uint32_t)a[l]*W + l];
+            G->ip = ip+1;
+            return G_NEXT;
+        }
+        case OP_STOREM: {
+            if (sp < 2) break;
+            const Val *a = ROW(B->stack, sp-2), *v = ROW(B->stack, sp-1);
+            int ok = 1;
+            FOR_GROUP(l) if ((uint32_t)a[l] >= B->mem_cap){ ok = 0; break; }
+            if (!ok) break;
+            FOR_GROUP(l) B->mem[(size_t)(uint32_t)a[l]*W + l] = v[l];
+            G->sp = sp-2; G->ip = ip+1;
+            return G_NEXT;
+        }
+
+        default: break;
+    }
+    return group_scalar(B, G);
+}
+
+// ---------------- Planung ----------------
+
+void vm_batch_run(VmBatch *B){
+    Group G; memset(&G, 0, sizeof(G));
+    int uniform = 0;
+
+    for (;;){
+        if (!uniform){
+            // Nächste Gruppe: tiefste Aufrufebene, dann kleinster ip
+            size_t lead = B->width, first = B->width, nact = 0; int same = 1;
+            for (size_t l=0; l<B->lanes; l++){
+                if (!B->act[l]) continue;
+                nact++;
+                if (first == B->width){ first = lead = l; continue; }
+                if (B->ip[l] != B->ip[first] || B->sp[l] != B->sp[first] || B->csp[l] != B->csp[first]) same = 0;
+                if (B->csp[l] > B->csp[lead] || (B->csp[l] == B->csp[lead] && B->ip[l] < B->ip[lead])) lead = l;
+            }
+            if (!nact) return;
+            G.ip = B->ip[lead]; G.sp = B->sp[lead]; G.csp = B->csp[lead];
+            if (same){
+                // Alle aktiven Lanes stehen gleich: Gleichschritt über die Aktiv-Maske
+                uniform = 1;
+                G.mask = B->act; G.n = nact; G.full = nact == B->width;
+            } else {
+                // Gruppe bilden und die nächstbeste übrige Lane merken
+                uint32_t oip = 0, ocsp = 0; int other = 0;
+                G.n = 0;
+                for (size_t l=0; l<B->width; l++){
+                    int in = B->act[l] && B->ip[l] == G.ip && B->sp[l] == G.sp && B->csp[l] == G.csp;
+                    B->gmask[l] = in ? -1 : 0;
+                    G.n += in;
+                    if (B->act[l] && !in && (!other || B->csp[l] > ocsp || (B->csp[l] == ocsp && B->ip[l] < oip))){
+                        oip = B->ip[l]; ocsp = B->csp[l]; other = 1;
+                    }
+                }
+                G.mask = B->gmask; G.full = 0;
+                // Ohne Neuplanung weiterlaufen, solange die Gruppe vorne liegt
+                int r;
+                do {
+                    B->steps++; B->lane_steps += G.n;
+                    r = group_step(B, &G);
+                } while (r == G_NEXT && (G.csp > ocsp || (G.csp == ocsp && G.ip < oip)));
+                if (r == G_NEXT) group_store(B, &G);
+                continue;
+            }
+        }
+        B->steps++; B->lane_steps += G.n;
+        if (group_step(B, &G) == G_SPLIT) uniform = 0;
+    }
+}
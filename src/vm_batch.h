@@ -0,0 +1,59 @@
+#pragma once
+#include "vm.h"
+#include "vm_simd.h"
+
+// Batch-Interpreter: führt dasselbe Programm für viele Instanzen im
+// Gleichschritt aus. Stack, Locals und Call-Stack liegen als Struct-of-Arrays
+// vor (Zeile = Slot, Spalte = Lane), Arithmetik und Vergleiche laufen als
+// Vektorbefehle über alle Lanes einer Gruppe. Auch der lineare Speicher
+// (LOADM/STOREM) ist je Lane eine Spalte; Zugriffe daran sind Gather/Scatter.
+//
+// Lanes, die an JZ oder RET auseinanderlaufen, werden einzeln verwaltet: es
+// läuft jeweils die Gruppe mit gleichem (ip, sp, csp), bevorzugt die tiefste
+// Aufrufebene und dann der kleinste ip. So holen zurückliegende Lanes auf und
+// verschmelzen an der nächsten gemeinsamen Stelle wieder.
+//
+// Jede Lane verhält sich exakt wie vm_run() auf einer eigenen VM (inklusive
+// der SAFE_PUSH/SAFE_POP-Eigenheiten). Interrupts und Sample-Streams werden
+// nicht unterstützt: gpio_on_edge/wait_event und die adc-Natives beenden die
+// Lane mit VM_TRAP.
+
+#define VM_BATCH_CALLS 256
+
+typedef struct {
+    const uint8_t *code;
+    size_t code_len;
+
+    size_t lanes, width;          // width: lanes aufgerundet auf VSIMD_WIDTH
+    size_t stack_cap, locals_cap, mem_cap;
+
+    Val *stack;                   // [stack_cap][width]
+    Val *locals;                  // [locals_cap][width]
+    Val *mem;                     // [mem_cap][width] linearer Speicher
+    Val *callstack;               // [VM_BATCH_CALLS][width] Rücksprungadressen
+
+    // Zustand je Lane; während Lanes im Gleichschritt laufen, nur beim Auseinanderlaufen/Ende aktuell
+    uint32_t *ip, *sp, *csp;
+    int8_t *status;               // -1 = läuft, sonst VmRes
+    void **hal;                   // HAL je Lane (vom Aufrufer zu setzen)
+
+    int32_t *act, *gmask, *zmask, *tmp;   // Masken-/Hilfszeilen
+    const VsimdOps *ops;
+
+    uint64_t steps;               // ausgeführte Gruppenschritte
+    uint64_t lane_steps;          // ausgeführte Instruktionen über alle Lanes
+    void *alloc;
+} VmBatch;
+
+// 0 bei Erfolg, -1 bei Speichermangel. Alle Lanes starten bei ip=0 mit leeren Stacks und Locals = 0.
+int  vm_batch_init(VmBatch *B, const uint8_t *code, size_t code_len, size_t lanes,
+                   size_t stack_cap, size_t locals_cap, size_t mem_cap);
+void vm_batch_free(VmBatch *B);
+
+// Läuft, bis jede Lane beendet ist (VM_OK oder VM_TRAP)
+void vm_batch_run(VmBatch *B);
+
+static inline VmRes vm_batch_result(const VmBatch *B, size_t lane){ return (VmRes)B->status[lane]; }
+static inline Val *vm_batch_local(VmBatch *B, size_t lane, size_t slot){ return &B->locals[slot*B->width + lane]; }
+static inline Val *vm_batch_stack(VmBatch *B, size_t lane, size_t i){ return &B->stack[i*B->width + lane]; }
+static inline Val *vm_batch_mem(VmBatch *B, size_t lane, size_t a){ return &B->mem[a*B->width + lane]; }
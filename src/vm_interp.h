@@ -0,0 +1,356 @@
+// vm_interp.h – Interpreter-Schablone, einmal je Übersetzungseinheit einbinden.
+//
+// Vor dem Einbinden festzulegen:
+//   VM_HAL_CALL(f, ...)     Aufruf der HAL-Funktion f mit ctx = vm->hal, z.B.
+//                           ((struct HAL*)vm->hal)->f(vm->hal, __VA_ARGS__) für die
+//                           Vtable oder meine_hal_##f(vm->hal, __VA_ARGS__) für eine
+//                           feste HAL, deren Aufrufe der Compiler dann inlinen kann.
+//   VM_INTERP_NAME          Name der Lauffunktion (VmRes NAME(VM*), Semantik wie vm_run).
+//                           Ohne nur die Hilfen (vm_native, irq_poll, ...) für eine
+//                           eigene Dispatch-Schleife wie in vm_tos.c.
+// Benötigt vm.h, vm_ops.h, vm_simd.h und string.h.
+#ifndef VM_HAL_CALL
+#error "VM_HAL_CALL fehlt"
+#endif
+
+static int32_t rd_i32(const uint8_t *p){
+    int32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// SAFE helper functions
+static inline uint8_t SAFE_FETCH(VM *vm) {
+    if (vm->ip >= vm->code_len) return 0;
+    return vm->code[vm->ip++];
+}
+
+static inline void SAFE_PUSH(VM *vm, Val v) {
+    if (vm->sp >= vm->stack_cap) return;
+    vm->stack[vm->sp++] = v;
+}
+
+static inline Val SAFE_POP(VM *vm) {
+    if (vm->sp == 0) return 0;
+    return vm->stack[--vm->sp];
+}
+
+// Markiert Rücksprünge aus Interrupt-Handlern im Call-Stack
+#define VM_IRQ_FRAME 0x80000000u
+
+// Holt anstehende Ereignisse und springt in den passenden Handler.
+// Rückgabe: 1 Handler gestartet, 0 nichts zu tun, -1 Call-Stack voll.
+static int irq_poll(VM *vm){
+    int pin, edge;
+    while (VM_HAL_CALL(event_poll, &pin, &edge)){
+        for (int i=0;i<vm->nirq;i++){
+            if (vm->irq[i].pin != pin || !(vm->irq[i].edge & edge)) continue;
+            if (vm->csp >= vm->call_cap) return -1;
+            vm->callstack[vm->csp++] = vm->ip | VM_IRQ_FRAME;
+            SAFE_PUSH(vm, pin);                   // Handler-Parameter
+            vm->ip = vm->irq[i].addr;
+            vm->in_irq = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Sichere Punkte (Rückwärtssprung, RET, nach Natives): hier laufen Handler.
+// Ohne registrierte Handler kostet das nur einen Vergleich.
+#define IRQ_SAFEPOINT() \
+    do { if (vm->nirq && !vm->in_irq && irq_poll(vm) < 0) return VM_TRAP; } while (0)
+
+// Bereich [a, a+n) liegt im linearen Speicher
+static inline int mem_range(const VM *vm, uint32_t a, uint32_t n){
+    return a <= vm->mem_cap && n <= vm->mem_cap - a;
+}
+
+// ---- Sample-Streams: blockweise aus der HAL, Filter über die SIMD-Kernels ----
+#define ADC_CHUNK 256
+
+static Val adc_avg(VM *vm, int ch, uint32_t n){
+    Val buf[ADC_CHUNK];
+    int64_t sum = 0; uint32_t got = 0;
+    while (got < n){
+        int want = n-got < ADC_CHUNK ? (int)(n-got) : ADC_CHUNK;
+        int k = VM_HAL_CALL(adc_read, ch, buf, want);
+        if (k <= 0) break;
+        sum += vsimd_ops()->sum(buf, (size_t)k);     // k Werte bis VM_ADC_MAX (hal.h): kein Überlauf
+        got += (uint32_t)k;
+        if (k < want) break;
+    }
+    return got ? (Val)(sum / got) : 0;
+}
+
+static Val adc_count_above(VM *vm, int ch, uint32_t n, Val thr){
+    Val buf[ADC_CHUNK];
+    uint32_t got = 0, cnt = 0;
+    while (got < n){
+        int want = n-got < ADC_CHUNK ? (int)(n-got) : ADC_CHUNK;
+        int k = VM_HAL_CALL(adc_read, ch, buf, want);
+        if (k <= 0) break;
+        cnt += (uint32_t)vsimd_ops()->count_gt(buf, thr, (size_t)k);
+        got += (uint32_t)k;
+        if (k < want) break;
+    }
+    return (Val)cnt;
+}
+
+// Verlauf und Koeffizienten im linearen Speicher (Bereiche vom Aufrufer geprüft)
+static Val adc_fir(VM *vm, int ch, uint32_t n, uint32_t coef, uint32_t taps, uint32_t dst){
+    Val x[VM_FIR_TAPS-1 + ADC_CHUNK];
+    const Val *c = vm->mem + coef;
+    Val *hist = vm->mem + coef + taps;
+    uint32_t h = taps-1, got = 0;
+    memcpy(x, hist, h*sizeof(Val));
+    while (got < n){
+        int want = n-got < ADC_CHUNK ? (int)(n-got) : ADC_CHUNK;
+        int k = VM_HAL_CALL(adc_read, ch, x+h, want);
+        if (k <= 0) break;
+        vsimd_ops()->fir(vm->mem + dst + got, x, c, taps, (size_t)k);
+        memmove(x, x+k, h*sizeof(Val));               // jüngste taps-1 Eingaben als Verlauf
+        got += (uint32_t)k;
+        if (k < want) break;
+    }
+    memcpy(hist, x, h*sizeof(Val));
+    return (Val)got;
+}
+
+// Native idx ausführen (ip steht hinter dem CALL), danach der sichere Punkt.
+// VM_OK heißt weiterlaufen, alles andere beendet die Lauffunktion.
+static inline VmRes vm_native(VM *vm, uint8_t idx){
+    switch(idx){
+        case NAT_GPIO_MODE:  { int pin=SAFE_POP(vm), mode=SAFE_POP(vm); VM_HAL_CALL(gpio_mode,pin,mode); SAFE_PUSH(vm,0);} break;
+        case NAT_GPIO_WRITE: { int pin=SAFE_POP(vm), val=SAFE_POP(vm);  VM_HAL_CALL(gpio_write,pin,val); SAFE_PUSH(vm,0);} break;
+        case NAT_SLEEP_MS:   { int ms=SAFE_POP(vm);                     VM_HAL_CALL(sleep_ms,ms);        SAFE_PUSH(vm,0);} break;
+        case NAT_GPIO_READ:  { int pin=SAFE_POP(vm); int v=VM_HAL_CALL(gpio_read,pin); SAFE_PUSH(vm,v);} break;
+        case NAT_PRINT_INT:  { int v=SAFE_POP(vm);                      VM_HAL_CALL(print_int,v);        SAFE_PUSH(vm,0);} break;
+
+        // Port-weit: ein HAL-Aufruf statt einem je Pin
+        case NAT_GPIO_MODE_MASK: {
+            int mode=SAFE_POP(vm); uint32_t mask=(uint32_t)SAFE_POP(vm); int port=SAFE_POP(vm);
+            VM_HAL_CALL(gpio_mode_mask,port,mask,mode); SAFE_PUSH(vm,0);
+        } break;
+        case NAT_GPIO_WRITE_MASK: {
+            uint32_t val=(uint32_t)SAFE_POP(vm), mask=(uint32_t)SAFE_POP(vm); int port=SAFE_POP(vm);
+            VM_HAL_CALL(gpio_write_mask,port,mask,val); SAFE_PUSH(vm,0);
+        } break;
+        case NAT_GPIO_READ_PORT: { int port=SAFE_POP(vm); SAFE_PUSH(vm,(Val)VM_HAL_CALL(gpio_read_port,port)); } break;
+
+        case NAT_GPIO_ON_EDGE: {
+            uint32_t addr=(uint32_t)SAFE_POP(vm); int edge=SAFE_POP(vm), pin=SAFE_POP(vm);
+            if (!vm->irq || addr >= vm->code_len || !(edge & EDGE_BOTH)) return VM_TRAP;
+            int i=0;
+            while (i<vm->nirq && vm->irq[i].pin!=pin) i++;   // neu registrieren ersetzt
+            if (i==VM_MAX_IRQ) return VM_TRAP;
+            vm->irq[i].pin=(int16_t)pin; vm->irq[i].edge=(uint8_t)edge; vm->irq[i].addr=addr;
+            if (i==vm->nirq) vm->nirq++;
+            SAFE_PUSH(vm, VM_HAL_CALL(irq_attach,pin,edge));
+        } break;
+        case NAT_WAIT_EVENT: {
+            if (!vm->nirq) return VM_TRAP;    // würde ewig warten
+            SAFE_PUSH(vm,0);
+            if (vm->in_irq) break;
+            int r = irq_poll(vm);
+            if (r < 0) return VM_TRAP;
+            if (r == 0) return VM_WAIT;       // parken, ip steht hinter dem CALL
+        } break;
+
+        // Blockoperationen (SIMD-Kernels aus vm_simd.c)
+        case NAT_MEM_FILL: {
+            Val v=SAFE_POP(vm); uint32_t n=(uint32_t)SAFE_POP(vm), a=(uint32_t)SAFE_POP(vm);
+            if (!mem_range(vm,a,n)) return VM_TRAP;
+            vsimd_ops()->fill_n(vm->mem+a, v, n); SAFE_PUSH(vm,0);
+        } break;
+        case NAT_MEM_COPY: {
+            uint32_t n=(uint32_t)SAFE_POP(vm), s=(uint32_t)SAFE_POP(vm), d=(uint32_t)SAFE_POP(vm);
+            if (!mem_range(vm,s,n) || !mem_range(vm,d,n)) return VM_TRAP;
+            memmove(vm->mem+d, vm->mem+s, (size_t)n*sizeof(Val)); SAFE_PUSH(vm,0);
+        } break;
+        case NAT_MEM_SUM: {
+            uint32_t n=(uint32_t)SAFE_POP(vm), a=(uint32_t)SAFE_POP(vm);
+            if (!mem_range(vm,a,n)) return VM_TRAP;
+            SAFE_PUSH(vm, vsimd_ops()->sum(vm->mem+a, n));
+        } break;
+        case NAT_MEM_MAX: {
+            uint32_t n=(uint32_t)SAFE_POP(vm), a=(uint32_t)SAFE_POP(vm);
+            if (!mem_range(vm,a,n)) return VM_TRAP;
+            SAFE_PUSH(vm, vsimd_ops()->max(vm->mem+a, n));   // n = 0: INT32_MIN
+        } break;
+
+        // Sample-Streams (siehe vm.h); negative Längen -> Trap
+        case NAT_ADC_SAMPLE: {
+            int ch=SAFE_POP(vm); Val v=0;
+            if (VM_HAL_CALL(adc_read,ch,&v,1) != 1) v = 0;
+            SAFE_PUSH(vm,v);
+        } break;
+        case NAT_ADC_READ: {
+            Val n=SAFE_POP(vm); uint32_t d=(uint32_t)SAFE_POP(vm); int ch=SAFE_POP(vm);
+            if (n < 0 || !mem_range(vm,d,(uint32_t)n)) return VM_TRAP;
+            int k = n ? VM_HAL_CALL(adc_read,ch,vm->mem+d,n) : 0;
+            SAFE_PUSH(vm, k > 0 ? k : 0);
+        } break;
+        case NAT_ADC_BLOCK_AVG: {
+            Val n=SAFE_POP(vm); int ch=SAFE_POP(vm);
+            if (n < 0) return VM_TRAP;
+            SAFE_PUSH(vm, adc_avg(vm,ch,(uint32_t)n));
+        } break;
+        case NAT_COUNT_ABOVE: {
+            Val thr=SAFE_POP(vm), n=SAFE_POP(vm); int ch=SAFE_POP(vm);
+            if (n < 0) return VM_TRAP;
+            SAFE_PUSH(vm, adc_count_above(vm,ch,(uint32_t)n,thr));
+        } break;
+        case NAT_FIR_APPLY: {
+            uint32_t d=(uint32_t)SAFE_POP(vm), taps=(uint32_t)SAFE_POP(vm), coef=(uint32_t)SAFE_POP(vm);
+            Val n=SAFE_POP(vm); int ch=SAFE_POP(vm);
+            if (n < 0 || taps < 1 || taps > VM_FIR_TAPS) return VM_TRAP;
+            if (!mem_range(vm,coef,2*taps-1) || !mem_range(vm,d,(uint32_t)n)) return VM_TRAP;
+            SAFE_PUSH(vm, adc_fir(vm,ch,(uint32_t)n,coef,taps,d));
+        } break;
+        case NAT_YIELD: {
+            (void)SAFE_POP(vm); SAFE_PUSH(vm,0);
+            return VM_YIELD;                  // Fortsetzen beginnt mit dem sicheren Punkt
+        }
+        default: return VM_TRAP;
+    }
+    IRQ_SAFEPOINT();
+    return VM_OK;
+}
+
+#ifdef VM_INTERP_NAME
+VmRes VM_INTERP_NAME(VM *vm){
+
+    IRQ_SAFEPOINT();   // Fortsetzen nach VM_WAIT
+
+    while (vm->ip < vm->code_len){
+        switch ((Op)SAFE_FETCH(vm)){
+            case OP_HALT: 
+                return VM_OK;
+
+            case OP_PUSHI: {
+                if (vm->ip + 4 > vm->code_len) return VM_TRAP;
+                int32_t v = rd_i32(vm->code+vm->ip);
+                vm->ip += 4;
+                SAFE_PUSH(vm, v);
+            } break;
+
+            case OP_LOADL: {
+                uint8_t idx = SAFE_FETCH(vm);
+                if (idx >= vm->locals_cap) return VM_TRAP;
+                SAFE_PUSH(vm, vm->locals[idx]);
+            } break;
+
+            case OP_STOREL: {
+                uint8_t idx = SAFE_FETCH(vm);
+                if (idx >= vm->locals_cap) return VM_TRAP;
+                vm->locals[idx] = SAFE_POP(vm);
+            } break;
+
+            case OP_ADD: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a+b);} break;
+            case OP_SUB: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a-b);} break;
+            case OP_MUL: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a*b);} break;
+            case OP_DIV: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); if(b==0) return VM_TRAP; SAFE_PUSH(vm, a/b);} break;
+
+            case OP_JMP: {
+                if (vm->ip + 4 > vm->code_len) return VM_TRAP;
+                int32_t addr = rd_i32(vm->code+vm->ip);
+                uint32_t from = vm->ip;
+                vm->ip = (uint32_t)addr;                // absolute Zieladresse (wie motec/asm_min)
+                if (vm->ip < from) IRQ_SAFEPOINT();
+            } break;
+
+            case OP_JZ: {
+                if (vm->ip + 4 > vm->code_len) return VM_TRAP;
+                int32_t addr = rd_i32(vm->code+vm->ip);
+                vm->ip += 4;
+                if (SAFE_POP(vm) == 0){
+                    uint32_t from = vm->ip;
+                    vm->ip = (uint32_t)addr;
+                    if (vm->ip < from) IRQ_SAFEPOINT();
+                }
+            } break;
+
+            case OP_LT: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a<b?1:0);} break;
+            case OP_EQ: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a==b?1:0);} break;
+
+            // Neue Stack Ops
+            case OP_DUP: { Val v=SAFE_POP(vm); SAFE_PUSH(vm,v); SAFE_PUSH(vm,v);} break;
+            case OP_DROP:{ (void)SAFE_POP(vm);} break;
+            case OP_SWAP:{ Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm,b); SAFE_PUSH(vm,a);} break;
+            case OP_OVER:{ Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm,a); SAFE_PUSH(vm,b); SAFE_PUSH(vm,a);} break;
+
+            // Neue Vergleiche
+            case OP_GT: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a>b?1:0);} break;
+            case OP_GE: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a>=b?1:0);} break;
+            case OP_LE: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a<=b?1:0);} break;
+            case OP_NE: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a!=b?1:0);} break;
+
+            // Logik
+            case OP_NOT:{ Val a=SAFE_POP(vm); SAFE_PUSH(vm, a==0?1:0);} break;
+            case OP_AND:{ Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, (a!=0 && b!=0)?1:0);} break;
+            case OP_OR: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, (a!=0 || b!=0)?1:0);} break;
+
+            case OP_MOD: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); if(b==0) return VM_TRAP; SAFE_PUSH(vm, vm_mod(a,b));} break;
+            case OP_SHL: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, vm_shl(a,b));} break;
+            case OP_SHR: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, vm_shr(a,b));} break;
+            case OP_BAND:{ Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a & b);} break;
+            case OP_BOR: { Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a | b);} break;
+            case OP_BXOR:{ Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, a ^ b);} break;
+            case OP_FMUL:{ Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, vm_fmul(a,b));} break;
+            case OP_FDIV:{ Val b=SAFE_POP(vm), a=SAFE_POP(vm); SAFE_PUSH(vm, vm_fdiv(a,b));} break;
+            case OP_ADD64: {
+                Val bh=SAFE_POP(vm), bl=SAFE_POP(vm), ah=SAFE_POP(vm), al=SAFE_POP(vm);
+                uint64_t r = vm_pair(al,ah) + vm_pair(bl,bh);
+                SAFE_PUSH(vm, (Val)(uint32_t)r); SAFE_PUSH(vm, (Val)(uint32_t)(r >> 32));
+            } break;
+            case OP_MUL64: {
+                Val bh=SAFE_POP(vm), bl=SAFE_POP(vm), ah=SAFE_POP(vm), al=SAFE_POP(vm);
+                uint64_t r = vm_pair(al,ah) * vm_pair(bl,bh);
+                SAFE_PUSH(vm, (Val)(uint32_t)r); SAFE_PUSH(vm, (Val)(uint32_t)(r >> 32));
+            } break;
+
+            case OP_CALL: {
+                VmRes r = vm_native(vm, SAFE_FETCH(vm));
+                if (r != VM_OK) return r;
+            } break;
+
+            case OP_CALLUSER: {
+                if (vm->ip + 4 > vm->code_len) return VM_TRAP;
+                int32_t addr = rd_i32(vm->code + vm->ip);
+                vm->ip += 4;
+                if (vm->csp >= vm->call_cap) return VM_TRAP;   // Call-Stack-Overflow
+                vm->callstack[vm->csp++] = vm->ip;    // Rücksprung speichern
+                vm->ip = (uint32_t)addr;              // Springe zur Funktion
+            } break;
+
+            case OP_RET: {
+                if (vm->csp == 0) return VM_OK;       // Main beendet
+                uint32_t ra = vm->callstack[--vm->csp]; // Rücksprung laden
+                if (ra & VM_IRQ_FRAME){               // Handler fertig: Rückgabewert verwerfen
+                    (void)SAFE_POP(vm);
+                    vm->in_irq = 0;
+                    ra &= ~VM_IRQ_FRAME;
+                }
+                vm->ip = ra;
+                IRQ_SAFEPOINT();
+            } break;
+
+            case OP_LOADM: {
+                uint32_t a = (uint32_t)SAFE_POP(vm);
+                if (a >= vm->mem_cap) return VM_TRAP;
+                SAFE_PUSH(vm, vm->mem[a]);
+            } break;
+            case OP_STOREM: {
+                Val v = SAFE_POP(vm); uint32_t a = (uint32_t)SAFE_POP(vm);
+                if (a >= vm->mem_cap) return VM_TRAP;
+                vm->mem[a] = v;
+            } break;
+
+            default:
+                return VM_TRAP;
+        }
+    }
+    return VM_TRAP;
+}
+#endif
@@ -0,0 +1,110 @@
+#pragma once
+#include "vm.h"
+
+// Opcode-Metadaten für Werkzeuge (Optimierer, Analyse), die Bytecode dekodieren.
+// Muss zur Dekodierung in vm_run() passen.
+
+#define OP_COUNT (OP_MUL64+1)
+
+static const char *const vm_op_names[OP_COUNT] = {
+    "HALT", "PUSHI", "LOADL", "STOREL",
+    "ADD", "SUB", "MUL", "DIV",
+    "JMP", "JZ", "CALL", "LT", "EQ",
+    "DUP", "DROP", "SWAP", "OVER",
+    "GT", "GE", "LE", "NE",
+    "NOT", "AND", "OR",
+    "CALLUSER", "RET", "LOADM", "STOREM",
+    "MOD", "SHL", "SHR", "BAND", "BOR", "BXOR",
+    "FMUL", "FDIV", "ADD64", "MUL64"
+};
+
+// Anzahl der Operanden-Bytes nach dem Opcode, -1 für unbekannte Opcodes
+static inline int vm_op_operand_len(uint8_t op){
+    switch(op){
+        case OP_PUSHI: case OP_JMP: case OP_JZ: case OP_CALLUSER: return 4;
+        case OP_LOADL: case OP_STOREL: case OP_CALL:             return 1;
+        default: return op < OP_COUNT ? 0 : -1;
+    }
+}
+
+static inline const char *vm_op_name(uint8_t op){
+    return op < OP_COUNT ? vm_op_names[op] : "???";
+}
+
+#define NAT_COUNT (NAT_YIELD+1)
+
+// Namen wie in der Quellsprache (motec)
+static const char *const vm_native_names[NAT_COUNT] = {
+    "gpio_mode", "gpio_write", "sleep_ms", "gpio_read", "print_int",
+    "gpio_mode_mask", "gpio_write_mask", "gpio_read_port",
+    "gpio_on_edge", "wait_event",
+    "mem_fill", "mem_copy", "mem_sum", "mem_max",
+    "adc_sample", "adc_read", "adc_block_avg", "count_above",
+    "fir_apply", "yield"
+};
+
+// Anzahl der Argumente, die ein Native vom Stack nimmt (jeder legt genau einen Wert ab), -1 wenn unbekannt
+static inline int vm_native_args(uint8_t idx){
+    switch(idx){
+        case NAT_GPIO_MODE: case NAT_GPIO_WRITE:                 return 2;
+        case NAT_SLEEP_MS: case NAT_GPIO_READ: case NAT_PRINT_INT: return 1;
+        case NAT_GPIO_MODE_MASK: case NAT_GPIO_WRITE_MASK:       return 3;
+        case NAT_GPIO_READ_PORT:                                 return 1;
+        case NAT_GPIO_ON_EDGE:                                   return 3;
+        case NAT_WAIT_EVENT:                                     return 0;
+        case NAT_MEM_FILL: case NAT_MEM_COPY:                    return 3;
+        case NAT_MEM_SUM: case NAT_MEM_MAX:                      return 2;
+        case NAT_ADC_SAMPLE:                                     return 1;
+        case NAT_ADC_BLOCK_AVG:                                  return 2;
+        case NAT_ADC_READ: case NAT_COUNT_ABOVE:                 return 3;
+        case NAT_FIR_APPLY:                                      return 5;
+        case NAT_YIELD:                                          return 1;
+        default: return -1;
+    }
+}
+
+// ---- Arithmetik, die alle Interpreter gleich rechnen ----
+
+static inline Val vm_sat32(int64_t v){
+    return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (Val)v;
+}
+static inline Val vm_shl(Val a, Val b){ return (Val)((uint32_t)a << (b & 31)); }
+static inline Val vm_shr(Val a, Val b){ return a >> (b & 31); }
+// b != 0 vom Aufrufer geprüft; INT32_MIN % -1 ist 0
+static inline Val vm_mod(Val a, Val b){ return b == -1 ? 0 : a % b; }
+// Q16.16: Produkt abgerundet (arithmetisch geschoben), Quotient gegen 0
+static inline Val vm_fmul(Val a, Val b){ return vm_sat32(((int64_t)a * b) >> 16); }
+static inline Val vm_fdiv(Val a, Val b){
+    if (b == 0) return a > 0 ? INT32_MAX : a < 0 ? INT32_MIN : 0;
+    return vm_sat32(((int64_t)a * 65536) / b);
+}
+static inline uint64_t vm_pair(Val lo, Val hi){ return (uint64_t)(uint32_t)hi << 32 | (uint32_t)lo; }
+
+// Stack-Wirkung einer Instruktion (arg = dekodierter Operand). CALLUSER und
+// RET hängen vom Callee ab und liefern 0/0. Rückgabe -1 bei Unbekanntem.
+static inline int vm_op_stack_effect(uint8_t op, int32_t arg, int *pop, int *push){
+    *pop = 0; *push = 0;
+    switch(op){
+        case OP_PUSHI: case OP_LOADL:                            *push = 1; break;
+        case OP_STOREL: case OP_JZ: case OP_DROP:      *pop = 1;            break;
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+        case OP_LT: case OP_EQ: case OP_GT: case OP_GE: case OP_LE: case OP_NE:
+        case OP_AND: case OP_OR:
+        case OP_MOD: case OP_SHL: case OP_SHR: case OP_BAND: case OP_BOR: case OP_BXOR:
+        case OP_FMUL: case OP_FDIV:                    *pop = 2; *push = 1; break;
+        case OP_ADD64: case OP_MUL64:                  *pop = 4; *push = 2; break;
+        case OP_NOT: case OP_LOADM:                    *pop = 1; *push = 1; break;
+        case OP_STOREM:                                *pop = 2;            break;
+        case OP_DUP:                                   *pop = 1; *push = 2; break;
+        case OP_SWAP:                                  *pop = 2; *push = 2; break;
+        case OP_OVER:                                  *pop = 2; *push = 3; break;
+        case OP_CALL: {
+            int n = vm_native_args((uint8_t)arg);
+            if (n < 0) return -1;
+            *pop = n; *push = 1;
+        } break;
+        case OP_HALT: case OP_JMP: case OP_CALLUSER: case OP_RET: break;
+        default: return -1;
+    }
+    return 0;
+}
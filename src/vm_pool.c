@@ -0,0 +1,67 @@
+// vm_pool.c – Slab-Allokator für VM-Instanzen (siehe vm_pool.h)
+#include <stdlib.h>
+#include <string.h>
+#include "vm_pool.h"
+
+#define ALIGN8(x) (((x) + 7) & ~(size_t)7)
+
+typedef struct Slab { struct Slab *next; } Slab;
+#define SLAB_HDR ALIGN8(sizeof(Slab))
+
+void vm_pool_init(VmPool *P, const uint8_t *code, size_t code_len, const VmNeeds *n){
+    memset(P, 0, sizeof(*P));
+    P->code = code; P->code_len = (uint32_t)code_len;
+    P->stack_cap  = n->stack_max;
+    P->locals_cap = n->locals_max;
+    P->call_cap   = n->call_max;
+    P->mem_cap    = n->mem_words;
+    P->irq        = n->irq;
+    P->block = ALIGN8(sizeof(VM))
+             + ALIGN8((size_t)(P->stack_cap + P->locals_cap + P->mem_cap) * sizeof(Val) + (size_t)P->call_cap * sizeof(uint32_t))
+             + (P->irq ? ALIGN8(VM_MAX_IRQ * sizeof(VmIrq)) : 0);
+    P->per_slab = (VM_POOL_SLAB - SLAB_HDR) / P->block;
+    if (!P->per_slab) P->per_slab = 1;
+}
+
+void vm_pool_destroy(VmPool *P){
+    for (Slab *s = (Slab*)P->slabs; s; ){ Slab *nx = s->next; free(s); s = nx; }
+    memset(P, 0, sizeof(*P));
+}
+
+VM *vm_pool_alloc(VmPool *P, void *hal){
+    uint8_t *b;
+    if (P->free_list){
+        b = (uint8_t*)P->free_list;
+        memcpy(&P->free_list, b, sizeof(void*));
+    } else {
+        if (!P->fresh){
+            Slab *s = (Slab*)malloc(SLAB_HDR + P->per_slab * P->block);
+            if (!s) return NULL;
+            s->next = (Slab*)P->slabs; P->slabs = s;
+            P->fresh = P->per_slab;
+            P->bytes += SLAB_HDR + P->per_slab * P->block;
+        }
+        b = (uint8_t*)P->slabs + SLAB_HDR + (P->per_slab - P->fresh--) * P->block;
+    }
+    memset(b, 0, P->block);
+
+    VM *vm = (VM*)b;
+    uint8_t *p = b + ALIGN8(sizeof(VM));
+    vm->stack     = (Val*)p;      p += (size_t)P->stack_cap * sizeof(Val);
+    vm->locals    = (Val*)p;      p += (size_t)P->locals_cap * sizeof(Val);
+    vm->mem       = (Val*)p;      p += (size_t)P->mem_cap * sizeof(Val);
+    vm->callstack = (uint32_t*)p; p += (size_t)P->call_cap * sizeof(uint32_t);
+    vm->irq       = P->irq ? (VmIrq*)(b + P->block - ALIGN8(VM_MAX_IRQ * sizeof(VmIrq))) : NULL;
+    vm->code = P->code; vm->code_len = P->code_len;
+    vm->stack_cap = P->stack_cap; vm->locals_cap = P->locals_cap; vm->call_cap = P->call_cap;
+    vm->mem_cap = P->mem_cap;
+    vm->hal = hal;
+    P->live++;
+    return vm;
+}
+
+void vm_pool_release(VmPool *P, VM *vm){
+    memcpy(vm, &P->free_list, sizeof(void*));
+    P->free_list = vm;
+    P->live--;
+}
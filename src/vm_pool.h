@@ -0,0 +1,35 @@
+#pragma once
+#include "vm.h"
+#include "vm_analyze.h"
+
+// Slab-Allokator für viele Instanzen desselben Programms. Jede Instanz
+// belegt einen Block fester Größe: VM-Kopf, Stack, Locals, Call-Stack,
+// linearer Speicher (n->mem_words) und
+// (nur bei Programmen mit Interrupts) die Handler-Tabelle liegen direkt
+// hintereinander. Blöcke kommen aus großen Slabs, freigegebene Blöcke
+// wandern in eine Freiliste und werden wiederverwendet.
+
+#define VM_POOL_SLAB (256*1024)   // Bytes je Slab
+
+typedef struct VmPool {
+    const uint8_t *code;
+    uint32_t code_len;
+    uint32_t stack_cap, locals_cap, call_cap, mem_cap;
+    uint8_t irq;
+
+    size_t block;          // Bytes je Instanz
+    size_t per_slab;       // Instanzen je Slab
+    void *slabs;           // verkettete Slabs
+    void *free_list;
+    size_t fresh;          // unbenutzte Blöcke im jüngsten Slab
+    size_t live;           // belegte Instanzen
+    size_t bytes;          // vom System angeforderter Speicher
+} VmPool;
+
+// Bemisst die Instanzen nach n (z. B. aus vm_analyze)
+void vm_pool_init(VmPool *P, const uint8_t *code, size_t code_len, const VmNeeds *n);
+void vm_pool_destroy(VmPool *P);
+
+// Frische Instanz bei ip=0 mit leerem Stack und Locals = 0; NULL bei Speichermangel
+VM  *vm_pool_alloc(VmPool *P, void *hal);
+void vm_pool_release(VmPool *P, VM *vm);
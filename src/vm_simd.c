@@ -0,0 +1,134 @@
+// vm_simd.c – Laufzeitwahl der Vektor-Kernels für den Batch-Interpreter
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "vm_simd.h"
+
+// ---------------- skalarer Fallback ----------------
+static void sc_binop(Op op, Val *a, const Val *b, const int32_t *mask, size_t n){
+    for (size_t i=0;i<n;i++){
+        if (mask && !mask[i]) continue;
+        Val x = a[i], y = b[i], r;
+        switch (op){
+            case OP_ADD: r = (Val)((uint32_t)x + (uint32_t)y); break;
+            case OP_SUB: r = (Val)((uint32_t)x - (uint32_t)y); break;
+            case OP_MUL: r = (Val)((uint32_t)x * (uint32_t)y); break;
+            case OP_LT:  r = x <  y; break;
+            case OP_EQ:  r = x == y; break;
+            case OP_GT:  r = x >  y; break;
+            case OP_GE:  r = x >= y; break;
+            case OP_LE:  r = x <= y; break;
+            case OP_NE:  r = x != y; break;
+            case OP_AND: r = (x != 0) && (y != 0); break;
+            case OP_OR:  r = (x != 0) || (y != 0); break;
+            case OP_BAND: r = x & y; break;
+            case OP_BOR:  r = x | y; break;
+            case OP_BXOR: r = x ^ y; break;
+            case OP_SHL:  r = (Val)((uint32_t)x << (y & 31)); break;
+            case OP_SHR:  r = x >> (y & 31); break;
+            default: return;
+        }
+        a[i] = r;
+    }
+}
+static void sc_not(Val *a, const int32_t *mask, size_t n){
+    for (size_t i=0;i<n;i++) if (!mask || mask[i]) a[i] = a[i] == 0;
+}
+static void sc_fill(Val *d, Val v, const int32_t *mask, size_t n){
+    for (size_t i=0;i<n;i++) if (!mask || mask[i]) d[i] = v;
+}
+static void sc_copy(Val *d, const Val *s, const int32_t *mask, size_t n){
+    for (size_t i=0;i<n;i++) if (!mask || mask[i]) d[i] = s[i];
+}
+static size_t sc_zero_mask(const Val *a, const int32_t *mask, int32_t *out, size_t n){
+    size_t c = 0;
+    for (size_t i=0;i<n;i++){ out[i] = (!mask || mask[i]) && a[i] == 0 ? -1 : 0; c += out[i] != 0; }
+    return c;
+}
+static void sc_fill_n(Val *d, Val v, size_t n){ for (size_t i=0;i<n;i++) d[i] = v; }
+static Val sc_sum(const Val *a, size_t n){
+    uint32_t s = 0;
+    for (size_t i=0;i<n;i++) s += (uint32_t)a[i];
+    return (Val)s;
+}
+static Val sc_max(const Val *a, size_t n){
+    Val m = INT32_MIN;
+    for (size_t i=0;i<n;i++) if (a[i] > m) m = a[i];
+    return m;
+}
+static size_t sc_count_gt(const Val *a, Val thr, size_t n){
+    size_t k = 0;
+    for (size_t i=0;i<n;i++) k += a[i] > thr;
+    return k;
+}
+static void sc_fir(Val *y, const Val *x, const Val *c, size_t taps, size_t n){
+    for (size_t i=0;i<n;i++){
+        uint32_t acc = 0;
+        for (size_t k=0;k<taps;k++) acc += (uint32_t)c[k] * (uint32_t)x[i+taps-1-k];
+        y[i] = (Val)acc >> 15;
+    }
+}
+static const VsimdOps vsimd_ops_scalar = { "scalar", sc_binop, sc_not, sc_fill, sc_copy, sc_zero_mask,
+                                           sc_fill_n, sc_sum, sc_max, sc_count_gt, sc_fir };
+
+// ---------------- Vektorvarianten ----------------
+#if defined(__GNUC__)
+typedef int32_t  v8si __attribute__((vector_size(32), may_alias));
+typedef uint32_t v8su __attribute__((vector_size(32), may_alias));
+typedef int32_t  v8si_u __attribute__((vector_size(32), may_alias, aligned(4)));   // unausgerichtet
+typedef uint32_t v8su_u __attribute__((vector_size(32), may_alias, aligned(4)));
+
+#define VS_SFX  generic
+#define VS_ATTR
+#define VS_NAME "generic"
+#include "vm_simd_kern.h"
+#undef VS_SFX
+#undef VS_ATTR
+#undef VS_NAME
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VS_HAVE_X86 1
+#define VS_SFX  sse4
+#define VS_ATTR __attribute__((target("sse4.1")))
+#define VS_NAME "sse4.1"
+#include "vm_simd_kern.h"
+#undef VS_SFX
+#undef VS_ATTR
+#undef VS_NAME
+
+#define VS_SFX  avx2
+#define VS_ATTR __attribute__((target("avx2")))
+#define VS_NAME "avx2"
+#include "vm_simd_kern.h"
+#undef VS_SFX
+#undef VS_ATTR
+#undef VS_NAME
+#endif
+#endif
+
+static const VsimdOps *pick(void){
+    const char *force = getenv("MOTE_SIMD");
+    if (force && !strcmp(force, "scalar")) return &vsimd_ops_scalar;
+#if defined(__GNUC__)
+    if (force && !strcmp(force, "generic")) return &vsimd_ops_generic;
+#ifdef VS_HAVE_X86
+    __builtin_cpu_init();
+    int avx2 = __builtin_cpu_supports("avx2"), sse4 = __builtin_cpu_supports("sse4.1");
+    if (force && !strcmp(force, "sse4")) avx2 = 0;     // erzwungen: höchstens SSE4.1
+    if (avx2) return &vsimd_ops_avx2;
+    if (sse4) return &vsimd_ops_sse4;
+#endif
+    return &vsimd_ops_generic;
+#else
+    return &vsimd_ops_scalar;
+#endif
+}
+
+// Mehrere VM-Threads dürfen gleichzeitig fragen: pick() liefert immer dasselbe,
+// im ungünstigen Fall wählt jeder einmal selbst
+const VsimdOps *vsimd_ops(void){
+    static _Atomic(const VsimdOps*) ops;
+    const VsimdOps *o = atomic_load_explicit(&ops, memory_order_relaxed);
+    if (!o){ o = pick(); atomic_store_explicit(&ops, o, memory_order_relaxed); }
+    return o;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "vm.h"
+
+// Vektor-Kernels über Zeilen von Lanes (Struct-of-Arrays), zur Laufzeit je
+// nach CPU gewählt (AVX2, SSE4.1, generisch, skalar).
+//
+// Alle Zeilen sind 32-Byte-ausgerichtet, n ist ein Vielfaches von VSIMD_WIDTH.
+// mask: -1 = Lane nimmt teil, 0 = Lane bleibt unverändert; NULL = alle Lanes.
+
+#define VSIMD_WIDTH 8
+
+typedef struct {
+    const char *name;
+    // a = op(a, b) für ADD/SUB/MUL, Vergleiche, AND/OR, Bitoperationen und Shifts (Semantik wie vm_run)
+    void   (*binop)(Op op, Val *a, const Val *b, const int32_t *mask, size_t n);
+    void   (*not_)(Val *a, const int32_t *mask, size_t n);
+    void   (*fill)(Val *d, Val v, const int32_t *mask, size_t n);
+    void   (*copy)(Val *d, const Val *s, const int32_t *mask, size_t n);
+    // out = mask & (a == 0); liefert die Anzahl gesetzter Lanes
+    size_t (*zero_mask)(const Val *a, const int32_t *mask, int32_t *out, size_t n);
+
+    // Blockoperationen für den linearen Speicher: beliebige Länge und Ausrichtung
+    void   (*fill_n)(Val *d, Val v, size_t n);
+    Val    (*sum)(const Val *a, size_t n);          // Summe mit int32-Überlauf
+    Val    (*max)(const Val *a, size_t n);          // n = 0: INT32_MIN
+
+    // Filter für Sample-Streams
+    size_t (*count_gt)(const Val *a, Val thr, size_t n);
+    // y[i] = (sum_k c[k]*x[i+taps-1-k]) >> 15 mit Summe modulo 2^32; x hat n+taps-1 Werte
+    void   (*fir)(Val *y, const Val *x, const Val *c, size_t taps, size_t n);
+} VsimdOps;
+
+// Erkennt die CPU beim ersten Aufruf; MOTE_SIMD=avx2|sse4|generic|scalar erzwingt eine Variante
+const VsimdOps *vsimd_ops(void);
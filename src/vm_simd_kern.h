@@ -0,0 +1,149 @@
+// Kernel-Vorlage für vm_simd.c – wird je Zielarchitektur einmal eingebunden.
+// Erwartet: VS_SFX (Namenssuffix) und VS_ATTR (Funktionsattribut, z. B. target("avx2")).
+// Die GCC-Vektorerweiterungen werden vom Compiler passend zum Ziel übersetzt.
+
+#define VS_CAT2(a,b) a##_##b
+#define VS_CAT(a,b)  VS_CAT2(a,b)
+#define VS_FN(name)  VS_CAT(name, VS_SFX)
+
+// Maske anwenden: r, wo k gesetzt, sonst alter Wert
+#define VS_BLEND(old, r, k) (((r) & (k)) | ((old) & ~(k)))
+
+VS_ATTR static void VS_FN(vs_binop)(Op op, Val *a, const Val *b, const int32_t *mask, size_t n){
+    const v8si one = (v8si){1,1,1,1,1,1,1,1}, zero = (v8si){0};
+    for (size_t i=0; i<n; i+=VSIMD_WIDTH){
+        v8si x = *(v8si*)(a+i), y = *(const v8si*)(b+i), r;
+        switch (op){
+            case OP_ADD: r = (v8si)((v8su)x + (v8su)y); break;   // Überlauf wie int32-Wraparound
+            case OP_SUB: r = (v8si)((v8su)x - (v8su)y); break;
+            case OP_MUL: r = (v8si)((v8su)x * (v8su)y); break;
+            case OP_LT:  r = (x <  y) & one; break;
+            case OP_EQ:  r = (x == y) & one; break;
+            case OP_GT:  r = (x >  y) & one; break;
+            case OP_GE:  r = (x >= y) & one; break;
+            case OP_LE:  r = (x <= y) & one; break;
+            case OP_NE:  r = (x != y) & one; break;
+            case OP_AND: r = ((x != zero) & (y != zero)) & one; break;
+            case OP_OR:  r = ((x != zero) | (y != zero)) & one; break;
+            case OP_BAND: r = x & y; break;
+            case OP_BOR:  r = x | y; break;
+            case OP_BXOR: r = x ^ y; break;
+            case OP_SHL:  r = (v8si)((v8su)x << (v8su)(y & 31)); break;
+            case OP_SHR:  r = x >> (y & 31); break;
+            default: return;
+        }
+        if (mask){ v8si k = *(const v8si*)(mask+i); r = VS_BLEND(x, r, k); }
+        *(v8si*)(a+i) = r;
+    }
+}
+
+VS_ATTR static void VS_FN(vs_not)(Val *a, const int32_t *mask, size_t n){
+    const v8si one = (v8si){1,1,1,1,1,1,1,1}, zero = (v8si){0};
+    for (size_t i=0; i<n; i+=VSIMD_WIDTH){
+        v8si x = *(v8si*)(a+i), r = (x == zero) & one;
+        if (mask){ v8si k = *(const v8si*)(mask+i); r = VS_BLEND(x, r, k); }
+        *(v8si*)(a+i) = r;
+    }
+}
+
+VS_ATTR static void VS_FN(vs_fill)(Val *d, Val v, const int32_t *mask, size_t n){
+    v8si r = (v8si){v,v,v,v,v,v,v,v};
+    for (size_t i=0; i<n; i+=VSIMD_WIDTH){
+        v8si x = *(v8si*)(d+i), o = r;
+        if (mask){ v8si k = *(const v8si*)(mask+i); o = VS_BLEND(x, r, k); }
+        *(v8si*)(d+i) = o;
+    }
+}
+
+VS_ATTR static void VS_FN(vs_copy)(Val *d, const Val *s, const int32_t *mask, size_t n){
+    for (size_t i=0; i<n; i+=VSIMD_WIDTH){
+        v8si r = *(const v8si*)(s+i);
+        if (mask){ v8si x = *(v8si*)(d+i), k = *(const v8si*)(mask+i); r = VS_BLEND(x, r, k); }
+        *(v8si*)(d+i) = r;
+    }
+}
+
+VS_ATTR static size_t VS_FN(vs_zero_mask)(const Val *a, const int32_t *mask, int32_t *out, size_t n){
+    const v8si zero = (v8si){0};
+    v8si cnt = zero;
+    for (size_t i=0; i<n; i+=VSIMD_WIDTH){
+        v8si z = *(const v8si*)(a+i) == zero;
+        if (mask) z &= *(const v8si*)(mask+i);
+        *(v8si*)(out+i) = z;
+        cnt -= z;                                  // -1 je Treffer
+    }
+    size_t c = 0;
+    for (int k=0;k<VSIMD_WIDTH;k++) c += (size_t)cnt[k];
+    return c;
+}
+
+// ---- Blockoperationen: unausgerichtet, Rest skalar ----
+
+VS_ATTR static void VS_FN(vs_fill_n)(Val *d, Val v, size_t n){
+    v8si r = (v8si){v,v,v,v,v,v,v,v};
+    size_t i = 0;
+    for (; i+VSIMD_WIDTH <= n; i+=VSIMD_WIDTH) *(v8si_u*)(d+i) = r;
+    for (; i<n; i++) d[i] = v;
+}
+
+VS_ATTR static Val VS_FN(vs_sum)(const Val *a, size_t n){
+    v8su acc = (v8su){0};
+    size_t i = 0;
+    for (; i+VSIMD_WIDTH <= n; i+=VSIMD_WIDTH) acc += *(const v8su_u*)(a+i);
+    uint32_t s = 0;
+    for (int k=0;k<VSIMD_WIDTH;k++) s += acc[k];
+    for (; i<n; i++) s += (uint32_t)a[i];
+    return (Val)s;
+}
+
+VS_ATTR static Val VS_FN(vs_max)(const Val *a, size_t n){
+    v8si m = (v8si){INT32_MIN,INT32_MIN,INT32_MIN,INT32_MIN,INT32_MIN,INT32_MIN,INT32_MIN,INT32_MIN};
+    size_t i = 0;
+    for (; i+VSIMD_WIDTH <= n; i+=VSIMD_WIDTH){
+        v8si x = *(const v8si_u*)(a+i), k = x > m;
+        m = VS_BLEND(m, x, k);
+    }
+    Val r = INT32_MIN;
+    for (int k=0;k<VSIMD_WIDTH;k++) if (m[k] > r) r = m[k];
+    for (; i<n; i++) if (a[i] > r) r = a[i];
+    return r;
+}
+
+// ---- Filter: 8 Ausgaben je Durchlauf, Koeffizient als Skalar in alle Lanes ----
+
+VS_ATTR static size_t VS_FN(vs_count_gt)(const Val *a, Val thr, size_t n){
+    v8si t = (v8si){thr,thr,thr,thr,thr,thr,thr,thr}, k = (v8si){0};
+    size_t i = 0;
+    for (; i+VSIMD_WIDTH <= n; i+=VSIMD_WIDTH) k -= *(const v8si_u*)(a+i) > t;   // Maske ist -1
+    size_t r = 0;
+    for (int j=0;j<VSIMD_WIDTH;j++) r += (uint32_t)k[j];
+    for (; i<n; i++) r += a[i] > thr;
+    return r;
+}
+
+VS_ATTR static void VS_FN(vs_fir)(Val *y, const Val *x, const Val *c, size_t taps, size_t n){
+    size_t i = 0;
+    for (; i+VSIMD_WIDTH <= n; i+=VSIMD_WIDTH){
+        v8su acc = (v8su){0};
+        for (size_t k=0;k<taps;k++){
+            uint32_t ck = (uint32_t)c[k];
+            acc += (v8su){ck,ck,ck,ck,ck,ck,ck,ck} * *(const v8su_u*)(x+i+taps-1-k);
+        }
+        *(v8si_u*)(y+i) = (v8si)acc >> 15;
+    }
+    for (; i<n; i++){
+        uint32_t acc = 0;
+        for (size_t k=0;k<taps;k++) acc += (uint32_t)c[k] * (uint32_t)x[i+taps-1-k];
+        y[i] = (Val)acc >> 15;
+    }
+}
+
+static const VsimdOps VS_FN(vsimd_ops) = {
+    VS_NAME, VS_FN(vs_binop), VS_FN(vs_not), VS_FN(vs_fill), VS_FN(vs_copy), VS_FN(vs_zero_mask),
+    VS_FN(vs_fill_n), VS_FN(vs_sum), VS_FN(vs_max), VS_FN(vs_count_gt), VS_FN(vs_fir)
+};
+
+#undef VS_FN
+#undef VS_CAT
+#undef VS_CAT2
+#undef VS_BLEND
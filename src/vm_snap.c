@@ -0,0 +1,231 @@
+// vm_snap.c – Snapshots, Copy-on-Write-Forks und Snapshot-Dateien (siehe vm_snap.h)
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE           // memfd_create
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm_snap.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define SNAP_MMAP 1
+#endif
+
+#define HDR 72
+#define ALIGN8(x) (((x) + 7) & ~(uint32_t)7)
+
+struct VmSnap {
+    const uint8_t *code;
+    size_t code_len;
+    size_t size;              // Gesamtgröße des Blocks
+    uint8_t *base;            // Block, nur lesend (mmap) bzw. malloc ohne SNAP_MMAP
+    int fd;                   // Quelle für Forks
+};
+
+// Ein Fork: die VM vorne, damit VM* und Fork* austauschbar sind
+typedef struct { VM vm; const VmSnap *snap; uint8_t *map; } Fork;
+
+static uint32_t rd_u32(const uint8_t *p){ return (uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24; }
+static uint16_t rd_u16(const uint8_t *p){ return (uint16_t)(p[0] | p[1]<<8); }
+static void wr_u32(uint8_t *p, uint32_t v){ for(int i=0;i<4;i++) p[i]=(uint8_t)(v>>(8*i)); }
+static void wr_u16(uint8_t *p, uint16_t v){ p[0]=(uint8_t)v; p[1]=(uint8_t)(v>>8); }
+
+static uint32_t fnv1a(const uint8_t *p, size_t n){
+    uint32_t h = 2166136261u;
+    for (size_t i=0;i<n;i++){ h ^= p[i]; h *= 16777619u; }
+    return h;
+}
+
+// Kopf prüfen: passt er zum Code und liegen alle Arrays im Block?
+static int hdr_check(const uint8_t *b, size_t size, const uint8_t *code, size_t code_len){
+    if (size < HDR || memcmp(b, "MSNP", 4) || rd_u16(b+4) != VM_SNAP_VERSION || rd_u16(b+6) != HDR) return -1;
+    if (rd_u32(b+8) != code_len || rd_u32(b+12) != fnv1a(code, code_len)) return -1;
+    if (rd_u32(b+60) != size) return -1;
+    uint64_t st = rd_u32(b+44), lo = rd_u32(b+48), ca = rd_u32(b+52), ir = rd_u32(b+56);
+    if (st + 4ull*rd_u32(b+32) > size || lo + 4ull*rd_u32(b+36) > size || ca + 4ull*rd_u32(b+40) > size) return -1;
+    uint64_t me = rd_u32(b+68);
+    if (ir && ir + VM_MAX_IRQ*sizeof(VmIrq) > size) return -1;
+    if (me + 4ull*rd_u32(b+64) > size) return -1;
+    if (rd_u32(b+20) > rd_u32(b+32) || rd_u32(b+24) > rd_u32(b+40) || (st|lo|ca|ir|me) & 7) return -1;
+    // Interrupt-Zustand: höchstens VM_MAX_IRQ Einträge, nur mit Tabelle; ip im Code
+    if (b[28] > VM_MAX_IRQ || (b[28] && !ir) || b[29] > 1 || rd_u32(b+16) > code_len) return -1;
+    return 0;
+}
+
+// VM-Felder aus einem Block (Kopf + Arrays an base) herstellen
+static void vm_from_block(VM *vm, const VmSnap *s, uint8_t *base){
+    const uint8_t *h = s->base;
+    vm->code = s->code; vm->code_len = (uint32_t)s->code_len;
+    vm->ip = rd_u32(h+16); vm->sp = rd_u32(h+20); vm->csp = rd_u32(h+24);
+    vm->nirq = h[28]; vm->in_irq = h[29];
+    vm->stack_cap = rd_u32(h+32); vm->locals_cap = rd_u32(h+36); vm->call_cap = rd_u32(h+40);
+    vm->stack = (Val*)(base + rd_u32(h+44));
+    vm->locals = (Val*)(base + rd_u32(h+48));
+    vm->callstack = (uint32_t*)(base + rd_u32(h+52));
+    vm->irq = rd_u32(h+56) ? (VmIrq*)(base + rd_u32(h+56)) : NULL;
+    vm->mem_cap = rd_u32(h+64);
+    vm->mem = (Val*)(base + rd_u32(h+68));
+}
+
+// Übernimmt einen fertigen Block (malloc) als Snapshot
+static VmSnap *snap_adopt(uint8_t *blob, size_t size, const uint8_t *code, size_t code_len){
+    VmSnap *s = (VmSnap*)calloc(1, sizeof(VmSnap));
+    if (!s){ free(blob); return NULL; }
+    s->code = code; s->code_len = code_len; s->size = size; s->fd = -1;
+#ifdef SNAP_MMAP
+#if defined(__linux__)
+    int fd = memfd_create("mote-snap", MFD_CLOEXEC);
+#else
+    char tmpl[] = "/tmp/mote-snap-XXXXXX";
+    int fd = mkstemp(tmpl);
+    if (fd >= 0) unlink(tmpl);
+#endif
+    uint8_t *base = MAP_FAILED;
+    if (fd >= 0 && write(fd, blob, size) == (ssize_t)size)
+        base = (uint8_t*)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    free(blob);
+    if (base == MAP_FAILED){ if (fd >= 0) close(fd); free(s); return NULL; }
+    s->fd = fd; s->base = base;
+#else
+    s->base = blob;
+#endif
+    return s;
+}
+
+VmSnap *vm_snapshot(const VM *vm){
+    uint32_t off_stack = HDR;
+    uint32_t off_locals = off_stack + vm->stack_cap*4;
+    uint32_t off_calls = ALIGN8(off_locals + vm->locals_cap*4);
+    uint32_t end = off_calls + vm->call_cap*4;
+    uint32_t off_irq = vm->irq ? ALIGN8(end) : 0;
+    if (vm->irq) end = off_irq + VM_MAX_IRQ*sizeof(VmIrq);
+    uint32_t off_mem = ALIGN8(end);
+    uint32_t size = ALIGN8(off_mem + vm->mem_cap*4);
+
+    uint8_t *b = (uint8_t*)calloc(1, size);
+    if (!b) return NULL;
+    memcpy(b, "MSNP", 4); wr_u16(b+4, VM_SNAP_VERSION); wr_u16(b+6, HDR);
+    wr_u32(b+8, vm->code_len); wr_u32(b+12, fnv1a(vm->code, vm->code_len));
+    wr_u32(b+16, vm->ip); wr_u32(b+20, vm->sp); wr_u32(b+24, vm->csp);
+    b[28] = vm->nirq; b[29] = vm->in_irq;
+    wr_u32(b+32, vm->stack_cap); wr_u32(b+36, vm->locals_cap); wr_u32(b+40, vm->call_cap);
+    wr_u32(b+44, off_stack); wr_u32(b+48, off_locals); wr_u32(b+52, off_calls); wr_u32(b+56, off_irq);
+    wr_u32(b+60, size); wr_u32(b+64, vm->mem_cap); wr_u32(b+68, off_mem);
+    memcpy(b+off_stack, vm->stack, (size_t)vm->sp*sizeof(Val));          // oberhalb sp ohne Bedeutung
+    memcpy(b+off_locals, vm->locals, (size_t)vm->locals_cap*sizeof(Val));
+    memcpy(b+off_calls, vm->callstack, (size_t)vm->csp*sizeof(uint32_t));
+    if (vm->irq) memcpy(b+off_irq, vm->irq, VM_MAX_IRQ*sizeof(VmIrq));
+    if (vm->mem_cap) memcpy(b+off_mem, vm->mem, (size_t)vm->mem_cap*sizeof(Val));
+    return snap_adopt(b, size, vm->code, vm->code_len);
+}
+
+void vm_snap_free(VmSnap *s){
+    if (!s) return;
+#ifdef SNAP_MMAP
+    munmap(s->base, s->size); close(s->fd);
+#else
+    free(s->base);
+#endif
+    free(s);
+}
+
+int vm_snap_save(const VmSnap *s, const char *path){
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int ok = fwrite(s->base, 1, s->size, f) == s->size;
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+VmSnap *vm_snap_open(const char *path, const uint8_t *code, size_t code_len){
+#ifdef SNAP_MMAP
+    // Die Datei selbst dient als Quelle der Forks: nichts wird eingelesen
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    uint8_t *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= HDR)
+        base = (uint8_t*)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED){ close(fd); return NULL; }
+    if (hdr_check(base, (size_t)st.st_size, code, code_len) != 0){
+        munmap(base, (size_t)st.st_size); close(fd); return NULL;
+    }
+    VmSnap *s = (VmSnap*)calloc(1, sizeof(VmSnap));
+    if (!s){ munmap(base, (size_t)st.st_size); close(fd); return NULL; }
+    s->code = code; s->code_len = code_len; s->size = (size_t)st.st_size;
+    s->base = base; s->fd = fd;
+    return s;
+#else
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END); long n = ftell(f); fseek(f, 0, SEEK_SET);
+    uint8_t *b = n >= HDR ? (uint8_t*)malloc((size_t)n) : NULL;
+    int ok = b && fread(b, 1, (size_t)n, f) == (size_t)n;
+    fclose(f);
+    if (!ok || hdr_check(b, (size_t)n, code, code_len) != 0){ free(b); return NULL; }
+    return snap_adopt(b, (size_t)n, code, code_len);
+#endif
+}
+
+VM *vm_fork(const VmSnap *s, void *hal){
+    Fork *F = (Fork*)calloc(1, sizeof(Fork));
+    if (!F) return NULL;
+#ifdef SNAP_MMAP
+    uint8_t *map = (uint8_t*)mmap(NULL, s->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, s->fd, 0);
+    if (map == MAP_FAILED){ free(F); return NULL; }
+#else
+    uint8_t *map = (uint8_t*)malloc(s->size);
+    if (!map){ free(F); return NULL; }
+    memcpy(map, s->base, s->size);
+#endif
+    F->snap = s; F->map = map;
+    vm_from_block(&F->vm, s, map);
+    F->vm.hal = hal;
+    return &F->vm;
+}
+
+void vm_fork_reset(VM *fork){
+    Fork *F = (Fork*)fork;
+    const VmSnap *s = F->snap;
+#ifdef SNAP_MMAP
+    // Neu einblenden an gleicher Stelle: private Kopien verfallen, Seiten sind wieder geteilt
+    void *m = mmap(F->map, s->size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, s->fd, 0);
+    if (m == MAP_FAILED) memcpy(F->map, s->base, s->size);
+#else
+    memcpy(F->map, s->base, s->size);
+#endif
+    void *hal = F->vm.hal;
+    vm_from_block(&F->vm, s, F->map);
+    F->vm.hal = hal;
+}
+
+void vm_fork_free(VM *fork){
+    if (!fork) return;
+    Fork *F = (Fork*)fork;
+#ifdef SNAP_MMAP
+    munmap(F->map, F->snap->size);
+#else
+    free(F->map);
+#endif
+    free(F);
+}
+
+int vm_restore(VM *vm, const VmSnap *s){
+    VM v;
+    vm_from_block(&v, s, s->base);
+    if (vm->stack_cap < v.sp || vm->locals_cap < v.locals_cap || vm->call_cap < v.csp) return -1;
+    if (v.nirq && (!vm->irq || !v.irq)) return -1;   // sonst bliebe die alte Tabelle des Aufrufers aktiv
+    if (vm->mem_cap < v.mem_cap) return -1;
+    memcpy(vm->stack, v.stack, (size_t)v.sp*sizeof(Val));
+    memcpy(vm->locals, v.locals, (size_t)v.locals_cap*sizeof(Val));
+    memcpy(vm->callstack, v.callstack, (size_t)v.csp*sizeof(uint32_t));
+    if (vm->irq && v.irq) memcpy(vm->irq, v.irq, VM_MAX_IRQ*sizeof(VmIrq));
+    memcpy(vm->mem, v.mem, (size_t)v.mem_cap*sizeof(Val));
+    vm->code = s->code; vm->code_len = (uint32_t)s->code_len;
+    vm->ip = v.ip; vm->sp = v.sp; vm->csp = v.csp;
+    vm->nirq = v.nirq; vm->in_irq = v.in_irq;
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "vm.h"
+
+// Snapshots einer laufenden Instanz und Forks davon.
+//
+// Ein Snapshot ist ein zusammenhängender Block (Kopf, Stack, Locals,
+// Call-Stack, Interrupt-Tabelle, linearer Speicher) in einer anonymen Datei (memfd) oder einer
+// Snapshot-Datei auf der Platte. vm_fork() blendet diesen Block privat ein
+// (MAP_PRIVATE): alle Forks teilen sich die Seiten, bis einer schreibt – erst
+// dann kopiert der Kernel die betroffene Seite. Der Code wird nicht kopiert,
+// Forks zeigen auf denselben Code-Puffer.
+//
+// Das Blockformat ist zugleich das Dateiformat (vm_snap_save/vm_snap_open),
+// ein gespeicherter Snapshot lässt sich also ohne Einlesen wieder einblenden.
+// Nicht enthalten ist der Zustand der HAL; der gehört dem Host.
+//
+// Ohne mmap (_WIN32) werden Forks sofort vollständig kopiert.
+//
+// Dateiformat (Kopf little endian; die Arrays liegen im Host-Format, damit
+// sie direkt eingeblendet werden können):
+//   0   4  Magic "MSNP"
+//   4   2  Version (VM_SNAP_VERSION)
+//   6   2  Kopfgröße
+//   8   4  code_len      12  4  FNV-1a über den Code
+//   16  4  ip            20  4  sp            24  4  csp
+//   28  1  nirq          29  1  in_irq        30  2  reserviert
+//   32  4  stack_cap     36  4  locals_cap    40  4  call_cap
+//   44  4  Offset Stack  48  4  Offset Locals 52  4  Offset Call-Stack
+//   56  4  Offset Interrupt-Tabelle (0 = keine)
+//   60  4  Gesamtgröße
+//   64  4  mem_cap       68  4  Offset linearer Speicher
+//   danach Stack (Val), Locals (Val), Call-Stack (u32), Interrupt-Tabelle (VmIrq),
+//   linearer Speicher (Val)
+
+#define VM_SNAP_VERSION 2
+
+typedef struct VmSnap VmSnap;
+
+// Hält den aktuellen Zustand fest (vm läuft danach unverändert weiter)
+VmSnap *vm_snapshot(const VM *vm);
+void    vm_snap_free(VmSnap *s);
+
+// Speichert bzw. öffnet einen Snapshot als Datei. code muss derselbe Code
+// sein, mit dem der Snapshot entstand (wird über Länge und Prüfsumme geprüft).
+int     vm_snap_save(const VmSnap *s, const char *path);
+VmSnap *vm_snap_open(const char *path, const uint8_t *code, size_t code_len);
+
+// Neue Instanz im Zustand des Snapshots; Speicher wird erst beim Schreiben kopiert
+VM  *vm_fork(const VmSnap *s, void *hal);
+void vm_fork_reset(VM *fork);      // verwirft alle Änderungen seit vm_fork()
+void vm_fork_free(VM *fork);
+
+// Kopiert den Snapshot in eine beliebige VM mit ausreichender Kapazität; -1 sonst
+int vm_restore(VM *vm, const VmSnap *s);
@@ -0,0 +1,313 @@
+// vm_swap.c – Austausch im Betrieb (siehe vm_swap.h)
+#include "vm_swap.h"
+#include "vm_ops.h"
+#include "vm_analyze.h"
+#include "image.h"
+#include <stdatomic.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/stat.h>
+
+// Änderungszeit mit Nanosekunden: zwei Fassungen gleicher Größe in derselben Sekunde
+#if defined(__APPLE__)
+#define ST_MTIM(s) ((s).st_mtimespec)
+#else
+#define ST_MTIM(s) ((s).st_mtim)
+#endif
+static int same_mtim(struct timespec a, struct timespec b){ return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec; }
+
+#define NO_SITE UINT32_MAX
+
+typedef struct { uint32_t from, to, n; uint8_t mem; } Copy;
+
+typedef struct VmProg {
+    uint8_t *file;
+    MoteImage img;
+    MoteSlot *slot; int nslot;
+    MoteYield *yield; int nyield;
+    uint8_t irq;
+    // Puffer der Instanz, nach dem Bedarf dieses Programms
+    Val *stack, *locals, *mem; uint32_t *calls;
+    uint32_t stack_cap, locals_cap, call_cap, mem_cap;
+    // Übergang von base: Zustandskopien und neue Adresse je alter Yield-Stelle
+    struct VmProg *base;
+    Copy *copy; int ncopy;
+    uint32_t *site;
+    struct VmProg *next;      // Liste ausgemusterter Programme
+} VmProg;
+
+struct VmSwap {
+    _Atomic(VmProg*) cur;              // schreibt nur der VM-Thread (apply), prepare liest es
+    _Atomic(VmProg*) pending;
+    _Atomic(VmProg*) retired;          // vom VM-Thread abgelegt, freigegeben beim nächsten prepare/close
+    VmSwapStats st;
+    VmIrq irq[VM_MAX_IRQ];
+    // Überwachung
+    pthread_t th; int watching;
+    atomic_int stop;
+    char *path; int poll_ms;
+};
+
+static void fail(char *err, size_t errlen, const char *fmt, ...){
+    va_list ap; va_start(ap, fmt);
+    if (err && errlen) vsnprintf(err, errlen, fmt, ap);
+    va_end(ap);
+}
+
+static uint64_t now_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Seiten jetzt anfassen, nicht erst beim Kopieren in der Pause
+static void prefault(Val *p, uint32_t n){
+    for (uint32_t i=0; i<n; i+=1024) ((volatile Val*)p)[i] = 0;
+}
+
+static void prog_free(VmProg *P){
+    if (!P) return;
+    free(P->stack); free(P->locals); free(P->mem); free(P->calls);
+    free(P->slot); free(P->yield); free(P->copy); free(P->site);
+    free(P->file); free(P);
+}
+
+// Jede Instruktion dekodierbar, Sprungziele auf Instruktionsanfängen,
+// Natives bekannt, Locals-Indizes im META-Bereich
+static int code_check(const MoteImage *img, uint8_t *insn, char *err, size_t errlen){
+    const uint8_t *c = img->code; size_t len = img->code_len;
+    for (size_t ip=0; ip<len; ){
+        int ol = vm_op_operand_len(c[ip]);
+        if (ol < 0 || ip+1+ol > len){ fail(err, errlen, "ungültige Instruktion bei %04zX", ip); return -1; }
+        insn[ip] = 1;
+        if ((c[ip] == OP_LOADL || c[ip] == OP_STOREL) && img->meta.nlocals && c[ip+1] >= img->meta.nlocals){
+            fail(err, errlen, "Local %u bei %04zX außerhalb von META", c[ip+1], ip); return -1;
+        }
+        if (c[ip] == OP_CALL && vm_native_args(c[ip+1]) < 0){
+            fail(err, errlen, "unbekannter Native %u bei %04zX", c[ip+1], ip); return -1;
+        }
+        ip += 1+ol;
+    }
+    for (size_t ip=0; ip<len; ip += 1+vm_op_operand_len(c[ip])){
+        if (c[ip] != OP_JMP && c[ip] != OP_JZ && c[ip] != OP_CALLUSER) continue;
+        int32_t t; memcpy(&t, c+ip+1, 4);
+        if (t < 0 || (size_t)t > len || ((size_t)t < len && !insn[t])){
+            fail(err, errlen, "Sprungziel %d bei %04zX liegt nicht auf einer Instruktion", t, ip); return -1;
+        }
+    }
+    return 0;
+}
+
+// Image zerlegen, prüfen und Puffer anlegen; file geht in den Besitz über.
+// Das erste Image läuft wie bisher auch ungeprüft, dann ohne Yield-Stellen.
+static VmProg *prog_load(uint8_t *file, size_t len, int strict, char *err, size_t errlen){
+    VmProg *P = (VmProg*)calloc(1, sizeof(VmProg));
+    P->file = file;
+    if (mote_image_parse(&P->img, file, len) != 0){ fail(err, errlen, "defekter Image-Header"); goto bad; }
+    const MoteImage *img = &P->img;
+    P->nslot = mote_slots_decode(mote_image_find(img, "SLOT"), &P->slot);
+    P->nyield = mote_yields_decode(mote_image_find(img, "YELD"), &P->yield);
+    if (P->nslot < 0 || P->nyield < 0){ fail(err, errlen, "defekte SLOT- oder YELD-Sektion"); goto bad; }
+
+    char msg[160];
+    uint8_t *insn = (uint8_t*)calloc(img->code_len+1, 1);
+    int ok = code_check(img, insn, msg, sizeof msg) == 0;
+    for (int i=0; ok && i<P->nyield; i++){
+        uint32_t a = P->yield[i].addr;
+        if (a < 2 || a > img->code_len || !insn[a-2] || img->code[a-2] != OP_CALL || img->code[a-1] != NAT_YIELD){
+            fail(msg, sizeof msg, "Yield-Stelle %u (Adresse %u) steht nicht hinter CALL yield", P->yield[i].id, a);
+            ok = 0;
+        }
+    }
+    free(insn);
+    if (!ok && strict){ fail(err, errlen, "%s", msg); goto bad; }
+    if (!ok && P->nyield) fprintf(stderr, "vm_swap: %s, kein Austausch möglich\n", msg);
+    if (!ok) P->nyield = 0;
+
+    VmNeeds need;
+    if (vm_analyze(img->code, img->code_len, &need) != 0)
+        fprintf(stderr, "vm_swap: Stackbedarf nicht bestimmbar, nehme %u/%u\n", need.stack_max, need.call_max);
+    P->irq = need.irq;
+    P->stack_cap  = need.stack_max;
+    P->call_cap   = need.call_max;
+    P->locals_cap = img->meta.nlocals ? img->meta.nlocals : 256;
+    P->mem_cap    = img->meta.mem;
+    for (int i=0; i<P->nslot; i++){
+        const MoteSlot *s = &P->slot[i];
+        uint32_t cap = s->kind == MOTE_SLOT_ARRAY ? P->mem_cap : P->locals_cap;
+        if (s->at > cap || s->len > cap - s->at){ fail(err, errlen, "SLOT-Eintrag %s außerhalb", s->name); goto bad; }
+    }
+    P->stack  = (Val*)calloc(P->stack_cap ? P->stack_cap : 1, sizeof(Val));
+    P->locals = (Val*)calloc(P->locals_cap, sizeof(Val));
+    P->calls  = (uint32_t*)calloc(P->call_cap ? P->call_cap : 1, sizeof(uint32_t));
+    P->mem    = (Val*)calloc(P->mem_cap ? P->mem_cap : 1, sizeof(Val));
+    if (!P->stack || !P->locals || !P->calls || !P->mem){ fail(err, errlen, "kein Speicher"); goto bad; }
+    prefault(P->mem, P->mem_cap);
+    return P;
+bad:
+    prog_free(P);
+    return NULL;
+}
+
+// Übergang von B nach N: Zustand nach Namen, Yield-Stellen nach id
+static int plan(VmProg *N, VmProg *B, char *err, size_t errlen){
+    N->base = B;
+    N->copy = (Copy*)malloc((N->nslot ? N->nslot : 1)*sizeof(Copy));
+    for (int i=0; i<N->nslot; i++){
+        const MoteSlot *s = &N->slot[i];
+        for (int j=0; j<B->nslot; j++){
+            const MoteSlot *o = &B->slot[j];
+            if (o->kind != s->kind || strcmp(o->name, s->name)) continue;
+            Copy *c = &N->copy[N->ncopy++];
+            c->from = o->at; c->to = s->at; c->n = o->len < s->len ? o->len : s->len;
+            c->mem = s->kind == MOTE_SLOT_ARRAY;
+            break;
+        }
+    }
+    N->site = (uint32_t*)malloc((B->nyield ? B->nyield : 1)*sizeof(uint32_t));
+    int any = 0;
+    for (int i=0; i<B->nyield; i++){
+        N->site[i] = NO_SITE;
+        for (int j=0; j<N->nyield; j++)
+            if (N->yield[j].id == B->yield[i].id){ N->site[i] = N->yield[j].addr; any = 1; break; }
+    }
+    if (!any){ fail(err, errlen, "keine gemeinsame Yield-Stelle mit dem laufenden Programm"); return -1; }
+    return 0;
+}
+
+static void retire(VmSwap *S, VmProg *P){
+    VmProg *h = atomic_load(&S->retired);
+    do P->next = h; while (!atomic_compare_exchange_weak(&S->retired, &h, P));
+}
+
+static void free_retired(VmSwap *S){
+    VmProg *P = atomic_exchange(&S->retired, NULL);
+    while (P){ VmProg *n = P->next; prog_free(P); P = n; }
+}
+
+static void bind(VM *vm, VmSwap *S, VmProg *P){
+    vm->code = P->img.code; vm->code_len = (uint32_t)P->img.code_len;
+    vm->stack = P->stack; vm->stack_cap = P->stack_cap;
+    vm->locals = P->locals; vm->locals_cap = P->locals_cap;
+    vm->callstack = P->calls; vm->call_cap = P->call_cap;
+    vm->mem = P->mem; vm->mem_cap = P->mem_cap;
+    vm->irq = P->irq ? S->irq : NULL;
+}
+
+VmSwap *vm_swap_open(VM *vm, uint8_t *file, size_t len, void *hal, char *err, size_t errlen){
+    VmProg *P = prog_load(file, len, 0, err, errlen);
+    if (!P) return NULL;
+    VmSwap *S = (VmSwap*)calloc(1, sizeof(VmSwap));
+    atomic_init(&S->cur, P);
+    atomic_init(&S->pending, NULL); atomic_init(&S->retired, NULL); atomic_init(&S->stop, 0);
+    memset(vm, 0, sizeof(*vm));
+    bind(vm, S, P);
+    vm->hal = hal;
+    return S;
+}
+
+int vm_swap_prepare(VmSwap *S, uint8_t *file, size_t len, char *err, size_t errlen){
+    free_retired(S);
+    VmProg *N = prog_load(file, len, 1, err, errlen);
+    if (!N) return -1;
+    // cur wird nur gelesen; tauscht der VM-Thread inzwischen, passt base nicht mehr und apply verwirft.
+    // Ein ausgemustertes cur gibt erst das nächste prepare in diesem Thread frei.
+    VmProg *O = atomic_load_explicit(&S->cur, memory_order_acquire);
+    if (plan(N, O, err, errlen) != 0){ prog_free(N); return -1; }
+    VmProg *old = atomic_exchange(&S->pending, N);
+    prog_free(old);
+    return 0;
+}
+
+int vm_swap_apply(VmSwap *S, VM *vm){
+    if (!atomic_load_explicit(&S->pending, memory_order_relaxed)) return 0;
+    VmProg *N = atomic_exchange(&S->pending, NULL);     // gehört ab hier diesem Thread
+    if (!N) return 0;
+    VmProg *O = atomic_load_explicit(&S->cur, memory_order_relaxed);   // eigener Thread
+    if (N->base != O || vm->nirq){ retire(S, N); S->st.dropped++; return -1; }
+    int k = 0;
+    while (k < O->nyield && O->yield[k].addr != vm->ip) k++;
+    if (vm->csp || vm->in_irq || vm->sp > N->stack_cap || k == O->nyield || N->site[k] == NO_SITE){
+        VmProg *none = NULL;                            // nicht hier: zurücklegen, außer es kam ein neueres
+        if (!atomic_compare_exchange_strong(&S->pending, &none, N)) retire(S, N);
+        return 0;
+    }
+
+    uint64_t t0 = now_ns();
+    memcpy(N->stack, vm->stack, vm->sp*sizeof(Val));
+    for (int i=0; i<N->ncopy; i++){
+        const Copy *c = &N->copy[i];
+        if (c->mem) memcpy(N->mem + c->to, O->mem + c->from, c->n*sizeof(Val));
+        else        memcpy(N->locals + c->to, O->locals + c->from, c->n*sizeof(Val));
+    }
+    bind(vm, S, N);
+    vm->ip = N->site[k];
+    atomic_store_explicit(&S->cur, N, memory_order_release);
+    uint64_t dt = now_ns() - t0;
+
+    S->st.swaps++;
+    S->st.yield_id = O->yield[k].id;
+    S->st.pause_last_ns = dt; S->st.pause_sum_ns += dt;
+    if (dt > S->st.pause_max_ns) S->st.pause_max_ns = dt;
+    retire(S, O);
+    return 1;
+}
+
+void vm_swap_stats(const VmSwap *S, VmSwapStats *st){ *st = S->st; }
+
+// ---- Überwachung einer Image-Datei ----
+static uint8_t *read_all(const char *path, size_t *len){
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END); long n = ftell(f); fseek(f, 0, SEEK_SET);
+    uint8_t *d = n > 0 ? (uint8_t*)malloc((size_t)n) : NULL;
+    if (d && fread(d, 1, (size_t)n, f) != (size_t)n){ free(d); d = NULL; }
+    fclose(f);
+    *len = (size_t)n;
+    return d;
+}
+
+static void *watch_main(void *arg){
+    VmSwap *S = (VmSwap*)arg;
+    struct stat st;
+    struct timespec seen_m = {0}; off_t seen_s = -1;    // zuletzt verarbeitete Fassung
+    struct timespec cand_m;       off_t cand_s;         // beobachtete, noch nicht stabile Fassung
+    if (stat(S->path, &st) == 0){ seen_m = ST_MTIM(st); seen_s = st.st_size; }
+    cand_m = seen_m; cand_s = seen_s;
+    struct timespec ts = { S->poll_ms / 1000, (long)(S->poll_ms % 1000) * 1000000L };
+    while (!atomic_load(&S->stop)){
+        nanosleep(&ts, NULL);
+        if (stat(S->path, &st) != 0) continue;
+        if (same_mtim(ST_MTIM(st), seen_m) && st.st_size == seen_s) continue;
+        if (!same_mtim(ST_MTIM(st), cand_m) || st.st_size != cand_s){ cand_m = ST_MTIM(st); cand_s = st.st_size; continue; }
+        seen_m = cand_m; seen_s = cand_s;
+        size_t len; uint8_t *d = read_all(S->path, &len);
+        char err[160];
+        uint64_t t0 = now_ns();
+        if (!d) fprintf(stderr, "[swap] %s nicht lesbar\n", S->path);
+        else if (vm_swap_prepare(S, d, len, err, sizeof err) != 0) fprintf(stderr, "[swap] %s abgelehnt: %s\n", S->path, err);
+        else fprintf(stderr, "[swap] %s geprüft und vorbereitet (%.1f ms), wartet auf yield\n",
+                     S->path, (now_ns()-t0)*1e-6);
+    }
+    return NULL;
+}
+
+int vm_swap_watch(VmSwap *S, const char *path, int poll_ms){
+    if (S->watching) return -1;
+    S->path = strdup(path); S->poll_ms = poll_ms > 0 ? poll_ms : 200;
+    if (pthread_create(&S->th, NULL, watch_main, S) != 0){ free(S->path); S->path = NULL; return -1; }
+    S->watching = 1;
+    return 0;
+}
+
+void vm_swap_close(VmSwap *S){
+    if (!S) return;
+    if (S->watching){ atomic_store(&S->stop, 1); pthread_join(S->th, NULL); }
+    free_retired(S);
+    prog_free(atomic_exchange(&S->pending, NULL));
+    prog_free(atomic_load(&S->cur));
+    free(S->path); free(S);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "vm.h"
+
+// Programm im laufenden Betrieb austauschen
+//
+// Ein neues Image wird außerhalb des VM-Threads geladen, geprüft und
+// vorbereitet: Puffer nach dem Bedarf des neuen Programms anlegen, die
+// Zuordnung des Zustands und der Yield-Stellen berechnen. Eingesetzt wird
+// es erst, wenn die VM nach yield(id) zurückkehrt (VM_YIELD), im
+// Hauptprogramm steht (csp == 0, kein Handler aktiv) und das neue Image
+// eine Yield-Stelle mit derselben id hat. Die Pause besteht dann nur aus
+// dem Kopieren von Operanden-Stack, Locals und linearem Speicher.
+//
+// Zustand geht über die SLOT-Tabellen beider Images nach Namen über:
+// Locals und Arrays gleichen Namens (Arrays bis zur kleineren Länge),
+// alles andere beginnt bei 0. Eine Variable, die im alten Programm an der
+// Yield-Stelle nicht lebendig war, hat danach keinen verlässlichen Wert
+// (motec gibt nur den dort lebendigen einen eigenen Slot). Ohne YELD im
+// laufenden Image gibt es keine Austauschstelle. Programme mit registrierten Interrupt-Handlern werden
+// nicht getauscht, deren Adressen gehören zum alten Code.
+//
+// Threads: vm_swap_apply() nur im VM-Thread, vm_swap_prepare() aus genau
+// einem anderen (oder demselben) Thread, z. B. über vm_swap_watch().
+
+typedef struct VmSwap VmSwap;
+
+typedef struct {
+    uint32_t swaps;          // eingesetzte Images
+    uint32_t dropped;        // vorbereitet, aber nicht mehr passend (verworfen)
+    uint64_t pause_last_ns, pause_max_ns, pause_sum_ns;
+    uint32_t yield_id;       // Stelle des letzten Austauschs
+} VmSwapStats;
+
+// Erstes Image laden und vm darauf einrichten; die Puffer gehören danach
+// VmSwap. file (malloc) geht in jedem Fall in den Besitz über. NULL bei
+// Fehler, Meldung in err.
+VmSwap *vm_swap_open(VM *vm, uint8_t *file, size_t len, void *hal, char *err, size_t errlen);
+
+// Nächstes Image vorbereiten (ersetzt ein noch nicht eingesetztes);
+// Besitz von file wie oben. 0 bereit, -1 abgelehnt (Meldung in err).
+int vm_swap_prepare(VmSwap *S, uint8_t *file, size_t len, char *err, size_t errlen);
+
+// Hintergrund-Thread: prüft path alle poll_ms auf Änderungen und bereitet
+// die neue Fassung vor, sobald sie einen Takt lang unverändert ist.
+int vm_swap_watch(VmSwap *S, const char *path, int poll_ms);
+
+// Nach VM_YIELD aufrufen: 1 getauscht (vm läuft mit dem neuen Programm an
+// der passenden Yield-Stelle weiter), 0 nichts zu tun bzw. nicht hier,
+// -1 vorbereitetes Image verworfen.
+int vm_swap_apply(VmSwap *S, VM *vm);
+
+void vm_swap_stats(const VmSwap *S, VmSwapStats *st);
+void vm_swap_close(VmSwap *S);     // beendet auch den Überwachungs-Thread
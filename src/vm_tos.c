@@ -0,0 +1,242 @@
+// vm_tos.c – Dispatch-Schleife mit Top-of-Stack im Register (siehe vm_tos.h)
+#include "vm_tos.h"
+#include "hal.h"
+#include "vm_ops.h"
+#include "vm_simd.h"
+#include <string.h>
+
+// HAL-Bindung wie in vm.c; aus vm_interp.h kommen nur Natives und Interrupt-Hilfen
+#ifdef MOTE_STATIC_HAL
+#define VM_HAL_CALL(f, ...) mote_hal_##f(vm->hal, __VA_ARGS__)
+#else
+#define VM_HAL_CALL(f, ...) ((const struct HAL*)vm->hal)->f(vm->hal, __VA_ARGS__)
+#endif
+#include "vm_interp.h"
+
+// Registerzustand: ip, sp, tos. Bei sp > 0 ist tos der oberste Wert und
+// st[sp-1] veraltet; st[0..sp-1) ist aktuell. Bei sp == 0 ist tos bedeutungslos.
+#define SPILL()  do { if (sp) st[sp-1] = tos; vm->ip = ip; vm->sp = sp; } while (0)
+#define RELOAD() do { ip = vm->ip; sp = vm->sp; tos = sp ? st[sp-1] : 0; } while (0)
+#define EXIT(r)  do { SPILL(); return (r); } while (0)
+#define FETCH()  (ip < len ? code[ip++] : 0)
+
+// Push/Pop mit den Randfällen von SAFE_PUSH/SAFE_POP (voll: verwerfen, leer: 0)
+#define PUSH(v)  do { Val v_ = (v); if (sp < cap){ if (sp) st[sp-1] = tos; tos = v_; sp++; } } while (0)
+#define POP(x)   do { if (sp){ (x) = tos; if (--sp) tos = st[sp-1]; } else (x) = 0; } while (0)
+#define DROP1()  do { if (sp && --sp) tos = st[sp-1]; } while (0)
+
+// (a b -- e): im Normalfall ein Speicherzugriff, an den Stackgrenzen der lange Weg
+#define BIN(e) do { \
+        if (sp >= 2){ Val b = tos, a = st[sp-2]; sp--; tos = (e); } \
+        else { Val b, a; POP(b); POP(a); PUSH(e); } \
+    } while (0)
+
+// Dispatch: mit GCC/Clang springt jeder Handler selbst zum nächsten (ein
+// indirekter Sprung je Opcode, den die Sprungvorhersage getrennt lernt);
+// sonst switch. Mit dem einen gemeinsamen Sprung des switch geht der
+// Gewinn aus den Registern in Fehlvorhersagen unter.
+#if defined(__GNUC__)
+#define TOS_THREADED 1
+#define TOS_NOINLINE __attribute__((noinline))
+#define CASE(o)  L_##o
+#define OTHER    L_OTHER
+#define NEXT     do { if (ip >= len) goto end; uint8_t o_ = code[ip++]; goto *(o_ < OP_COUNT ? tbl[o_] : &&L_OTHER); } while (0)
+#else
+#define CASE(o)  case o
+#define OTHER    default
+#define NEXT     break
+#define TOS_NOINLINE
+#endif
+
+// Natives laufen ohnehin auf dem zurückgeschriebenen Zustand; außer Linie
+// gehalten, damit ihr Registerbedarf nicht die Dispatch-Schleife belastet.
+static TOS_NOINLINE VmRes tos_native(VM *vm, uint8_t idx){ return vm_native(vm, idx); }
+
+#define SAFEPOINT() do { \
+        if (vm->nirq && !vm->in_irq){ SPILL(); if (irq_poll(vm) < 0) return VM_TRAP; RELOAD(); } \
+    } while (0)
+
+VmRes vm_run_tos(VM *vm){
+
+    IRQ_SAFEPOINT();   // Fortsetzen nach VM_WAIT, noch auf dem VM-Zustand
+
+    const uint8_t *code = vm->code;
+    const uint32_t len = vm->code_len, cap = vm->stack_cap, ncap = vm->locals_cap, mcap = vm->mem_cap;
+    Val *st = vm->stack, *loc = vm->locals, *mem = vm->mem;
+    uint32_t ip, sp;
+    Val tos;
+    RELOAD();
+
+#ifdef TOS_THREADED
+    static void *const tbl[OP_COUNT] = {          // Reihenfolge wie Op
+        &&L_OP_HALT, &&L_OP_PUSHI, &&L_OP_LOADL, &&L_OP_STOREL,
+        &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV,
+        &&L_OP_JMP, &&L_OP_JZ, &&L_OP_CALL, &&L_OP_LT, &&L_OP_EQ,
+        &&L_OP_DUP, &&L_OP_DROP, &&L_OP_SWAP, &&L_OP_OVER,
+        &&L_OP_GT, &&L_OP_GE, &&L_OP_LE, &&L_OP_NE,
+        &&L_OP_NOT, &&L_OP_AND, &&L_OP_OR,
+        &&L_OP_CALLUSER, &&L_OP_RET, &&L_OP_LOADM, &&L_OP_STOREM,
+        &&L_OP_MOD, &&L_OP_SHL, &&L_OP_SHR, &&L_OP_BAND, &&L_OP_BOR, &&L_OP_BXOR,
+        &&L_OP_FMUL, &&L_OP_FDIV, &&L_OP_ADD64, &&L_OP_MUL64 };
+    NEXT;
+    {
+        {
+#else
+    while (ip < len){
+        switch ((Op)code[ip++]){
+#endif
+            CASE(OP_HALT):
+                EXIT(VM_OK);
+
+            CASE(OP_PUSHI): {
+                if (ip + 4 > len) EXIT(VM_TRAP);
+                Val v = rd_i32(code+ip);
+                ip += 4;
+                PUSH(v);
+            } NEXT;
+
+            CASE(OP_LOADL): {
+                uint8_t idx = FETCH();
+                if (idx >= ncap) EXIT(VM_TRAP);
+                PUSH(loc[idx]);
+            } NEXT;
+
+            CASE(OP_STOREL): {
+                uint8_t idx = FETCH();
+                if (idx >= ncap) EXIT(VM_TRAP);
+                Val v; POP(v); loc[idx] = v;
+            } NEXT;
+
+            CASE(OP_ADD): BIN(a+b); NEXT;
+            CASE(OP_SUB): BIN(a-b); NEXT;
+            CASE(OP_MUL): BIN(a*b); NEXT;
+            CASE(OP_DIV):
+                if (sp >= 2 && tos != 0){ Val a = st[sp-2]; sp--; tos = a / tos; }
+                else { Val b, a; POP(b); POP(a); if (b == 0) EXIT(VM_TRAP); PUSH(a/b); }
+                NEXT;
+            CASE(OP_MOD):
+                if (sp >= 2 && tos != 0){ Val a = st[sp-2]; sp--; tos = vm_mod(a, tos); }
+                else { Val b, a; POP(b); POP(a); if (b == 0) EXIT(VM_TRAP); PUSH(vm_mod(a,b)); }
+                NEXT;
+
+            CASE(OP_JMP): {
+                if (ip + 4 > len) EXIT(VM_TRAP);
+                uint32_t from = ip;
+                ip = (uint32_t)rd_i32(code+ip);
+                if (ip < from) SAFEPOINT();
+            } NEXT;
+
+            CASE(OP_JZ): {
+                if (ip + 4 > len) EXIT(VM_TRAP);
+                uint32_t addr = (uint32_t)rd_i32(code+ip);
+                ip += 4;
+                Val c; POP(c);
+                if (c == 0){
+                    uint32_t from = ip;
+                    ip = addr;
+                    if (ip < from) SAFEPOINT();
+                }
+            } NEXT;
+
+            CASE(OP_LT): BIN(a<b?1:0); NEXT;
+            CASE(OP_EQ): BIN(a==b?1:0); NEXT;
+            CASE(OP_GT): BIN(a>b?1:0); NEXT;
+            CASE(OP_GE): BIN(a>=b?1:0); NEXT;
+            CASE(OP_LE): BIN(a<=b?1:0); NEXT;
+            CASE(OP_NE): BIN(a!=b?1:0); NEXT;
+
+            CASE(OP_DUP):
+                if (sp && sp < cap){ st[sp-1] = tos; sp++; }
+                else { Val v; POP(v); PUSH(v); PUSH(v); }
+                NEXT;
+            CASE(OP_DROP): DROP1(); NEXT;
+            CASE(OP_SWAP):
+                if (sp >= 2){ Val a = st[sp-2]; st[sp-2] = tos; tos = a; }
+                else { Val b, a; POP(b); POP(a); PUSH(b); PUSH(a); }
+                NEXT;
+            CASE(OP_OVER):
+                if (sp >= 2 && sp < cap){ Val a = st[sp-2]; st[sp-1] = tos; tos = a; sp++; }
+                else { Val b, a; POP(b); POP(a); PUSH(a); PUSH(b); PUSH(a); }
+                NEXT;
+
+            CASE(OP_NOT):
+                if (sp) tos = tos == 0 ? 1 : 0;
+                else PUSH(1);
+                NEXT;
+            CASE(OP_AND): BIN((a!=0 && b!=0)?1:0); NEXT;
+            CASE(OP_OR):  BIN((a!=0 || b!=0)?1:0); NEXT;
+
+            CASE(OP_SHL):  BIN(vm_shl(a,b)); NEXT;
+            CASE(OP_SHR):  BIN(vm_shr(a,b)); NEXT;
+            CASE(OP_BAND): BIN(a & b); NEXT;
+            CASE(OP_BOR):  BIN(a | b); NEXT;
+            CASE(OP_BXOR): BIN(a ^ b); NEXT;
+            CASE(OP_FMUL): BIN(vm_fmul(a,b)); NEXT;
+            CASE(OP_FDIV): BIN(vm_fdiv(a,b)); NEXT;
+            CASE(OP_ADD64): CASE(OP_MUL64): {
+                Val bh, bl, ah, al;
+                if (sp >= 4){ bh = tos; bl = st[sp-2]; ah = st[sp-3]; al = st[sp-4]; sp -= 4; }
+                else { POP(bh); POP(bl); POP(ah); POP(al); if (sp) st[sp-1] = tos; }
+                uint64_t x = vm_pair(al,ah), y = vm_pair(bl,bh);
+                uint64_t r = code[ip-1] == OP_ADD64 ? x + y : x * y;
+                // st ist hier vollständig aktuell, Ergebnis wie mit SAFE_PUSH
+                if (sp < cap) st[sp++] = (Val)(uint32_t)r;
+                if (sp < cap){ tos = (Val)(uint32_t)(r >> 32); sp++; }
+                else if (sp) tos = st[sp-1];
+            } NEXT;
+
+            // Natives sehen den vollen Zustand
+            CASE(OP_CALL): {
+                uint8_t idx = FETCH();
+                SPILL();
+                VmRes r = tos_native(vm, idx);
+                if (r != VM_OK) return r;
+                RELOAD();
+            } NEXT;
+
+            CASE(OP_CALLUSER): {
+                if (ip + 4 > len) EXIT(VM_TRAP);
+                uint32_t addr = (uint32_t)rd_i32(code+ip);
+                ip += 4;
+                if (vm->csp >= vm->call_cap) EXIT(VM_TRAP);
+                vm->callstack[vm->csp++] = ip;
+                ip = addr;
+            } NEXT;
+
+            CASE(OP_RET): {
+                if (vm->csp == 0) EXIT(VM_OK);
+                uint32_t ra = vm->callstack[--vm->csp];
+                if (ra & VM_IRQ_FRAME){               // Handler fertig: Rückgabewert verwerfen
+                    DROP1();
+                    vm->in_irq = 0;
+                    ra &= ~VM_IRQ_FRAME;
+                }
+                ip = ra;
+                SAFEPOINT();
+            } NEXT;
+
+            CASE(OP_LOADM):
+                if (sp && (uint32_t)tos < mcap) tos = mem[(uint32_t)tos];
+                else { Val a; POP(a); if ((uint32_t)a >= mcap) EXIT(VM_TRAP); PUSH(mem[(uint32_t)a]); }
+                NEXT;
+            CASE(OP_STOREM):
+                if (sp >= 2 && (uint32_t)st[sp-2] < mcap){
+                    mem[(uint32_t)st[sp-2]] = tos;
+                    sp -= 2;
+                    if (sp) tos = st[sp-1];
+                } else {
+                    Val v, a; POP(v); POP(a);
+                    if ((uint32_t)a >= mcap) EXIT(VM_TRAP);
+                    mem[(uint32_t)a] = v;
+                }
+                NEXT;
+
+            OTHER:
+                EXIT(VM_TRAP);
+        }
+    }
+#ifdef TOS_THREADED
+end:
+#endif
+    EXIT(VM_TRAP);
+}
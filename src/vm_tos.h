@@ -0,0 +1,16 @@
+#pragma once
+#include "vm.h"
+
+// Interpreter mit Top-of-Stack im Register: ip, sp und der oberste
+// Stackwert liegen in lokalen Variablen, vm->stack hält nur die Werte
+// darunter. Binäre Operatoren lesen so einen Operanden aus dem Speicher
+// statt zwei und schreiben keinen zurück.
+//
+// Zurück in die VM geschrieben (ip, sp, stack[sp-1]) wird nur an Grenzen:
+// Natives (die HAL sieht den vollen Zustand), sichere Punkte mit
+// registrierten Interrupt-Handlern und jedes Verlassen der Funktion.
+// Ergebnis, ip, sp, stack[0..sp), Locals und Speicher sind danach bitgleich
+// zu vm_run(), auch bei Traps und den SAFE_PUSH/SAFE_POP-Eigenheiten an den
+// Stackgrenzen; nur verworfene Einträge oberhalb von sp können abweichen.
+// Mit GCC/Clang dispatcht jeder Handler selbst (computed goto), sonst switch.
+VmRes vm_run_tos(VM *vm);
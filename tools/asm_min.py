@@ -8,7 +8,9 @@ ops = {
     "DUP":13, "DROP":14, "SWAP":15, "OVER":16,
     "GT":17, "GE":18, "LE":19, "NE":20,
     "NOT":21, "AND":22, "OR":23,
-    "CALLUSER":24, "RET":25
+    "CALLUSER":24, "RET":25, "LOADM":26, "STOREM":27,
+    "MOD":28, "SHL":29, "SHR":30, "BAND":31, "BOR":32, "BXOR":33,
+    "FMUL":34, "FDIV":35, "ADD64":36, "MUL64":37
 }
 
 def emit32(out, v):
@@ -0,0 +1,123 @@
+// libmotec.c – Übersetzungskontext und Image-Erzeugung (siehe libmotec.h)
+#include <stdlib.h>
+#include <string.h>
+#include "libmotec.h"
+#include "motec_core.h"
+#include "motec_liveness.h"
+#include "../src/image.h"
+
+struct Motec {
+    MotecOptions opt;
+    MotecDiag diag;
+    Fail fail;
+    P p;
+    Buf out;          // Hauptprogramm, danach gelinktes Programm
+    RelocList rel;
+    BoundList bounds;
+};
+
+Motec *motec_new(const MotecOptions *opt){
+    Motec *m = (Motec*)calloc(1, sizeof *m);
+    if (!m) return NULL;
+    static const MotecOptions def = MOTEC_OPTIONS_DEFAULT;
+    m->opt = opt ? *opt : def;
+    m->fail.diag = &m->diag;
+    return m;
+}
+
+// Funktionsrümpfe freigeben; out, rel, bounds und hold behalten ihren Speicher für
+// die nächste Übersetzung
+static void reset(Motec *m){
+    P *p = &m->p;
+    for (int f=0; f<p->nfuncs; f++){
+        buf_free(&p->funcs[f].body); free(p->funcs[f].rel.a); free(p->funcs[f].bounds.a);
+    }
+    Buf hold = p->hold;
+    memset(p, 0, sizeof *p);
+    p->hold = hold; p->hold.len = 0;
+    m->out.len = 0; m->rel.n = 0; m->bounds.n = 0;
+    memset(&m->diag, 0, sizeof m->diag);
+}
+
+void motec_free(Motec *m){
+    if (!m) return;
+    reset(m);
+    buf_free(&m->p.hold); buf_free(&m->out); free(m->rel.a); free(m->bounds.a);
+    free(m);
+}
+
+const MotecDiag *motec_diag(const Motec *m){ return &m->diag; }
+
+// META, CODE, mit yield() SLOT/YELD und mit bound LOOP zu einem Image zusammensetzen
+static uint8_t *encode_image(Motec *m, size_t *ilen){
+    P *p = &m->p;
+    Buf *out = &m->out;
+
+    // Locals-Slots per Lebendigkeit zusammenlegen, Ergebnis im META-Eintrag
+    int vmap[256];
+    int nslots = m->opt.share_slots ? alloc_local_slots(out, p->async_entry, p->nasync,
+                                                        (const int32_t*)p->yield_at, p->nyield, vmap) : -1;
+    if (nslots < 0){ nslots = count_local_slots(out); for (int v=0; v<256; v++) vmap[v] = v; }
+
+    MoteMeta meta = {0}; meta.nlocals = (uint16_t)nslots; meta.mem = p->arrs.top;
+    uint8_t metabuf[MOTE_META_SIZE];
+    MoteSection sect[5] = {
+        { {'M','E','T','A'}, metabuf, mote_meta_encode(&meta, metabuf) },
+        { {'C','O','D','E'}, out->data, (uint32_t)out->len },
+    };
+    int nsect = 2;
+
+    // Mit yield(): Zustandstabelle und Yield-Stellen für den Austausch im Betrieb
+    uint8_t *slotbuf = NULL, *yieldbuf = NULL;
+    if (p->nyield){
+        MoteSlot slots[256+64]; int ns = 0;
+        for (int i=0; i<p->syms.n; i++){
+            int s = vmap[p->syms.a[i].slot];
+            if (s < 0 || s >= nslots) continue;        // nie benutzt (z. B. nur in weggefallenen Funktionen)
+            MoteSlot *e = &slots[ns++];
+            e->kind = MOTE_SLOT_LOCAL; strcpy(e->name, p->syms.a[i].name); e->at = (uint32_t)s; e->len = 1;
+        }
+        for (int i=0; i<p->arrs.n; i++){
+            MoteSlot *e = &slots[ns++];
+            e->kind = MOTE_SLOT_ARRAY; strcpy(e->name, p->arrs.a[i].name);
+            e->at = p->arrs.a[i].base; e->len = p->arrs.a[i].len;
+        }
+        MoteYield ys[64];
+        for (int k=0; k<p->nyield; k++){ ys[k].id = (uint32_t)p->yield_id[k]; ys[k].addr = p->yield_at[k]; }
+        uint32_t l;
+        slotbuf = mote_slots_encode(slots, ns, &l);
+        sect[nsect++] = (MoteSection){ {'S','L','O','T'}, slotbuf, l };
+        yieldbuf = mote_yields_encode(ys, p->nyield, &l);
+        sect[nsect++] = (MoteSection){ {'Y','E','L','D'}, yieldbuf, l };
+    }
+    // Schleifenschranken für mote-wcet
+    uint8_t *loopbuf = NULL;
+    if (m->bounds.n){
+        MoteLoop *ls = (MoteLoop*)malloc(m->bounds.n * sizeof(MoteLoop));
+        for (int k=0; k<m->bounds.n; k++){ ls[k].addr = (uint32_t)m->bounds.a[k].at; ls[k].bound = m->bounds.a[k].bound; }
+        uint32_t l;
+        loopbuf = mote_loops_encode(ls, m->bounds.n, &l);
+        sect[nsect++] = (MoteSection){ {'L','O','O','P'}, loopbuf, l };
+        free(ls);
+    }
+    uint8_t *image = mote_image_encode(sect, nsect, ilen);
+    free(slotbuf); free(yieldbuf); free(loopbuf);
+    return image;
+}
+
+int motec_compile(Motec *m, const char *src, size_t len, uint8_t **image, size_t *image_len){
+    reset(m);
+    P *p = &m->p;
+    lex_init(&p->L, src, len, &m->fail);
+    p->out = &m->out; p->main_out = &m->out; p->rel = &m->rel; p->bounds = &m->bounds;
+    p->inline_max = m->opt.inline_max;
+
+    if (setjmp(m->fail.jb)) return -1;        // motec_error(): diag ist gefüllt
+    parse_program(p);
+
+    size_t n;
+    uint8_t *img = encode_image(m, &n);
+    if (!img){ strcpy(m->diag.msg, "kein Speicher"); return -1; }
+    *image = img; *image_len = n;
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef LIBMOTEC_H
+#define LIBMOTEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// libmotec – der Mote-Compiler als Bibliothek: Quelltext im Speicher rein,
+// fertiges Image (image.h) im Speicher raus, ohne Dateien, exit() oder
+// Ausgaben. Der gesamte Zustand einer Übersetzung steckt im Kontext; jeder
+// Thread nimmt seinen eigenen und kann ihn für beliebig viele Übersetzungen
+// wiederverwenden. Kontexte teilen nichts, Aufrufe brauchen keine Sperren.
+
+typedef struct {
+    int inline_max;      // Rümpfe bis zu dieser Größe (Bytes) inline, 0 = aus
+    int share_slots;     // Locals nach Lebendigkeit zusammenlegen
+} MotecOptions;
+
+#define MOTEC_OPTIONS_DEFAULT { 32, 1 }
+
+// Erster Fehler einer Übersetzung; die Position zeigt auf das Token, an
+// dem er auffiel (Zeile und Spalte ab 1, Spalte in Bytes)
+typedef struct {
+    int line, col;
+    char msg[192];
+} MotecDiag;
+
+typedef struct Motec Motec;
+
+// opt NULL = MOTEC_OPTIONS_DEFAULT. NULL bei Speichermangel.
+Motec *motec_new(const MotecOptions *opt);
+void   motec_free(Motec *m);
+
+// src: len Bytes, keine Null-Terminierung nötig. 0 bei Erfolg, *image
+// (malloc, free() durch Aufrufer) und *image_len gesetzt; -1 bei einem
+// Übersetzungsfehler, Einzelheiten über motec_diag().
+int motec_compile(Motec *m, const char *src, size_t len, uint8_t **image, size_t *image_len);
+
+// Fehler der letzten Übersetzung (nach Erfolg: line 0, leere Meldung)
+const MotecDiag *motec_diag(const Motec *m);
+
+#endif
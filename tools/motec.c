@@ -1,11 +1,14 @@
 // motec.c – Compiler für die Mote-VM mit Funktionsunterstützung
+// (Lexer, Parser, Linker; Aufruf über libmotec.h)
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdint.h>
 #include "motec_core.h"
 #include "motec_additions.h"
+#include "motec_inline.h"
 
 // ---- Bytebuffer Funktionen ----
 void buf_init(Buf *b){ b->data=NULL; b->len=0; b->cap=0; }
@@ -63,6 +66,7 @@ static void skip_ws_comments(Lex *L){
 static Tok lex_next(Lex *L){
     skip_ws_comments(L);
     Tok out; memset(&out,0,sizeof(out));
+    out.at=L->i;
     if (L->i>=L->n){ out.t=T_EOF; return out; }
     char c = L->src[L->i++];
     switch(c){
@@ -70,32 +74,44 @@ static Tok lex_next(Lex *L){
         case '-': out.t=T_MINUS; return out;
         case '*': out.t=T_STAR; return out;
         case '/': out.t=T_SLASH; return out;
+        case '%': out.t=T_PERCENT; return out;
+        case '^': out.t=T_CARET; return out;
         case '(': out.t=T_LPAREN; return out;
         case ')': out.t=T_RPAREN; return out;
+        case '[': out.t=T_LBRACKET; return out;
+        case ']': out.t=T_RBRACKET; return out;
         case '{': out.t=T_LBRACE; return out;
         case '}': out.t=T_RBRACE; return out;
         case ';': out.t=T_SEMI; return out;
         case ',': out.t=T_COMMA; return out;
         case ':': out.t=T_COLON; return out;
         case '=': if (L->i<L->n && L->src[L->i]=='='){ L->i++; out.t=T_EQEQ; } else out.t=T_ASSIGN; return out;
-        case '<': if (L->i<L->n && L->src[L->i]=='='){ L->i++; out.t=T_LE; } else out.t=T_LT; return out;
-        case '>': if (L->i<L->n && L->src[L->i]=='='){ L->i++; out.t=T_GE; } else out.t=T_GT; return out;
+        case '<':
+            if (L->i<L->n && L->src[L->i]=='='){ L->i++; out.t=T_LE; }
+            else if (L->i<L->n && L->src[L->i]=='<'){ L->i++; out.t=T_SHL; }
+            else out.t=T_LT;
+            return out;
+        case '>':
+            if (L->i<L->n && L->src[L->i]=='='){ L->i++; out.t=T_GE; }
+            else if (L->i<L->n && L->src[L->i]=='>'){ L->i++; out.t=T_SHR; }
+            else out.t=T_GT;
+            return out;
         case '!': if (L->i<L->n && L->src[L->i]=='='){ L->i++; out.t=T_NEQ; } else out.t=T_BANG; return out;
         case '&': 
             if (L->i<L->n && L->src[L->i]=='&'){ 
                 L->i++; out.t=T_ANDAND; return out; 
             }
-            fprintf(stderr,"Lex-Fehler: unerwartetes &\n"); exit(2);
+            out.t=T_AMP; return out;
         case '|': 
             if (L->i<L->n && L->src[L->i]=='|'){ 
                 L->i++; out.t=T_OROR; return out; 
             }
-            fprintf(stderr,"Lex-Fehler: unerwartetes |\n"); exit(2);
+            out.t=T_PIPE; return out;
     }
     if (isdigit((unsigned char)c)){
-        int v=c-'0';
-        while (L->i<L->n && isdigit((unsigned char)L->src[L->i])) v=v*10+(L->src[L->i++]-'0');
-        out.t=T_NUMBER; out.ival=v; return out;
+        uint32_t v=(uint32_t)(c-'0');   // überlange Literale laufen modulo 2^32 über
+        while (L->i<L->n && isdigit((unsigned char)L->src[L->i])) v=v*10u+(uint32_t)(L->src[L->i++]-'0');
+        out.t=T_NUMBER; out.ival=(int)v; return out;
     }
     if (is_ident_start((unsigned char)c)) {
         size_t k=0; out.s[k++]=c;
@@ -123,47 +139,173 @@ static Tok lex_next(Lex *L){
         return out;
     }
     
-    fprintf(stderr,"Lex-Fehler: %c\n",c); 
-    exit(2);
-}  // <-- NUR EINE schließende Klammer!
-static void lex_init(Lex *L,const char*src){ L->src=src; L->i=0; L->n=strlen(src); L->cur.t=T_EOF; }
+    L->cur.at=L->i-1;
+    if(isprint((unsigned char)c)) motec_error(L,"unerwartetes Zeichen '%c'",c);
+    motec_error(L,"unerwartetes Zeichen 0x%02x",(unsigned char)c);
+}
+void lex_init(Lex *L,const char*src,size_t n,Fail*fail){
+    L->src=src; L->i=0; L->n=n; memset(&L->cur,0,sizeof(L->cur)); L->cur.t=T_EOF; L->fail=fail;
+}
 void advance(Lex *L){ L->cur=lex_next(L); }
 int match(Lex*L,TokType t){ if(L->cur.t==t){ advance(L); return 1;} return 0; }
 
+// Schreibweise eines Tokens für Meldungen
+static const char*tok_name(TokType t){
+    static const char*const name[]={
+        "Dateiende","Zahl","Bezeichner",
+        "==","<","+","-","*","/",
+        "(",")","{","}",
+        ";","=",",",":",
+        "||","&&",">",">=","<=","!","!=",
+        "func","return",
+        "if","else","while","for","do",
+        "switch","case","default",
+        "break","continue","import","let",
+        "[","]",
+        "%","<<",">>","&","|","^"
+    };
+    return (unsigned)t<sizeof(name)/sizeof(name[0]) ? name[t] : "?";
+}
+
 void expect(Lex*L,TokType t){
-    if(!match(L,t)){
-        fprintf(stderr,"Syntaxfehler: Erwartet %d (%s), bekam %d ('%s')\n",
-            t, "???", L->cur.t, L->cur.s);  // <-- Mehr Debug-Info
-        exit(2);
+    if(match(L,t)) return;
+    if(L->cur.t==T_IDENT) motec_error(L,"'%s' erwartet, '%s' gefunden",tok_name(t),L->cur.s);
+    if(L->cur.t==T_NUMBER) motec_error(L,"'%s' erwartet, %d gefunden",tok_name(t),L->cur.ival);
+    motec_error(L,"'%s' erwartet, '%s' gefunden",tok_name(t),tok_name(L->cur.t));
+}
+
+// Zeile und Spalte aus dem Offset des aktuellen Tokens
+void motec_error(Lex*L,const char*fmt,...){
+    MotecDiag*d=L->fail->diag;
+    size_t at=L->cur.at<L->n ? L->cur.at : L->n;
+    d->line=1; d->col=1;
+    for(size_t k=0;k<at;k++){
+        if(L->src[k]=='\n'){ d->line++; d->col=1; }
+        else d->col++;
     }
+    va_list ap; va_start(ap,fmt);
+    vsnprintf(d->msg,sizeof(d->msg),fmt,ap);
+    va_end(ap);
+    longjmp(L->fail->jb,1);
 }
 
 // ---- Symboltabellen ----
-uint8_t sym_get_slot(SymTab*T,const char*name){
+uint8_t sym_get_slot(P*p,const char*name){
+    SymTab*T=&p->syms;
     for(int i=0;i<T->n;i++) if(!strcmp(T->a[i].name,name)) return T->a[i].slot;
+    if(T->n>=256) motec_error(&p->L,"zu viele Variablen (höchstens 256): %s",name);
     strncpy(T->a[T->n].name,name,sizeof(T->a[0].name)-1);
     T->a[T->n].slot=(uint8_t)T->n; T->n++;
     return T->a[T->n-1].slot;
 }
 
-// ---- Funktionssymboltabelle ----
-typedef struct { char name[64]; int addr; int nparams; } Func;
-static Func funcs[256]; static int nfuncs=0;
-static int find_func(const char*name){ for(int i=0;i<nfuncs;i++) if(!strcmp(funcs[i].name,name)) return i; return -1; }
+static int sym_exists(const SymTab*T,const char*name){
+    for(int i=0;i<T->n;i++) if(!strcmp(T->a[i].name,name)) return 1;
+    return 0;
+}
+
+// ---- Funktionssymboltabelle (Func in motec_core.h) ----
+static int find_func(const P*p,const char*name){
+    for(int i=0;i<p->nfuncs;i++) if(!strcmp(p->funcs[i].name,name)) return i;
+    return -1;
+}
+
+static void reloc_add(RelocList*r,int at,int func){
+    if(r->n==r->cap){ r->cap=r->cap?r->cap*2:16; r->a=(Reloc*)realloc(r->a,r->cap*sizeof(Reloc)); }
+    r->a[r->n].at=at; r->a[r->n].func=func; r->n++;
+}
+
+void bound_add(BoundList*l,int at,uint32_t bound){
+    if(l->n==l->cap){ l->cap=l->cap?l->cap*2:8; l->a=(Bound*)realloc(l->a,l->cap*sizeof(Bound)); }
+    l->a[l->n].at=at; l->a[l->n].bound=bound; l->n++;
+}
+
+// Klein, vollständig übersetzt und ohne eigene CALLUSER (damit auch nicht rekursiv)
+static int can_inline(P*p,int fid){
+    const Func*F=&p->funcs[fid];
+    return p->inline_max>0 && F->defined && F->rel.n==0 && F->inl_size<=p->inline_max;
+}
+
+static void link_reloc(P*p,int at,int f){
+    int32_t addr=p->funcs[f].addr;
+    patch_i32(p->out,at,addr);
+    if(p->out->data[at-1]==OP_PUSHI){     // Funktionsreferenz statt Aufruf
+        int k=0;
+        while(k<p->nasync && p->async_entry[k]!=addr) k++;
+        if(k==p->nasync) p->async_entry[p->nasync++]=addr;
+    }
+}
+
+// Benutzte Funktionen hinter das Hauptprogramm legen, CALLUSER-Ziele und Funktionsreferenzen patchen
+static void link_program(P*p){
+    Func*funcs=p->funcs; int nfuncs=p->nfuncs;
+    int work[256], wn=0;
+    for(int k=0;k<p->rel->n;k++){
+        int f=p->rel->a[k].func;
+        if(!funcs[f].used){ funcs[f].used=1; work[wn++]=f; }
+    }
+    while(wn){
+        int g=work[--wn];
+        for(int k=0;k<funcs[g].rel.n;k++){
+            int f=funcs[g].rel.a[k].func;
+            if(!funcs[f].used){ funcs[f].used=1; work[wn++]=f; }
+        }
+    }
+    for(int f=0;f<nfuncs;f++){
+        if(!funcs[f].used) continue;   // vollständig inline oder nie aufgerufen
+        funcs[f].addr=(int)p->out->len;
+        buf_append(p->out,funcs[f].body.data,funcs[f].body.len);
+        relocate_jumps(p->out,funcs[f].addr,funcs[f].body.len,funcs[f].addr);
+        for(int k=0;k<funcs[f].bounds.n;k++)
+            bound_add(p->bounds,funcs[f].addr+funcs[f].bounds.a[k].at,funcs[f].bounds.a[k].bound);
+    }
+    for(int k=0;k<p->rel->n;k++)
+        link_reloc(p,p->rel->a[k].at,p->rel->a[k].func);
+    for(int f=0;f<nfuncs;f++){
+        if(!funcs[f].used) continue;
+        for(int k=0;k<funcs[f].rel.n;k++)
+            link_reloc(p,funcs[f].addr+funcs[f].rel.a[k].at,funcs[f].rel.a[k].func);
+    }
+}
 
 // ---- Parser ----
-void parse_stmt(P*p); void parse_expr(P*p);
 static void parse_logical_or(P*p); static void parse_logical_and(P*p);
+static void parse_bor(P*p); static void parse_bxor(P*p); static void parse_band(P*p);
 static void parse_equality(P*p); static void parse_rel(P*p);
-static void parse_add(P*p); static void parse_mul(P*p);
+static void parse_shift(P*p); static void parse_add(P*p); static void parse_mul(P*p);
 static void parse_unary(P*p); static void parse_primary(P*p);
 
 static void emit_pushi(P*p,int v){ emit_op(p->out,OP_PUSHI); emiti32(p->out,v); }
 
-static void parse_program(P*p){
+// ---- Arrays ----
+int arr_find(const P*p,const char*name){
+    for(int i=0;i<p->arrs.n;i++) if(!strcmp(p->arrs.a[i].name,name)) return i;
+    return -1;
+}
+
+void arr_declare(P*p,const char*name,int len){
+    ArrTab*A=&p->arrs;
+    if(arr_find(p,name)>=0) motec_error(&p->L,"Array %s doppelt deklariert",name);
+    if(len<=0 || A->n>=64 || (uint64_t)A->top+(uint32_t)len>0x7fffffffu)
+        motec_error(&p->L,"Array %s: ungültige Größe oder zu viele Arrays",name);
+    Arr*a=&A->a[A->n++];
+    strncpy(a->name,name,sizeof(a->name)-1);
+    a->base=A->top; a->len=(uint32_t)len;
+    A->top+=(uint32_t)len;
+}
+
+// '[' ist bereits gelesen: Index auswerten, Basis addieren (Grenzen prüft die VM gegen den ganzen Speicher)
+void parse_array_addr(P*p,int a){
+    parse_expr(p);
+    expect(&p->L,T_RBRACKET);
+    if(p->arrs.a[a].base){ emit_pushi(p,(int)p->arrs.a[a].base); emit_op(p->out,OP_ADD); }
+}
+
+void parse_program(P*p){
     advance(&p->L);
     while(p->L.cur.t!=T_EOF) parse_stmt(p);
     emit_op(p->out,OP_HALT);
+    link_program(p);
 }
 
 static void parse_block(P*p){
@@ -171,15 +313,24 @@ static void parse_block(P*p){
     while(!match(&p->L,T_RBRACE)) parse_stmt(p);
 }
 
-void parse_stmt(P*p){
+// Verschachtelung zählen; zurückgesetzt wird bei jeder Übersetzung
+static void enter(P*p){
+    if(++p->depth>MOTEC_MAX_DEPTH) motec_error(&p->L,"zu tief verschachtelt (höchstens %d Ebenen)",MOTEC_MAX_DEPTH);
+}
+
+static void parse_stmt_inner(P*p);
+void parse_stmt(P*p){ enter(p); parse_stmt_inner(p); p->depth--; }
+
+static void parse_stmt_inner(P*p){
     switch(p->L.cur.t){
         case T_IF: advance(&p->L); parse_if(p); return;
         case T_WHILE: advance(&p->L); parse_while(p); return;
         case T_FOR: advance(&p->L); parse_for(p); return;
-        case T_DO: advance(&p->L); parse_do_while(p); return;
-        case T_SWITCH: advance(&p->L); parse_switch(p); return;
-        case T_BREAK: advance(&p->L); parse_break(p); expect(&p->L, T_SEMI); return;
-        case T_CONTINUE: advance(&p->L); parse_continue(p); expect(&p->L, T_SEMI); return;
+        // Schlüsselwort erst in der Funktion überlesen: Fehler zeigen darauf
+        case T_DO: parse_do_while(p); return;
+        case T_SWITCH: parse_switch(p); return;
+        case T_BREAK: parse_break(p); expect(&p->L, T_SEMI); return;
+        case T_CONTINUE: parse_continue(p); expect(&p->L, T_SEMI); return;
         case T_IMPORT: advance(&p->L); parse_import(p); expect(&p->L, T_SEMI); return;
         case T_LET: advance(&p->L); parse_let_stmt(p); return;
     }
@@ -189,32 +340,39 @@ void parse_stmt(P*p){
     // Funktionsdefinition
     if(p->L.cur.t==T_FUNC){
         advance(&p->L);
-        if(p->L.cur.t != T_IDENT){
-            fprintf(stderr,"Funktionsname erwartet.\n"); 
-            exit(2);
-        }
+        if(p->L.cur.t != T_IDENT) motec_error(&p->L,"Funktionsname erwartet");
         char fname[64]; strncpy(fname,p->L.cur.s,sizeof(fname)); fname[63]=0;
         advance(&p->L);
         expect(&p->L,T_LPAREN);
-        int params=0;
+        int params=0; uint8_t pslots[64];
         while(p->L.cur.t==T_IDENT){
-            sym_get_slot(&p->syms,p->L.cur.s);
-            params++; advance(&p->L);
+            if(params>=64) motec_error(&p->L,"zu viele Parameter: %s",fname);
+            pslots[params++]=sym_get_slot(p,p->L.cur.s);
+            advance(&p->L);
             if(!match(&p->L,T_COMMA)) break;
         }
         expect(&p->L,T_RPAREN);
-        {
-            int faddr=p->out->len;
-            strncpy(funcs[nfuncs].name,fname,sizeof(funcs[nfuncs].name)-1);
-            funcs[nfuncs].name[sizeof(funcs[nfuncs].name)-1]=0;
-            funcs[nfuncs].addr=faddr; funcs[nfuncs].nparams=params; nfuncs++;
-        }
+        if(p->nfuncs>=256) motec_error(&p->L,"zu viele Funktionen");
+        int fid=p->nfuncs++;
+        Func*F=&p->funcs[fid];
+        strncpy(F->name,fname,sizeof(F->name)-1);
+        F->name[sizeof(F->name)-1]=0;
+        F->nparams=params;
+
+        // Rumpf in eigenes Fragment übersetzen
+        Buf*saved_out=p->out; RelocList*saved_rel=p->rel; BoundList*saved_bounds=p->bounds; int saved_bc=p->bc_sp;
+        p->out=&F->body; p->rel=&F->rel; p->bounds=&F->bounds; p->bc_sp=0;
         for (int i = params - 1; i >= 0; --i) {
             emit_op(p->out, OP_STOREL);
-            emit8(p->out, (uint8_t)i);
+            emit8(p->out, pslots[i]);
         }
         parse_block(p);
+        emit_pushi(p,0);            // ohne return liefert jeder Aufruf 0
         emit_op(p->out,OP_RET);
+        p->out=saved_out; p->rel=saved_rel; p->bounds=saved_bounds; p->bc_sp=saved_bc;
+
+        F->inl_size=inline_size(&F->body);
+        F->defined=1;
         match(&p->L, T_SEMI);
         return;
     }
@@ -222,7 +380,8 @@ void parse_stmt(P*p){
     // return
     if(p->L.cur.t==T_RETURN){
         advance(&p->L);
-        parse_expr(p);          // <-- DAS MUSS BLEIBEN!
+        if(p->L.cur.t==T_SEMI) emit_pushi(p,0);
+        else parse_expr(p);     // <-- DAS MUSS BLEIBEN!
         expect(&p->L,T_SEMI);
         emit_op(p->out,OP_RET);
         return;
@@ -234,12 +393,13 @@ void parse_stmt(P*p){
         return;
     }
 
-    // Standard-Ausdruck
+    // Standard-Ausdruck, Ergebnis verwerfen
     parse_expr(p); expect(&p->L,T_SEMI);
+    emit_op(p->out,OP_DROP);
 }
 
 // ---- Ausdrücke ----
-void parse_expr(P*p){ parse_logical_or(p); }
+void parse_expr(P*p){ enter(p); parse_logical_or(p); p->depth--; }
 
 static void parse_logical_or(P*p){
     parse_logical_and(p);
@@ -247,8 +407,24 @@ static void parse_logical_or(P*p){
 }
 
 static void parse_logical_and(P*p){
+    parse_bor(p);
+    while(match(&p->L,T_ANDAND)){ parse_bor(p); emit_op(p->out,OP_AND); }
+}
+
+// Bitoperatoren mit C-Vorrang: | < ^ < & < Gleichheit
+static void parse_bor(P*p){
+    parse_bxor(p);
+    while(match(&p->L,T_PIPE)){ parse_bxor(p); emit_op(p->out,OP_BOR); }
+}
+
+static void parse_bxor(P*p){
+    parse_band(p);
+    while(match(&p->L,T_CARET)){ parse_band(p); emit_op(p->out,OP_BXOR); }
+}
+
+static void parse_band(P*p){
     parse_equality(p);
-    while(match(&p->L,T_ANDAND)){ parse_equality(p); emit_op(p->out,OP_AND); }
+    while(match(&p->L,T_AMP)){ parse_equality(p); emit_op(p->out,OP_BAND); }
 }
 
 static void parse_equality(P*p){
@@ -258,12 +434,21 @@ static void parse_equality(P*p){
 }
 
 static void parse_rel(P*p){
+    parse_shift(p);
+    for(;;){
+        if(match(&p->L,T_LT)){ parse_shift(p); emit_op(p->out,OP_LT); }
+        else if(match(&p->L,T_GT)){ parse_shift(p); emit_op(p->out,OP_GT); }
+        else if(match(&p->L,T_LE)){ parse_shift(p); emit_op(p->out,OP_LE); }
+        else if(match(&p->L,T_GE)){ parse_shift(p); emit_op(p->out,OP_GE); }
+        else break;
+    }
+}
+
+static void parse_shift(P*p){
     parse_add(p);
     for(;;){
-        if(match(&p->L,T_LT)){ parse_add(p); emit_op(p->out,OP_LT); }
-        else if(match(&p->L,T_GT)){ parse_add(p); emit_op(p->out,OP_GT); }
-        else if(match(&p->L,T_LE)){ parse_add(p); emit_op(p->out,OP_LE); }
-        else if(match(&p->L,T_GE)){ parse_add(p); emit_op(p->out,OP_GE); }
+        if(match(&p->L,T_SHL)){ parse_add(p); emit_op(p->out,OP_SHL); }
+        else if(match(&p->L,T_SHR)){ parse_add(p); emit_op(p->out,OP_SHR); }
         else break;
     }
 }
@@ -282,19 +467,20 @@ static void parse_mul(P*p){
     for(;;){
         if(match(&p->L,T_STAR)){ parse_unary(p); emit_op(p->out,OP_MUL); }
         else if(match(&p->L,T_SLASH)){ parse_unary(p); emit_op(p->out,OP_DIV); }
+        else if(match(&p->L,T_PERCENT)){ parse_unary(p); emit_op(p->out,OP_MOD); }
         else break;
     }
 }
 
 static void parse_unary(P*p){
     if(match(&p->L,T_MINUS)){
-        parse_unary(p);
+        enter(p); parse_unary(p); p->depth--;
         emit_op(p->out,OP_PUSHI); emiti32(p->out,-1);
         emit_op(p->out,OP_MUL);
         return;
     }
     if(match(&p->L,T_BANG)){
-        parse_unary(p);
+        enter(p); parse_unary(p); p->depth--;
         emit_op(p->out,OP_NOT);
         return;
     }
@@ -302,7 +488,47 @@ static void parse_unary(P*p){
 }
 
 // ---- Funktionsaufruf ----
-void parse_call_and_emit(P*p,const char*name){
+// Natives der VM (Index muss mit dem Host übereinstimmen)
+static const struct { const char*name; uint8_t idx; int nargs; } natives[]={
+    {"gpio_mode",       NAT_GPIO_MODE,       2},
+    {"gpio_write",      NAT_GPIO_WRITE,      2},
+    {"sleep_ms",        NAT_SLEEP_MS,        1},
+    {"gpio_read",       NAT_GPIO_READ,       1},
+    {"print_int",       NAT_PRINT_INT,       1},
+    {"gpio_mode_mask",  NAT_GPIO_MODE_MASK,  3},
+    {"gpio_write_mask", NAT_GPIO_WRITE_MASK, 3},
+    {"gpio_read_port",  NAT_GPIO_READ_PORT,  1},
+    {"gpio_on_edge",    NAT_GPIO_ON_EDGE,    3},
+    {"wait_event",      NAT_WAIT_EVENT,      0},
+    {"mem_fill",        NAT_MEM_FILL,        3},   // (addr, n, wert)
+    {"mem_copy",        NAT_MEM_COPY,        3},   // (ziel, quelle, n)
+    {"mem_sum",         NAT_MEM_SUM,         2},   // (addr, n)
+    {"mem_max",         NAT_MEM_MAX,         2},   // (addr, n)
+    {"adc_sample",      NAT_ADC_SAMPLE,      1},   // (ch)
+    {"adc_read",        NAT_ADC_READ,        3},   // (ch, ziel, n)
+    {"adc_block_avg",   NAT_ADC_BLOCK_AVG,   2},   // (ch, n)
+    {"count_above",     NAT_COUNT_ABOVE,     3},   // (ch, n, schwelle)
+    {"fir_apply",       NAT_FIR_APPLY,       5},   // (ch, n, coef, taps, ziel)
+    {"yield",           NAT_YIELD,           1},   // (id) Austauschstelle, siehe yield_site
+    {NULL,0,0}
+};
+
+// Intrinsics: übersetzen direkt in einen Opcode statt in OP_CALL
+static const struct { const char*name; Op op; int nargs, nres; } intrinsics[]={
+    {"fmul",  OP_FMUL,  2, 1},   // Q16.16
+    {"fdiv",  OP_FDIV,  2, 1},
+    {"add64", OP_ADD64, 4, 2},   // (a_lo, a_hi, b_lo, b_hi) -> lo, hi
+    {"mul64", OP_MUL64, 4, 2},
+    {NULL,0,0,0}
+};
+
+static int find_intrinsic(const char*name){
+    for(int i=0;intrinsics[i].name;i++) if(!strcmp(name,intrinsics[i].name)) return i;
+    return -1;
+}
+
+// Argumente bis einschließlich ')', Rückgabe Anzahl
+static int parse_args(P*p){
     int argc = 0;
     if(p->L.cur.t != T_RPAREN){
         for(;;){
@@ -313,31 +539,90 @@ void parse_call_and_emit(P*p,const char*name){
         }
     }
     expect(&p->L,T_RPAREN);
+    return argc;
+}
 
-    int fid=find_func(name);
+static void check_intrinsic_args(P*p,int k,int argc){
+    if(argc!=intrinsics[k].nargs)
+        motec_error(&p->L,"%s erwartet %d Argumente, bekam %d",intrinsics[k].name,intrinsics[k].nargs,argc);
+}
+
+// lo, hi = add64(...); – '=' und der Name lo sind gelesen, das Komma auch
+void parse_pair_assign(P*p,const char*lo){
+    if(p->L.cur.t!=T_IDENT) motec_error(&p->L,"zweiter Variablenname erwartet");
+    char hi[64]; strncpy(hi,p->L.cur.s,sizeof(hi)); hi[63]=0;
+    advance(&p->L);
+    expect(&p->L,T_ASSIGN);
+    int k = p->L.cur.t==T_IDENT ? find_intrinsic(p->L.cur.s) : -1;
+    if(k<0 || intrinsics[k].nres!=2)
+        motec_error(&p->L,"%s, %s = ...: rechts muss add64(...) oder mul64(...) stehen",lo,hi);
+    advance(&p->L);
+    expect(&p->L,T_LPAREN);
+    check_intrinsic_args(p,k,parse_args(p));
+    emit_op(p->out,intrinsics[k].op);
+    emit_op(p->out,OP_STOREL); emit8(p->out,sym_get_slot(p,hi));
+    emit_op(p->out,OP_STOREL); emit8(p->out,sym_get_slot(p,lo));
+}
+
+// yield(id) markiert eine Stelle, an der mote_host --swap ein neues Image
+// einsetzen kann; dort geht es im neuen Image beim yield mit derselben id
+// weiter. Nur im Hauptprogramm (Call-Stack leer) und mit konstanter id.
+static void yield_site(P*p,size_t args_at){
+    if(p->out!=p->main_out) motec_error(&p->L,"yield ist nur im Hauptprogramm erlaubt");
+    if(p->out->len!=args_at+7 || p->out->data[args_at]!=OP_PUSHI
+       || (p->rel->n && p->rel->a[p->rel->n-1].at==(int)args_at+1))
+        motec_error(&p->L,"yield: id muss eine Zahl sein");
+    int32_t id; memcpy(&id,p->out->data+args_at+1,4);
+    for(int k=0;k<p->nyield;k++)
+        if(p->yield_id[k]==id) motec_error(&p->L,"yield(%d) doppelt",id);
+    if(p->nyield>=64) motec_error(&p->L,"zu viele yield-Stellen");
+    p->yield_id[p->nyield]=id; p->yield_at[p->nyield]=(uint32_t)p->out->len; p->nyield++;
+}
+
+void parse_call_and_emit(P*p,const char*name){
+    size_t args_at = p->out->len;
+    int argc = parse_args(p);
+
+    int fid=find_func(p,name);
     if(fid>=0){
-        if (argc != funcs[fid].nparams) {
-            fprintf(stderr, "Arity-Fehler: %s erwartet %d Argumente, bekam %d.\n",
-                    name, funcs[fid].nparams, argc);
-            exit(2);
+        if (argc != p->funcs[fid].nparams)
+            motec_error(&p->L,"%s erwartet %d Argumente, bekam %d",name,p->funcs[fid].nparams,argc);
+        if(can_inline(p,fid)){
+            // Argumente liegen schon auf dem Stack, der Prolog des Rumpfs speichert sie
+            const Func*F=&p->funcs[fid];
+            int base=(int)p->out->len;
+            for(int k=0;k<F->bounds.n;k++){
+                int at=inline_addr(&F->body,(size_t)F->bounds.a[k].at);
+                if(at>=0) bound_add(p->bounds,base+at,F->bounds.a[k].bound);
+            }
+            inline_fragment(p->out,&F->body);
+            return;
         }
         emit_op(p->out,OP_CALLUSER);
-        emiti32(p->out,funcs[fid].addr);
+        reloc_add(p->rel,(int)p->out->len,fid);
+        emiti32(p->out,0);          // Adresse erst beim Linken bekannt
         return;
     }
 
-    if(!strcmp(name,"gpio_mode")){ emit_op(p->out,OP_CALL); emit8(p->out,0); return; }
-    if(!strcmp(name,"gpio_write")){ emit_op(p->out,OP_CALL); emit8(p->out,1); return; }
-    if(!strcmp(name,"sleep_ms")){ emit_op(p->out,OP_CALL); emit8(p->out,2); return; }
-    if(!strcmp(name,"gpio_read")){ emit_op(p->out,OP_CALL); emit8(p->out,3); return; }
-    if(!strcmp(name,"print_int")) {
-        emit_op(p->out, OP_CALL);
-        emit8(p->out, 4);   // neuer Index, muss mit Host übereinstimmen
+    int k=find_intrinsic(name);
+    if(k>=0){
+        if(intrinsics[k].nres!=1)
+            motec_error(&p->L,"%s liefert zwei Werte: nur als lo, hi = %s(...);",name,name);
+        check_intrinsic_args(p,k,argc);
+        emit_op(p->out,intrinsics[k].op);
         return;
     }
 
+    for(int i=0;natives[i].name;i++){
+        if(strcmp(name,natives[i].name)) continue;
+        if(argc!=natives[i].nargs)
+            motec_error(&p->L,"%s erwartet %d Argumente, bekam %d",name,natives[i].nargs,argc);
+        emit_op(p->out,OP_CALL); emit8(p->out,natives[i].idx);
+        if(natives[i].idx==NAT_YIELD) yield_site(p,args_at);
+        return;
+    }
 
-    fprintf(stderr,"Unbekannte Funktion: %s\n",name); exit(2);
+    motec_error(&p->L,"unbekannte Funktion: %s",name);
 }
 
 // ---- Primary ----
@@ -351,36 +636,30 @@ static void parse_primary(P*p){
     if(t.t==T_IDENT){
         char name[64]; strncpy(name,t.s,sizeof(name)); name[63]=0; advance(&p->L);
         if(match(&p->L,T_LPAREN)){ parse_call_and_emit(p,name); return; }
-        { uint8_t slot=sym_get_slot(&p->syms,name);
+        int a=arr_find(p,name);
+        if(a>=0){
+            // a[i] liest ein Element, der bloße Name ist die Basisadresse (z. B. für mem_sum)
+            if(match(&p->L,T_LBRACKET)){ parse_array_addr(p,a); emit_op(p->out,OP_LOADM); }
+            else emit_pushi(p,(int)p->arrs.a[a].base);
+            return;
+        }
+        int fid=find_func(p,name);
+        if(fid>=0 && !sym_exists(&p->syms,name)){
+            // Funktion als Wert, z. B. gpio_on_edge(pin, edge, handler)
+            if(p->funcs[fid].nparams!=1)
+                motec_error(&p->L,"Interrupt-Handler %s muss genau einen Parameter (pin) haben",name);
+            emit_op(p->out,OP_PUSHI);
+            reloc_add(p->rel,(int)p->out->len,fid);
+            emiti32(p->out,0);
+            return;
+        }
+        { uint8_t slot=sym_get_slot(p,name);
           emit_op(p->out,OP_LOADL); emit8(p->out,slot); }
         return;
     }
     if(match(&p->L,T_LPAREN)){
         parse_expr(p); expect(&p->L,T_RPAREN); return;
     }
-    fprintf(stderr,"Syntaxfehler in Ausdruck.\n"); exit(2);
-}
-
-// ---- I/O ----
-static char* read_file(const char*path){
-    FILE*f=fopen(path,"rb"); if(!f){perror("open"); exit(1);}
-    fseek(f,0,SEEK_END); long n=ftell(f); fseek(f,0,SEEK_SET);
-    char*buf=(char*)malloc(n+1); fread(buf,1,n,f); buf[n]=0; fclose(f);
-    return buf;
-}
-static void write_file(const char*path,const uint8_t*data,size_t n){
-    FILE*f=fopen(path,"wb"); if(!f){perror("open out"); exit(1);}
-    fwrite(data,1,n,f); fclose(f);
-}
-
-// ---- main ----
-int main(int argc,char**argv){
-    if(argc!=3){ fprintf(stderr,"Usage: %s in.mo out.bin\n",argv[0]); return 1; }
-    char*src=read_file(argv[1]);
-    Buf out; buf_init(&out);
-    P p={0}; lex_init(&p.L,src); p.out=&out; p.syms.n=0; p.bc_sp=0;
-    parse_program(&p);
-    write_file(argv[2],out.data,out.len);
-    free(out.data); free(src);
-    return 0;
-}
\ No newline at end of file
+    if(t.t==T_EOF) motec_error(&p->L,"Ausdruck erwartet, Dateiende gefunden");
+    motec_error(&p->L,"Syntaxfehler in Ausdruck");
+}
@@ -1,18 +1,13 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "motec_core.h"
 #include "motec_additions.h"
+#include "motec_inline.h"
 
-// ==== Hilfsfunktionen aus motec.c benutzen ====
-// In motec.c gibt es:
-//   static int match(Lex* L, TokType t);
-//   static void expect(Lex* L, TokType t);
-//   static void advance(Lex* L);
-//   static void parse_expr(P* p);
-//   static void parse_stmt(P* p);
-//   static void parse_call_and_emit(P* p, const char* name);
-//   static uint8_t sym_get_slot(SymTab* T, const char* name);
-//
-// Wir rufen sie direkt auf, NICHT als extern, weil sie dort schon definiert sind.
+// ==== Hilfsfunktionen aus motec.c (deklariert in motec_core.h) ====
+// Fehler gehen über motec_error(): kein exit(), keine Ausgabe, der
+// Aufrufer von motec_compile() bekommt sie als MotecDiag.
 
 // Dummy-Helfer, weil sie im Original fehlen:
 static int parse_int_literal(Lex* L, int* out) {
@@ -28,21 +23,26 @@ static int is_identifier_token(int tok) {
     return tok == T_IDENT;
 }
 
-static void parse_file_into(P* p, const char* path) {
-    fprintf(stderr, "import nicht implementiert: %s\n", path);
-}
-
 // ===== Break/Continue Stack Helpers =====
 static void bc_push(P* p, int break_target_unused, int continue_target) {
-    if (p->bc_sp < 64) {
-        p->break_stack[p->bc_sp]    = -1;              // Kopf der break-Patchkette
-        p->continue_stack[p->bc_sp] = continue_target; // Ziel für continue
-        p->bc_sp++;
-    }
+    if (p->bc_sp >= 64) motec_error(&p->L, "zu viele verschachtelte Schleifen (höchstens 64)");
+    p->break_stack[p->bc_sp]    = -1;              // Kopf der break-Patchkette
+    p->continue_stack[p->bc_sp] = continue_target; // Ziel für continue
+    p->bc_sp++;
 }
 
 static void bc_pop(P* p) { if (p->bc_sp > 0) p->bc_sp--; }
 
+// Optional hinter der Schleifenbedingung: bound N – höchstens N Durchläufe je
+// Eintritt in die Schleife. Ungeprüfte Zusage für mote-wcet, ohne Laufzeitkosten.
+static void parse_loop_bound(P* p, int head) {
+    if (p->L.cur.t != T_IDENT || strcmp(p->L.cur.s, "bound")) return;
+    advance(&p->L);
+    if (p->L.cur.t != T_NUMBER) motec_error(&p->L, "bound: konstante Anzahl Durchläufe erwartet");
+    bound_add(p->bounds, head, (uint32_t)p->L.cur.ival);
+    advance(&p->L);
+}
+
 static inline int32_t read_i32(Buf* b, size_t at){ int32_t v; memcpy(&v,b->data+at,4); return v; }
 static inline void    write_i32(Buf* b, size_t at, int32_t v){ memcpy(b->data+at,&v,4); }
 
@@ -101,17 +101,12 @@ void parse_if(P* p) {
 }
 
 void parse_while(P* p) {
-    printf("DEBUG: parse_while() gestartet, aktuelles Token: %d ('%s')\n", 
-           p->L.cur.t, p->L.cur.s);
-    
     int loop_start = p->out->len;
-    
-    printf("DEBUG: Erwarte LPAREN, aktuelles Token: %d ('%s')\n", 
-           p->L.cur.t, p->L.cur.s);
-    
+
     expect(&p->L, T_LPAREN);
     parse_expr(p);
     expect(&p->L, T_RPAREN);
+    parse_loop_bound(p, loop_start);
 
     int jz_end = p->out->len;
     emit_op(p->out, OP_JZ);
@@ -135,11 +130,20 @@ void parse_while(P* p) {
     buf[2] = (pc >> 16) & 0xFF;
     buf[3] = (pc >> 24) & 0xFF;
 
+    // 'break'-Kette auf das Schleifenende patchen (wie in parse_for)
+    int cur = p->break_stack[p->bc_sp - 1];
+    while (cur != -1) {
+        int next = read_i32(p->out, cur + 1);
+        write_i32(p->out, cur + 1, pc);
+        cur = next;
+    }
+
     bc_pop(p);
 }
 
 void parse_break(P* p) {
-    if (p->bc_sp <= 0) { fprintf(stderr,"break außerhalb einer Schleife\n"); return; }
+    if (p->bc_sp <= 0) motec_error(&p->L, "break außerhalb einer Schleife");
+    advance(&p->L);
     int head = p->break_stack[p->bc_sp - 1];
     int patch_pc = p->out->len;
     emit_op(p->out, OP_JMP);
@@ -149,11 +153,8 @@ void parse_break(P* p) {
 
 
 void parse_continue(P* p) {
-    //expect(&p->L, T_CONTINUE);
-    if (p->bc_sp <= 0) {
-        fprintf(stderr, "continue außerhalb einer Schleife\n");
-        return;
-    }
+    if (p->bc_sp <= 0) motec_error(&p->L, "continue außerhalb einer Schleife");
+    advance(&p->L);
     int target = p->continue_stack[p->bc_sp - 1];
     emit_op(p->out, OP_JMP);
     emiti32(p->out, target);
@@ -161,54 +162,75 @@ void parse_continue(P* p) {
 
 
 void parse_import(P* p) {
-    if (p->L.cur.t == T_IDENT) {
-        const char* id = p->L.cur.s;
-        parse_file_into(p, id);
-        advance(&p->L);
-    } else {
-        fprintf(stderr, "import erwartet Identifier\n");
-    }
+    if (p->L.cur.t != T_IDENT) motec_error(&p->L, "import erwartet Identifier");
+    motec_error(&p->L, "import nicht implementiert: %s", p->L.cur.s);
+}
+
+// a[i] = expr ('[' bereits gelesen): Adresse, Wert, STOREM
+static void parse_array_store(P* p, int a) {
+    parse_array_addr(p, a);
+    expect(&p->L, T_ASSIGN);
+    parse_expr(p);
+    emit_op(p->out, OP_STOREM);
 }
 
 static void parse_assignment_or_call_expr(P* p) {
     if (p->L.cur.t == T_IDENT) {
-        const char* name = p->L.cur.s;
+        char name[64];
+        strncpy(name, p->L.cur.s, sizeof(name));
+        name[63] = 0;
         advance(&p->L);
-        if (p->L.cur.t == T_ASSIGN) {
+        if (p->L.cur.t == T_LBRACKET && arr_find(p, name) >= 0) {
+            advance(&p->L);
+            parse_array_store(p, arr_find(p, name));
+            return;
+        } else if (p->L.cur.t == T_ASSIGN) {
             advance(&p->L);
             parse_expr(p);
-            uint8_t slot = sym_get_slot(&p->syms, name);
+            uint8_t slot = sym_get_slot(p, name);
             emit_op(p->out, OP_STOREL);
             emit8(p->out, slot);
             return;
         } else if (p->L.cur.t == T_LPAREN) {
+            advance(&p->L);
             parse_call_and_emit(p, name);
+            emit_op(p->out, OP_DROP);
             return;
         } else {
-            uint8_t slot = sym_get_slot(&p->syms, name);
+            uint8_t slot = sym_get_slot(p, name);
             emit_op(p->out, OP_LOADL);
             emit8(p->out, slot);
+            emit_op(p->out, OP_DROP);
             return;
         }
     }
     parse_expr(p);
+    emit_op(p->out, OP_DROP);
 }
 
 void parse_let_stmt(P* p) {
      // 'let' wurde in motec.c bereits via advance() konsumiert
-    if (p->L.cur.t != T_IDENT) {
-        fprintf(stderr, "let: Variablenname erwartet\n");
-        exit(2);
-    }
+    if (p->L.cur.t != T_IDENT) motec_error(&p->L, "let: Variablenname erwartet");
     char name[64];
     strncpy(name, p->L.cur.s, sizeof(name));
     name[63] = 0;
     advance(&p->L);
 
+    // let name[N]; – Array fester Größe im linearen Speicher
+    if (match(&p->L, T_LBRACKET)) {
+        if (p->L.cur.t != T_NUMBER) motec_error(&p->L, "let %s[]: konstante Größe erwartet", name);
+        int len = p->L.cur.ival;
+        advance(&p->L);
+        expect(&p->L, T_RBRACKET);
+        expect(&p->L, T_SEMI);
+        arr_declare(p, name, len);
+        return;
+    }
+
     expect(&p->L, T_ASSIGN);
     parse_expr(p);
 
-    uint8_t slot = sym_get_slot(&p->syms, name);
+    uint8_t slot = sym_get_slot(p, name);
     emit_op(p->out, OP_STOREL);
     emit8(p->out, slot);
 
@@ -218,24 +240,39 @@ void parse_let_stmt(P* p) {
 
 void parse_assignment_or_call_stmt(P* p) {
     if (p->L.cur.t == T_IDENT) {
-        const char* name = p->L.cur.s;
+        char name[64];
+        strncpy(name, p->L.cur.s, sizeof(name));
+        name[63] = 0;
         advance(&p->L);
-        if (p->L.cur.t == T_ASSIGN) {
+        if (p->L.cur.t == T_LBRACKET && arr_find(p, name) >= 0) {
+            advance(&p->L);
+            parse_array_store(p, arr_find(p, name));
+            expect(&p->L, T_SEMI);
+            return;
+        } else if (p->L.cur.t == T_COMMA) {
+            advance(&p->L);
+            parse_pair_assign(p, name);
+            expect(&p->L, T_SEMI);
+            return;
+        } else if (p->L.cur.t == T_ASSIGN) {
             advance(&p->L);
             parse_expr(p);
             expect(&p->L, T_SEMI);
-            uint8_t slot = sym_get_slot(&p->syms, name);
+            uint8_t slot = sym_get_slot(p, name);
             emit_op(p->out, OP_STOREL);
             emit8(p->out, slot);
             return;
         } else {
+            expect(&p->L, T_LPAREN);
             parse_call_and_emit(p, name);
             expect(&p->L, T_SEMI);
+            emit_op(p->out, OP_DROP);   // Rückgabewert wird nicht gebraucht
             return;
         }
     }
     parse_expr(p);
     expect(&p->L, T_SEMI);
+    emit_op(p->out, OP_DROP);
 }
 
 // Neuer parse_for: unterstützt init ; cond ; post
@@ -247,17 +284,14 @@ void parse_for(P* p) {
     if (p->L.cur.t != T_SEMI) {
         if (p->L.cur.t == T_LET) {
             advance(&p->L);
-            if (p->L.cur.t != T_IDENT) {
-                fprintf(stderr, "for: Variablenname erwartet\n");
-                exit(2);
-            }
+            if (p->L.cur.t != T_IDENT) motec_error(&p->L, "for: Variablenname erwartet");
             char name[64];
             strncpy(name, p->L.cur.s, sizeof(name));
             name[63] = 0;
             advance(&p->L);
             expect(&p->L, T_ASSIGN);
             parse_expr(p); // Startwert
-            uint8_t slot = sym_get_slot(&p->syms, name);
+            uint8_t slot = sym_get_slot(p, name);
             emit_op(p->out, OP_STOREL);
             emit8(p->out, slot);
         } else {
@@ -283,16 +317,27 @@ void parse_for(P* p) {
     emiti32(p->out, 0); // Patch später
 
     // --- Post vorbereiten ---
+    // Kopie oben auf p->hold; verschachtelte for legen ihre darüber und
+    // räumen sie vorher wieder ab
     int post_start = -1, post_len = 0;
+    int rel_from = p->rel->n, rel_to = p->rel->n;
+    int bnd_from = p->bounds->n, bnd_to = p->bounds->n;   // Schleifen in inline eingefügten Rümpfen
+    int ny_from = p->nyield, ny_to = p->nyield;           // yield() im Post-Teil
+    size_t hold_at = p->hold.len;
     if (p->L.cur.t != T_RPAREN) {
         int save_pc = p->out->len;
         parse_assignment_or_call_expr(p); // kein Semikolon
         post_start = save_pc;
         post_len   = p->out->len - save_pc;
+        rel_to     = p->rel->n;
+        bnd_to     = p->bounds->n;
+        ny_to      = p->nyield;
+        buf_append(&p->hold, p->out->data + post_start, post_len);
         p->out->len = save_pc; // verwerfen, später wieder einfügen
     }
 
     expect(&p->L, T_RPAREN);
+    parse_loop_bound(p, cond_pc);
 
     // --- Body ---
     // continue -> zurück zur Bedingung (vereinfachte Semantik)
@@ -305,9 +350,16 @@ void parse_for(P* p) {
     expect(&p->L, T_RBRACE);
 
     // --- Post-Teil wieder einfügen ---
+    // (eigene Kopie: der Body hat den ursprünglichen Bereich überschrieben)
     if (post_start >= 0 && post_len > 0) {
-        buf_append(p->out, p->out->data + post_start, post_len);
+        int32_t delta = (int32_t)p->out->len - post_start;
+        buf_append(p->out, p->hold.data + hold_at, post_len);
+        relocate_jumps(p->out, p->out->len - post_len, post_len, delta); // inline eingefügte Rümpfe
+        for (int k = rel_from; k < rel_to; k++) p->rel->a[k].at += delta;
+        for (int k = bnd_from; k < bnd_to; k++) p->bounds->a[k].at += delta;
+        for (int k = ny_from; k < ny_to; k++) p->yield_at[k] += delta;
     }
+    p->hold.len = hold_at;
 
     // --- Zurück zur Condition ---
     emit_op(p->out, OP_JMP);
@@ -338,9 +390,9 @@ void parse_for(P* p) {
 
 
 void parse_do_while(P* p) {
-    fprintf(stderr, "parse_do_while: noch nicht implementiert\n");
+    motec_error(&p->L, "do/while noch nicht implementiert");
 }
 
 void parse_switch(P* p) {
-    fprintf(stderr, "parse_switch: noch nicht implementiert\n");
-}
\ No newline at end of file
+    motec_error(&p->L, "switch noch nicht implementiert");
+}
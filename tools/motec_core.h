@@ -2,6 +2,9 @@
 #define MOTEC_CORE_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "libmotec.h"
 
 // ---- Bytecode Opcodes ----
 typedef enum {
@@ -12,12 +15,56 @@ typedef enum {
     OP_DUP=13, OP_DROP=14, OP_SWAP=15, OP_OVER=16,
     OP_GT=17, OP_GE=18, OP_LE=19, OP_NE=20,
     OP_NOT=21, OP_AND=22, OP_OR=23,
-    OP_CALLUSER=24, OP_RET=25
+    OP_CALLUSER=24, OP_RET=25,
+    OP_LOADM=26, OP_STOREM=27,
+    OP_MOD=28, OP_SHL=29, OP_SHR=30, OP_BAND=31, OP_BOR=32, OP_BXOR=33,
+    OP_FMUL=34, OP_FDIV=35, OP_ADD64=36, OP_MUL64=37
 } Op;
 
+// ---- Native-Indizes für OP_CALL (wie in src/vm.h) ----
+typedef enum {
+    NAT_GPIO_MODE=0, NAT_GPIO_WRITE=1, NAT_SLEEP_MS=2, NAT_GPIO_READ=3,
+    NAT_PRINT_INT=4,
+    NAT_GPIO_MODE_MASK=5, NAT_GPIO_WRITE_MASK=6, NAT_GPIO_READ_PORT=7,
+    NAT_GPIO_ON_EDGE=8, NAT_WAIT_EVENT=9,
+    NAT_MEM_FILL=10, NAT_MEM_COPY=11, NAT_MEM_SUM=12, NAT_MEM_MAX=13,
+    NAT_ADC_SAMPLE=14, NAT_ADC_READ=15, NAT_ADC_BLOCK_AVG=16, NAT_COUNT_ABOVE=17,
+    NAT_FIR_APPLY=18, NAT_YIELD=19
+} Native;
+
+// Operanden-Bytes nach dem Opcode (muss zu vm_run() passen)
+static inline int op_operand_len(uint8_t op){
+    switch(op){
+        case OP_PUSHI: case OP_JMP: case OP_JZ: case OP_CALLUSER: return 4;
+        case OP_LOADL: case OP_STOREL: case OP_CALL:             return 1;
+        default: return 0;
+    }
+}
+
 // ---- Bytebuffer ----
 typedef struct { uint8_t *data; size_t len, cap; } Buf;
 
+void buf_init(Buf *b);
+void buf_free(Buf *b);
+void buf_res(Buf *b, size_t need);
+void buf_append(Buf* dst, const uint8_t* data, size_t length);
+void emit8(Buf*b, uint8_t v);
+void emiti32(Buf*b, int32_t v);
+void emit_op(Buf*b, Op op);
+
+// ---- Relokationen ----
+// CALLUSER-Operand an Position 'at' im jeweiligen Puffer -> Adresse von funcs[func]
+typedef struct { int at; int func; } Reloc;
+typedef struct { Reloc *a; int n, cap; } RelocList;
+
+// ---- Schleifenschranken (while/for ... bound N) ----
+// Kopfadresse 'at' im jeweiligen Puffer; wandern mit dem Code wie Relokationen
+// und landen in der LOOP-Sektion (siehe src/image.h)
+typedef struct { int at; uint32_t bound; } Bound;
+typedef struct { Bound *a; int n, cap; } BoundList;
+
+void bound_add(BoundList *l, int at, uint32_t bound);
+
 // ---- Lexer ----
 typedef enum {
     T_EOF=0, T_NUMBER, T_IDENT,
@@ -29,25 +76,97 @@ typedef enum {
     // NEU:
     T_IF, T_ELSE, T_WHILE, T_FOR, T_DO,
     T_SWITCH, T_CASE, T_DEFAULT,
-    T_BREAK, T_CONTINUE, T_IMPORT, T_LET
+    T_BREAK, T_CONTINUE, T_IMPORT, T_LET,
+    T_LBRACKET, T_RBRACKET,
+    T_PERCENT, T_SHL, T_SHR, T_AMP, T_PIPE, T_CARET
 } TokType;
 
-typedef struct { TokType t; char s[128]; int ival; } Tok;
-typedef struct { const char *src; size_t i, n; Tok cur; } Lex;
+// at: Offset des Tokenanfangs in src (für Fehlerpositionen)
+typedef struct { TokType t; char s[128]; int ival; size_t at; } Tok;
+
+// Abbruch einer Übersetzung: motec_error() füllt diag und springt nach jb
+// zurück in motec_compile(); Puffer gehören dem Kontext und überleben das.
+typedef struct { jmp_buf jb; MotecDiag *diag; } Fail;
+
+typedef struct { const char *src; size_t i, n; Tok cur; Fail *fail; } Lex;
+
+#if defined(__GNUC__)
+#define MOTEC_ERROR_FN __attribute__((noreturn, format(printf, 2, 3)))
+#else
+#define MOTEC_ERROR_FN
+#endif
+// Fehler am aktuellen Token melden und die Übersetzung abbrechen
+MOTEC_ERROR_FN void motec_error(Lex *L, const char *fmt, ...);
 
 // ---- Symboltabellen ----
 typedef struct { char name[64]; uint8_t slot; } Sym;
 typedef struct { Sym a[256]; int n; } SymTab;
 
+// Arrays liegen statisch im linearen Speicher der VM: let a[N]; belegt
+// [base, base+N), top ist der Gesamtbedarf (META mem)
+typedef struct { char name[64]; uint32_t base, len; } Arr;
+typedef struct { Arr a[64]; int n; uint32_t top; } ArrTab;
+
+// ---- Funktionssymboltabelle ----
+// Jeder Rumpf wird als eigenes Fragment (body, Adressen relativ zu 0) übersetzt
+// und erst beim Linken hinter das Hauptprogramm gelegt – oder an der
+// Aufrufstelle eingefügt.
+typedef struct {
+    char name[64]; int addr; int nparams;
+    Buf body; RelocList rel; BoundList bounds;
+    int defined;    // Rumpf vollständig übersetzt
+    int inl_size;   // Größe beim Inlinen
+    int used;       // wird out-of-line gebraucht
+} Func;
+
+// Verschachtelungstiefe von Ausdrücken und Anweisungen; begrenzt den
+// Stackverbrauch des rekursiven Abstiegs bei fremden Quelltexten
+#define MOTEC_MAX_DEPTH 200
+
 // ---- Parser ----
+// Der ganze Zustand einer Übersetzung, damit mehrere gleichzeitig laufen können
 typedef struct {
     Lex L;
     SymTab syms;
+    ArrTab arrs;
     Buf *out;
     // NEU für break/continue:
     int break_stack[64];
     int continue_stack[64];
     int bc_sp;
+    // Relokationen des Puffers 'out' (Hauptprogramm oder Funktionsrumpf)
+    RelocList *rel;
+    BoundList *bounds; // Schleifenschranken des Puffers 'out'
+    int inline_max;   // maximale Größe inlinebarer Funktionen in Bytes, 0 = aus
+    // Yield-Stellen (nur im Hauptprogramm): id und Adresse hinter dem CALL
+    Buf *main_out;
+    int32_t yield_id[64]; uint32_t yield_at[64]; int nyield;
+    Func funcs[256]; int nfuncs;
+    // Einstiegsadressen von Funktionen, die als Wert referenziert werden (Interrupt-Handler)
+    int32_t async_entry[256]; int nasync;
+    Buf hold;         // zurückgestellter Code (for-Post-Teile), als Stapel
+    int depth;
 } P;
 
+void lex_init(Lex *L, const char *src, size_t n, Fail *fail);
+void advance(Lex *L);
+int  match(Lex *L, TokType t);
+void expect(Lex *L, TokType t);
+uint8_t sym_get_slot(P *p, const char *name);
+
+void parse_program(P *p);
+void parse_stmt(P *p);
+void parse_expr(P *p);
+void parse_call_and_emit(P *p, const char *name);
+void parse_let_stmt(P *p);
+
+// Arrays (motec.c): Index des Arrays oder -1; nach '[' Index parsen und
+// die Elementadresse auf den Stack legen
+int  arr_find(const P *p, const char *name);
+void arr_declare(P *p, const char *name, int len);
+void parse_array_addr(P *p, int a);
+
+// lo, hi = add64(...)/mul64(...): nach "lo," aufzurufen
+void parse_pair_assign(P *p, const char *lo);
+
 #endif
\ No newline at end of file
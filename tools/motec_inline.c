@@ -0,0 +1,93 @@
+// motec_inline.c – Einfügen kleiner Funktionsrümpfe an der Aufrufstelle
+#include <stdlib.h>
+#include <string.h>
+#include "motec_inline.h"
+
+static int32_t rd_i32(const uint8_t *p){ int32_t v; memcpy(&v,p,4); return v; }
+static void    wr_i32(uint8_t *p, int32_t v){ memcpy(p,&v,4); }
+
+// Neues Layout eines Fragments: off[pc] = Zieloffset (len+1 Einträge), liefert Gesamtgröße
+static int layout(const Buf *frag, int *off){
+    size_t len = frag->len;
+    uint8_t *reach = (uint8_t*)calloc(len+1, 1);
+    size_t *work = (size_t*)malloc((len+1)*sizeof(size_t)); int wn = 0;
+    if (len){ reach[0] = 1; work[wn++] = 0; }
+    while (wn){
+        size_t ip = work[--wn];
+        uint8_t op = frag->data[ip];
+        size_t next = ip + 1 + op_operand_len(op);
+        size_t succ[2]; int ns = 0;
+        if (op == OP_JMP || op == OP_JZ) succ[ns++] = (size_t)rd_i32(frag->data+ip+1);
+        if (op != OP_JMP && op != OP_RET && op != OP_HALT) succ[ns++] = next;
+        for (int k=0;k<ns;k++)
+            if (succ[k] < len && !reach[succ[k]]){ reach[succ[k]] = 1; work[wn++] = succ[k]; }
+    }
+
+    // Letzte erreichbare Instruktion: ein RET dort fällt einfach durch
+    size_t last = len;
+    for (size_t ip=0; ip<len; ip += 1+op_operand_len(frag->data[ip])) if (reach[ip]) last = ip;
+
+    int cur = 0;
+    for (size_t ip=0; ip<len; ){
+        uint8_t op = frag->data[ip];
+        int sz = 1 + op_operand_len(op);
+        off[ip] = cur;
+        if (reach[ip]){
+            if (op == OP_RET) cur += ip == last ? 0 : 5;
+            else cur += sz;
+        }
+        for (int k=1;k<sz;k++) off[ip+k] = cur;
+        ip += sz;
+    }
+    off[len] = cur;
+    free(reach); free(work);
+    return cur;
+}
+
+int inline_size(const Buf *frag){
+    int *off = (int*)malloc((frag->len+1)*sizeof(int));
+    int n = layout(frag, off);
+    free(off);
+    return n;
+}
+
+int inline_addr(const Buf *frag, size_t pc){
+    int *off = (int*)malloc((frag->len+1)*sizeof(int));
+    layout(frag, off);
+    size_t next = pc + 1 + op_operand_len(frag->data[pc]);
+    int at = next <= frag->len && off[next] > off[pc] ? off[pc] : -1;   // unerreichbar oder RET am Ende
+    free(off);
+    return at;
+}
+
+void inline_fragment(Buf *dst, const Buf *frag){
+    size_t len = frag->len;
+    int *off = (int*)malloc((len+1)*sizeof(int));
+    int total = layout(frag, off);
+    int32_t base = (int32_t)dst->len;
+    buf_res(dst, dst->len + total);
+
+    for (size_t ip=0; ip<len; ){
+        uint8_t op = frag->data[ip];
+        int sz = 1 + op_operand_len(op);
+        int emitted = (ip+sz <= len ? off[ip+sz] : total) - off[ip];
+        if (op == OP_RET){
+            if (emitted){ emit_op(dst, OP_JMP); emiti32(dst, base + total); }
+        } else if (emitted){
+            buf_append(dst, frag->data+ip, sz);
+            if (op == OP_JMP || op == OP_JZ){
+                int32_t t = rd_i32(frag->data+ip+1);
+                wr_i32(dst->data + dst->len - 4, base + off[t]);
+            }
+        }
+        ip += sz;
+    }
+    free(off);
+}
+
+void relocate_jumps(Buf *b, size_t start, size_t len, int32_t delta){
+    for (size_t ip=start; ip<start+len; ip += 1+op_operand_len(b->data[ip])){
+        uint8_t op = b->data[ip];
+        if (op == OP_JMP || op == OP_JZ) wr_i32(b->data+ip+1, rd_i32(b->data+ip+1) + delta);
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef MOTEC_INLINE_H
+#define MOTEC_INLINE_H
+
+#include "motec_core.h"
+
+// Funktionsrümpfe werden als eigenständige Fragmente übersetzt: Sprungziele
+// relativ zum Fragmentanfang, abgeschlossen mit RET.
+
+// Größe in Bytes, die ein Fragment inline an der Aufrufstelle belegt
+int inline_size(const Buf *frag);
+
+// Hängt frag an dst an. Unerreichbarer Code entfällt, RET wird zum Sprung
+// hinter die Kopie (bzw. entfällt am Ende); Sprungziele werden relokiert.
+void inline_fragment(Buf *dst, const Buf *frag);
+
+// Offset der Instruktion pc innerhalb der Kopie, -1 wenn sie entfällt
+int inline_addr(const Buf *frag, size_t pc);
+
+// Addiert delta auf alle JMP/JZ-Ziele im Bereich [start, start+len)
+void relocate_jumps(Buf *b, size_t start, size_t len, int32_t delta);
+
+#endif
@@ -0,0 +1,249 @@
+// motec_liveness.c – Slot-Zuteilung für Locals per Lebendigkeitsanalyse
+//
+// sym_get_slot() vergibt je Bezeichner einen festen "virtuellen" Slot. Hier
+// wird auf dem erzeugten Bytecode rückwärts die Lebendigkeit je Instruktion
+// berechnet, daraus ein Interferenzgraph gebaut und gierig eingefärbt.
+//
+// Alle Funktionen teilen sich dasselbe Locals-Array. Ein CALLUSER wird daher
+// als Instruktion behandelt, die
+//   - alles liest, was am Funktionseinstieg lebendig ist (globale Variablen), und
+//   - jede Variable schreiben *kann*, die der Callee (transitiv) speichert.
+// Letzteres tötet keine Lebendigkeit, erzeugt aber Interferenz mit allem,
+// was über den Aufruf hinweg lebendig bleibt.
+#include <stdlib.h>
+#include <string.h>
+#include "motec_liveness.h"
+
+#define NV 256
+
+typedef struct { uint64_t w[NV/64]; } Set;
+
+static inline void set_add(Set *s, int i){ s->w[i>>6] |= 1ull << (i&63); }
+static inline void set_del(Set *s, int i){ s->w[i>>6] &= ~(1ull << (i&63)); }
+static inline int  set_has(const Set *s, int i){ return (s->w[i>>6] >> (i&63)) & 1; }
+static inline void set_or(Set *d, const Set *s){ for(int k=0;k<NV/64;k++) d->w[k] |= s->w[k]; }
+static inline int  set_eq(const Set *a, const Set *b){ return !memcmp(a, b, sizeof(Set)); }
+
+typedef struct {
+    int n;
+    uint32_t *pc;
+    uint8_t  *op;
+    int32_t  *arg;
+    int      *succ;    // 2 je Instruktion, -1 = keiner
+    int      *callee;  // Funktions-ID bei CALLUSER, sonst -1
+} Code;
+
+static int32_t rd_i32(const uint8_t *p){ int32_t v; memcpy(&v,p,4); return v; }
+
+static void code_free(Code *C){
+    free(C->pc); free(C->op); free(C->arg); free(C->succ); free(C->callee);
+}
+
+static int decode(Code *C, const Buf *b, int **at_out){
+    size_t len = b->len;
+    C->pc  = (uint32_t*)malloc((len+1)*sizeof(uint32_t));
+    C->op  = (uint8_t*) malloc(len+1);
+    C->arg = (int32_t*) malloc((len+1)*sizeof(int32_t));
+    int *at = (int*)malloc((len+1)*sizeof(int));
+    for (size_t i=0;i<=len;i++) at[i] = -1;
+
+    int n = 0;
+    for (size_t ip=0; ip<len; ){
+        uint8_t op = b->data[ip];
+        int ol = op_operand_len(op);
+        if (ip+1+ol > len){ free(at); return 0; }
+        at[ip] = n;
+        C->pc[n] = (uint32_t)ip; C->op[n] = op;
+        C->arg[n] = ol==4 ? rd_i32(b->data+ip+1) : ol==1 ? b->data[ip+1] : 0;
+        n++; ip += 1+ol;
+    }
+    at[len] = n;
+    C->n = n;
+    *at_out = at;
+    return 1;
+}
+
+// Sprungziel als Instruktionsindex; n (Codeende) zählt als kein Nachfolger
+static int target(const Code *C, const int *at, size_t len, int32_t addr){
+    if (addr < 0 || (size_t)addr > len || at[addr] < 0) return -2;
+    return at[addr] < C->n ? at[addr] : -1;
+}
+
+int alloc_local_slots(Buf *code, const int32_t *async, int nasync,
+                      const int32_t *pin, int npin, int *map){
+    Code C; int *at;
+    memset(&C, 0, sizeof(C));
+    if (!decode(&C, code, &at)){ code_free(&C); return -1; }
+    int n = C.n;
+
+    // ---- Kontrollfluss ----
+    C.succ   = (int*)malloc((2*n+1)*sizeof(int));
+    C.callee = (int*)malloc((n+1)*sizeof(int));
+    int *func_at = (int*)malloc((n+1)*sizeof(int));   // Instruktion -> Funktions-ID
+    int *entry   = (int*)malloc((n+1)*sizeof(int));   // Funktions-ID -> Instruktion
+    int nf = 0;
+    for (int i=0;i<n;i++) func_at[i] = -1;
+
+    for (int i=0;i<n;i++){
+        int *s = &C.succ[2*i];
+        s[0] = s[1] = -1; C.callee[i] = -1;
+        int fall = i+1 < n ? i+1 : -1;
+        switch (C.op[i]){
+            case OP_HALT: case OP_RET: break;
+            case OP_JMP: case OP_JZ: case OP_CALLUSER: {
+                int t = target(&C, at, code->len, C.arg[i]);
+                if (t == -2){ free(at); free(func_at); free(entry); code_free(&C); return -1; }
+                if (C.op[i] == OP_CALLUSER){
+                    s[0] = fall;
+                    if (t >= 0){
+                        if (func_at[t] < 0){ func_at[t] = nf; entry[nf++] = t; }
+                        C.callee[i] = func_at[t];
+                    }
+                } else {
+                    s[0] = t;
+                    if (C.op[i] == OP_JZ) s[1] = fall;
+                }
+            } break;
+            default: s[0] = fall; break;
+        }
+    }
+    // Interrupt-Handler: alle Instruktionen, die von ihnen aus (auch über Aufrufe) erreichbar sind
+    uint8_t *in_async = (uint8_t*)calloc(n+1, 1);
+    {
+        int *stack = (int*)malloc((n+1)*sizeof(int)); int sn = 0;
+        for (int k=0;k<nasync;k++){
+            int t = target(&C, at, code->len, async[k]);
+            if (t >= 0 && !in_async[t]){ in_async[t] = 1; stack[sn++] = t; }
+        }
+        while (sn){
+            int i = stack[--sn];
+            int next[3] = { C.succ[2*i], C.succ[2*i+1], C.callee[i] >= 0 ? entry[C.callee[i]] : -1 };
+            for (int k=0;k<3;k++)
+                if (next[k] >= 0 && !in_async[next[k]]){ in_async[next[k]] = 1; stack[sn++] = next[k]; }
+        }
+        free(stack);
+    }
+    int *pinned = (int*)malloc((npin ? npin : 1)*sizeof(int));
+    for (int k=0;k<npin;k++) pinned[k] = target(&C, at, code->len, pin[k]);
+    free(at);
+
+    // ---- Funktionszusammenfassung: welche Slots kann ein Aufruf schreiben ----
+    Set *maydef = (Set*)calloc(nf ? nf : 1, sizeof(Set));
+    uint8_t *seen = (uint8_t*)malloc(n+1);
+    int *work = (int*)malloc((n+1)*sizeof(int));
+    uint8_t *calls = (uint8_t*)calloc((size_t)(nf ? nf : 1) * (nf ? nf : 1), 1);
+    for (int f=0; f<nf; f++){
+        memset(seen, 0, n+1);
+        int wn = 0; work[wn++] = entry[f]; seen[entry[f]] = 1;
+        while (wn){
+            int i = work[--wn];
+            if (C.op[i] == OP_STOREL) set_add(&maydef[f], C.arg[i]);
+            if (C.callee[i] >= 0) calls[f*nf + C.callee[i]] = 1;
+            for (int k=0;k<2;k++){
+                int s = C.succ[2*i+k];
+                if (s >= 0 && !seen[s]){ seen[s] = 1; work[wn++] = s; }
+            }
+        }
+    }
+    for (int changed=1; changed; ){
+        changed = 0;
+        for (int f=0; f<nf; f++) for (int g=0; g<nf; g++){
+            if (!calls[f*nf+g]) continue;
+            Set t = maydef[f]; set_or(&t, &maydef[g]);
+            if (!set_eq(&t, &maydef[f])){ maydef[f] = t; changed = 1; }
+        }
+    }
+
+    // ---- Lebendigkeit (rückwärts bis zum Fixpunkt) ----
+    Set *in  = (Set*)calloc(n+1, sizeof(Set));
+    Set *out = (Set*)calloc(n+1, sizeof(Set));
+    for (int changed=1; changed; ){
+        changed = 0;
+        for (int i=n-1; i>=0; i--){
+            Set o; memset(&o, 0, sizeof(o));
+            for (int k=0;k<2;k++){ int s = C.succ[2*i+k]; if (s >= 0) set_or(&o, &in[s]); }
+            Set x = o;
+            if (C.op[i] == OP_STOREL) set_del(&x, C.arg[i]);
+            if (C.op[i] == OP_LOADL)  set_add(&x, C.arg[i]);
+            if (C.callee[i] >= 0)     set_or(&x, &in[entry[C.callee[i]]]);
+            if (!set_eq(&o, &out[i]) || !set_eq(&x, &in[i])){ out[i] = o; in[i] = x; changed = 1; }
+        }
+    }
+
+    // ---- Interferenz ----
+    Set *adj = (Set*)calloc(NV, sizeof(Set));
+    Set used; memset(&used, 0, sizeof(used));
+    int order[NV], norder = 0;
+    for (int i=0;i<n;i++){
+        if (C.op[i] == OP_LOADL || C.op[i] == OP_STOREL){
+            int v = C.arg[i];
+            if (!set_has(&used, v)){ set_add(&used, v); order[norder++] = v; }
+        }
+        if (C.op[i] == OP_STOREL){
+            int d = C.arg[i];
+            for (int v=0; v<NV; v++)
+                if (v != d && set_has(&out[i], v)){ set_add(&adj[d], v); set_add(&adj[v], d); }
+        }
+        if (C.callee[i] >= 0){
+            const Set *md = &maydef[C.callee[i]];
+            for (int d=0; d<NV; d++){
+                if (!set_has(md, d)) continue;
+                for (int v=0; v<NV; v++)
+                    if (v != d && set_has(&out[i], v)){ set_add(&adj[d], v); set_add(&adj[v], d); }
+            }
+        }
+    }
+
+    // Variablen der Handler interferieren mit allem: sie können jederzeit gelesen/geschrieben werden
+    for (int i=0;i<n;i++){
+        if (!in_async[i] || (C.op[i] != OP_LOADL && C.op[i] != OP_STOREL)) continue;
+        int h = C.arg[i];
+        for (int v=0; v<NV; v++)
+            if (v != h && set_has(&used, v)){ set_add(&adj[h], v); set_add(&adj[v], h); }
+    }
+
+    // An Yield-Stellen lebendige Variablen teilen ihren Slot mit niemandem
+    for (int k=0;k<npin;k++){
+        if (pinned[k] < 0) continue;
+        const Set *L = &in[pinned[k]];
+        for (int v=0; v<NV; v++){
+            if (!set_has(L, v)) continue;
+            for (int u=0; u<NV; u++)
+                if (u != v && set_has(&used, u)){ set_add(&adj[v], u); set_add(&adj[u], v); }
+        }
+    }
+    free(pinned);
+
+    // ---- Gierige Färbung in Reihenfolge des ersten Auftretens ----
+    int color[NV]; int nslots = 0;
+    for (int v=0; v<NV; v++) color[v] = -1;
+    for (int k=0; k<norder; k++){
+        int v = order[k];
+        Set taken; memset(&taken, 0, sizeof(taken));
+        for (int u=0; u<NV; u++) if (color[u] >= 0 && set_has(&adj[v], u)) set_add(&taken, color[u]);
+        int c = 0; while (set_has(&taken, c)) c++;
+        color[v] = c;
+        if (c+1 > nslots) nslots = c+1;
+    }
+
+    for (int i=0;i<n;i++)
+        if (C.op[i] == OP_LOADL || C.op[i] == OP_STOREL)
+            code->data[C.pc[i]+1] = (uint8_t)color[C.arg[i]];
+    if (map) for (int v=0; v<NV; v++) map[v] = color[v];
+
+    free(adj); free(in); free(out); free(in_async);
+    free(maydef); free(seen); free(work); free(calls);
+    free(func_at); free(entry);
+    code_free(&C);
+    return nslots;
+}
+
+int count_local_slots(const Buf *code){
+    int n = 0;
+    for (size_t ip=0; ip<code->len; ip += 1+op_operand_len(code->data[ip])){
+        uint8_t op = code->data[ip];
+        if ((op == OP_LOADL || op == OP_STOREL) && ip+1 < code->len && code->data[ip+1]+1 > n)
+            n = code->data[ip+1]+1;
+    }
+    return n;
+}
@@ -0,0 +1,22 @@
+#ifndef MOTEC_LIVENESS_H
+#define MOTEC_LIVENESS_H
+
+#include "motec_core.h"
+
+// Lebendigkeitsanalyse über den fertigen Bytecode: Variablen, deren
+// Lebensdauern sich nicht überschneiden, teilen sich einen Locals-Slot.
+// Schreibt die LOADL/STOREL-Operanden in code um und liefert die Anzahl
+// benötigter Slots (-1, wenn der Code nicht analysiert werden konnte).
+// async: Einstiege von Interrupt-Handlern, die zwischen beliebigen
+// Instruktionen laufen können; ihre Variablen bekommen eigene Slots.
+// pin: Adressen (Yield-Stellen), an denen jede dort lebendige Variable
+// ihren Slot allein hat – beim Austausch wird Zustand nach Namen kopiert,
+// ein toter Namensvetter im selben Slot würde ihn überschreiben.
+// map (256 Einträge, darf NULL sein): virtueller -> tatsächlicher Slot, -1 unbenutzt.
+int alloc_local_slots(Buf *code, const int32_t *async, int nasync,
+                      const int32_t *pin, int npin, int *map);
+
+// Höchster benutzter Slot + 1, ohne etwas umzuschreiben
+int count_local_slots(const Buf *code);
+
+#endif
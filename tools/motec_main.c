@@ -0,0 +1,45 @@
+// motec_main.c – Kommandozeile des Compilers: Datei lesen, libmotec, Image schreiben
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libmotec.h"
+
+// ---- I/O ----
+static char* read_file(const char*path,size_t*len){
+    FILE*f=fopen(path,"rb"); if(!f){perror("open"); exit(1);}
+    fseek(f,0,SEEK_END); long n=ftell(f); fseek(f,0,SEEK_SET);
+    char*buf=(char*)malloc(n+1); *len=fread(buf,1,n,f); buf[*len]=0; fclose(f);
+    return buf;
+}
+static void write_file(const char*path,const uint8_t*data,size_t n){
+    FILE*f=fopen(path,"wb"); if(!f){perror("open out"); exit(1);}
+    fwrite(data,1,n,f); fclose(f);
+}
+
+// ---- main ----
+int main(int argc,char**argv){
+    MotecOptions opt=MOTEC_OPTIONS_DEFAULT;
+    const char*in=NULL,*outp=NULL;
+    for(int i=1;i<argc;i++){
+        if(!strcmp(argv[i],"--no-share-slots")) opt.share_slots=0;
+        else if(!strcmp(argv[i],"--no-inline")) opt.inline_max=0;
+        else if(!strncmp(argv[i],"--inline=",9)) opt.inline_max=atoi(argv[i]+9);
+        else if(!in) in=argv[i];
+        else if(!outp) outp=argv[i];
+        else { in=NULL; break; }
+    }
+    if(!in||!outp){ fprintf(stderr,"Usage: %s [--no-share-slots] [--inline=N|--no-inline] in.mo out.bin\n",argv[0]); return 1; }
+    size_t n; char*src=read_file(in,&n);
+    Motec*m=motec_new(&opt);
+    if(!m){ fprintf(stderr,"kein Speicher\n"); return 1; }
+    uint8_t*image; size_t ilen;
+    if(motec_compile(m,src,n,&image,&ilen)){
+        const MotecDiag*d=motec_diag(m);
+        fprintf(stderr,"%s:%d:%d: %s\n",in,d->line,d->col,d->msg);
+        motec_free(m); free(src);
+        return 2;
+    }
+    write_file(outp,image,ilen);
+    free(image); motec_free(m); free(src);
+    return 0;
+}
@@ -8,12 +8,27 @@ names = {
     13:"DUP", 14:"DROP", 15:"SWAP", 16:"OVER",
     17:"GT", 18:"GE", 19:"LE", 20:"NE",
     21:"NOT", 22:"AND", 23:"OR",
-    24:"CALLUSER", 25:"RET"
+    24:"CALLUSER", 25:"RET", 26:"LOADM", 27:"STOREM",
+    28:"MOD", 29:"SHL", 30:"SHR", 31:"BAND", 32:"BOR", 33:"BXOR",
+    34:"FMUL", 35:"FDIV", 36:"ADD64", 37:"MUL64"
 }
 
 def rd_i32(buf, i=0):
     return struct.unpack_from("<i", buf, i)[0]
 
+def split_image(data):
+    """Liefert (Sektionen, Code); Images ohne Header sind reiner Bytecode."""
+    if data[:4] != b"MOTE":
+        return {}, data
+    nsect = struct.unpack_from("<H", data, 6)[0]
+    off, sects = 8, {}
+    for _ in range(nsect):
+        tag = data[off:off+4].decode("ascii")
+        ln = struct.unpack_from("<I", data, off+4)[0]
+        sects[tag] = data[off+8:off+8+ln]
+        off += 8 + ln
+    return sects, sects.get("CODE", b"")
+
 def disasm(code):
     ip = 0
     while ip < len(code):
@@ -37,7 +52,17 @@ def main():
         print("Usage: motedis.py file.bin")
         sys.exit(1)
     with open(sys.argv[1],"rb") as f:
-        code = f.read()
+        sects, code = split_image(f.read())
+    if "META" in sects and len(sects["META"]) >= 2:
+        print(f"; locals={struct.unpack_from('<H', sects['META'], 0)[0]}")
+    if "META" in sects and len(sects["META"]) >= 6:
+        print(f"; mem={struct.unpack_from('<I', sects['META'], 2)[0]}")
+    y = sects.get("YELD", b"")
+    for k in range(0, len(y) - 7, 8):
+        print(f"; yield {struct.unpack_from('<I', y, k)[0]} @{struct.unpack_from('<I', y, k+4)[0]:04X}")
+    l = sects.get("LOOP", b"")
+    for k in range(0, len(l) - 7, 8):
+        print(f"; loop @{struct.unpack_from('<I', l, k)[0]:04X} bound {struct.unpack_from('<I', l, k+4)[0]}")
     disasm(code)
 
 if __name__=="__main__":
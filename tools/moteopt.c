@@ -0,0 +1,492 @@
+// moteopt.c – Whole-Program-Optimierer für gelinkte Mote-Images (.bin)
+//
+// Arbeitet direkt auf dem Bytecode, also auch für Images aus asm_min.py,
+// die nie durch motec gelaufen sind:
+//   - Jump-Threading (JMP->JMP, JZ->JMP, JMP->RET/HALT)
+//   - Entfernen unerreichbarer Blöcke und toter Funktionen (Wurzeln: Einstieg + CALLUSER-Ziele)
+//   - STOREL x; LOADL x  ->  DUP; STOREL x
+//   - DUP; DROP und PUSHI; DROP entfernen
+//   - Sprünge auf die Folgeinstruktion entfernen
+//   - Sprungziele beim Neuschreiben relokieren
+//
+// --verify führt Original und Ergebnis mit einer deterministischen HAL aus
+// und vergleicht jeden HAL-Aufruf.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "../src/vm.h"
+#include "../src/hal.h"
+#include "../src/vm_ops.h"
+#include "../src/image.h"
+
+// ---- Instruktionsliste ----
+typedef struct {
+    uint32_t pc;      // Adresse im Original
+    uint8_t  op;
+    int32_t  arg;     // PUSHI-Wert bzw. LOADL/STOREL/CALL-Index
+    int      tgt;     // Sprungziel als Instruktionsindex (n = Codeende), sonst -1
+    uint8_t  live;
+    uint8_t  func;    // war CALLUSER-Ziel im Original
+    uint8_t  site;    // Yield-Stelle: Einsprung beim Austausch, wie ein Sprungziel
+} Ins;
+
+typedef struct { Ins *v; int n; } Prog;
+
+static int32_t rd_i32(const uint8_t *p){ int32_t v; memcpy(&v,p,4); return v; }
+
+static int is_jump(uint8_t op){ return op==OP_JMP || op==OP_JZ || op==OP_CALLUSER; }
+
+static int decode(Prog *P, const uint8_t *code, size_t len){
+    int *at = (int*)malloc((len+1)*sizeof(int));
+    P->v = (Ins*)calloc(len ? len : 1, sizeof(Ins)); P->n = 0;
+    for (size_t i=0;i<=len;i++) at[i] = -1;
+
+    size_t ip = 0;
+    while (ip < len){
+        int ol = vm_op_operand_len(code[ip]);
+        if (ol < 0 || ip+1+ol > len){
+            fprintf(stderr,"mote-opt: ungültige Instruktion bei %04zX\n", ip);
+            free(at); return 0;
+        }
+        Ins *I = &P->v[P->n];
+        at[ip] = P->n;
+        I->pc = (uint32_t)ip; I->op = code[ip]; I->tgt = -1; I->live = 1;
+        if (ol == 4) I->arg = rd_i32(code+ip+1);
+        else if (ol == 1) I->arg = code[ip+1];
+        P->n++; ip += 1+ol;
+    }
+    at[len] = P->n;
+
+    // Handler-Adressen für gpio_on_edge sind Code-Referenzen: PUSHI addr; CALL NAT_GPIO_ON_EDGE.
+    // Kommt die Adresse anders zustande, ist nicht sicher erkennbar, welcher Code lebt.
+    for (int i=0;i<P->n;i++){
+        if (P->v[i].op != OP_CALL || P->v[i].arg != NAT_GPIO_ON_EDGE) continue;
+        if (i == 0 || P->v[i-1].op != OP_PUSHI){
+            fprintf(stderr,"mote-opt: Handler-Adresse bei %04X nicht konstant\n", P->v[i].pc);
+            free(at); return 0;
+        }
+        P->v[i-1].tgt = -2;   // unten wie ein Sprungziel aufgelöst
+    }
+
+    for (int i=0;i<P->n;i++){
+        Ins *I = &P->v[i];
+        if (!is_jump(I->op) && I->tgt != -2) continue;
+        if (I->arg < 0 || (size_t)I->arg > len || at[I->arg] < 0){
+            fprintf(stderr,"mote-opt: Sprungziel %d bei %04X liegt nicht auf einer Instruktion\n",
+                    I->arg, I->pc);
+            free(at); return 0;
+        }
+        I->tgt = at[I->arg];
+        if ((I->op == OP_CALLUSER || I->op == OP_PUSHI) && I->tgt < P->n) P->v[I->tgt].func = 1;
+    }
+    free(at);
+    return 1;
+}
+
+// Nächste lebende Instruktion ab i (n = Codeende)
+static int next_live(const Prog *P, int i){
+    while (i < P->n && !P->v[i].live) i++;
+    return i;
+}
+
+// ---- Passes ----
+
+// Folgt Ketten unbedingter Sprünge; begrenzt, damit JMP-Zyklen terminieren.
+static int thread_target(const Prog *P, int t){
+    t = next_live(P, t);
+    for (int guard=0; guard<P->n && t<P->n && P->v[t].op==OP_JMP; guard++)
+        t = next_live(P, P->v[t].tgt);
+    return t;
+}
+
+static int pass_jump_threading(Prog *P){
+    int changed = 0;
+    for (int i=0;i<P->n;i++){
+        Ins *I = &P->v[i];
+        if (!I->live || (I->op!=OP_JMP && I->op!=OP_JZ)) continue;
+        int t = thread_target(P, I->tgt);
+        if (t != next_live(P, I->tgt)){ I->tgt = t; changed++; }
+        // JMP auf RET/HALT: direkt zurückkehren bzw. anhalten
+        if (I->op==OP_JMP && t<P->n && (P->v[t].op==OP_RET || P->v[t].op==OP_HALT)){
+            I->op = P->v[t].op; I->tgt = -1; changed++;
+        }
+    }
+    return changed;
+}
+
+static int pass_jump_to_next(Prog *P){
+    int changed = 0;
+    for (int i=0;i<P->n;i++){
+        Ins *I = &P->v[i];
+        if (!I->live || (I->op!=OP_JMP && I->op!=OP_JZ)) continue;
+        if (next_live(P, I->tgt) != next_live(P, i+1)) continue;
+        if (I->op == OP_JMP) I->live = 0;
+        else { I->op = OP_DROP; I->tgt = -1; }   // Bedingung trotzdem verbrauchen
+        changed++;
+    }
+    return changed;
+}
+
+static int pass_reachability(Prog *P, int *dead_funcs){
+    uint8_t *seen = (uint8_t*)calloc(P->n+1, 1);
+    int *work = (int*)malloc((P->n+1)*sizeof(int)); int wn = 0;
+    int root = next_live(P, 0);
+    if (root < P->n){ seen[root]=1; work[wn++]=root; }
+
+    while (wn){
+        int i = work[--wn];
+        Ins *I = &P->v[i];
+        int succ[2], ns = 0;
+        switch (I->op){
+            case OP_HALT: case OP_RET: break;
+            case OP_JMP: succ[ns++] = next_live(P, I->tgt); break;
+            case OP_JZ:  succ[ns++] = next_live(P, I->tgt); succ[ns++] = next_live(P, i+1); break;
+            case OP_CALLUSER: succ[ns++] = next_live(P, I->tgt); succ[ns++] = next_live(P, i+1); break;
+            case OP_PUSHI:    // Handler-Adresse: Wurzel wie ein CALLUSER-Ziel
+                if (I->tgt >= 0) succ[ns++] = next_live(P, I->tgt);
+                succ[ns++] = next_live(P, i+1); break;
+            default: succ[ns++] = next_live(P, i+1); break;
+        }
+        for (int k=0;k<ns;k++){
+            int s = succ[k];
+            if (s < P->n && !seen[s]){ seen[s]=1; work[wn++]=s; }
+        }
+    }
+
+    int changed = 0;
+    for (int i=0;i<P->n;i++){
+        if (P->v[i].live && !seen[i]){
+            if (P->v[i].func) (*dead_funcs)++;
+            P->v[i].live = 0; changed++;
+        }
+    }
+    free(seen); free(work);
+    return changed;
+}
+
+static int pass_peephole(Prog *P){
+    // Instruktionen, die Sprungziel sind, dürfen nicht mit ihrem Vorgänger verschmolzen werden
+    uint8_t *label = (uint8_t*)calloc(P->n+1, 1);
+    label[next_live(P, 0)] = 1;
+    for (int i=0;i<P->n;i++){
+        if (P->v[i].live && P->v[i].tgt >= 0) label[next_live(P, P->v[i].tgt)] = 1;
+        if (P->v[i].live && P->v[i].site) label[i] = 1;
+    }
+
+    int changed = 0;
+    for (int i=next_live(P,0); i<P->n; ){
+        int j = next_live(P, i+1);
+        if (j >= P->n) break;
+        Ins *A = &P->v[i], *B = &P->v[j];
+        if (!label[j]){
+            if (A->op==OP_STOREL && B->op==OP_LOADL && A->arg==B->arg){
+                A->op = OP_DUP;
+                B->op = OP_STOREL;
+                changed++; i = next_live(P, j+1); continue;
+            }
+            if ((A->op==OP_DUP || (A->op==OP_PUSHI && A->tgt<0)) && B->op==OP_DROP){
+                A->live = 0; B->live = 0;
+                changed++; i = next_live(P, j+1); continue;
+            }
+        }
+        i = j;
+    }
+    free(label);
+    return changed;
+}
+
+// ---- Ausgabe mit Relokation ----
+// npc_out (darf NULL sein): neue Adresse je Instruktionsindex, free() durch Aufrufer
+static uint8_t *emit(const Prog *P, size_t *out_len, uint32_t **npc_out){
+    uint32_t *npc = (uint32_t*)malloc((P->n+1)*sizeof(uint32_t));
+    uint32_t pc = 0;
+    for (int i=0;i<P->n;i++){
+        npc[i] = pc;
+        if (P->v[i].live) pc += 1 + vm_op_operand_len(P->v[i].op);
+    }
+    npc[P->n] = pc;
+
+    uint8_t *out = (uint8_t*)malloc(pc ? pc : 1);
+    size_t k = 0;
+    for (int i=0;i<P->n;i++){
+        const Ins *I = &P->v[i];
+        if (!I->live) continue;
+        out[k++] = I->op;
+        int ol = vm_op_operand_len(I->op);
+        if (ol == 4){
+            int32_t v = I->tgt >= 0 ? (int32_t)npc[next_live(P, I->tgt)] : I->arg;
+            memcpy(out+k, &v, 4); k += 4;
+        } else if (ol == 1){
+            out[k++] = (uint8_t)I->arg;
+        }
+    }
+    if (npc_out) *npc_out = npc; else free(npc);
+    *out_len = k;
+    return out;
+}
+
+// ---- Verifikation mit deterministischer HAL ----
+typedef struct { uint8_t kind; int a, b, c, r; } HalEvent;
+
+typedef struct {
+    struct HAL hal;                                  // erstes Feld: ctx == TraceHal*
+
+    HalEvent *log; size_t n, limit;
+    int irq_pin, irq_pending;
+    uint32_t rng;
+    jmp_buf stop;
+} TraceHal;
+
+static void trace_push(TraceHal *T, uint8_t kind, int a, int b, int c, int r){
+    if (T->n >= T->limit) longjmp(T->stop, 1);
+    T->log[T->n++] = (HalEvent){ kind, a, b, c, r };
+}
+static uint32_t trace_input(TraceHal *T){
+    T->rng = T->rng*1103515245u + 12345u;            // reproduzierbare Eingaben
+    return T->rng >> 8;
+}
+static void th_gpio_mode (void*c,int pin,int mode){ trace_push((TraceHal*)c, 0, pin, mode, 0, 0); }
+static void th_gpio_write(void*c,int pin,int val) { trace_push((TraceHal*)c, 1, pin, val, 0, 0); }
+static void th_sleep_ms  (void*c,int ms)          { trace_push((TraceHal*)c, 2, ms, 0, 0, 0); }
+static int  th_gpio_read (void*c,int pin){
+    TraceHal *T = (TraceHal*)c;
+    int v = (int)(trace_input(T) & 1);
+    trace_push(T, 3, pin, 0, 0, v);
+    return v;
+}
+static void th_print_int (void*c,int v){ trace_push((TraceHal*)c, 4, v, 0, 0, 0); }
+static void th_gpio_mode_mask (void*c,int port,uint32_t mask,int mode){ trace_push((TraceHal*)c, 5, port, (int)mask, mode, 0); }
+static void th_gpio_write_mask(void*c,int port,uint32_t mask,uint32_t v){ trace_push((TraceHal*)c, 6, port, (int)mask, (int)v, 0); }
+static uint32_t th_gpio_read_port(void*c,int port){
+    TraceHal *T = (TraceHal*)c;
+    uint32_t v = trace_input(T);
+    trace_push(T, 7, port, 0, 0, (int)v);
+    return v;
+}
+
+typedef struct { int res; size_t sp; HalEvent *log; size_t n; } Trace;
+enum { TR_OK=0, TR_TRAP=1, TR_LIMIT=2 };
+
+// Ereignisse nur aus event_wait: sonst hinge der Zeitpunkt von der Lage der
+// sicheren Punkte ab, die der Optimierer verändern darf.
+static int th_irq_attach(void*c,int pin,int edge){
+    TraceHal *T = (TraceHal*)c;
+    trace_push(T, 8, pin, edge, 0, 0);
+    T->irq_pin = pin;
+    return 0;
+}
+static int th_event_poll(void*c,int*pin,int*edge){
+    TraceHal *T = (TraceHal*)c;
+    if (!T->irq_pending) return 0;
+    T->irq_pending = 0; *pin = T->irq_pin; *edge = EDGE_RISING;
+    return 1;
+}
+static void th_event_wait(void*c,int timeout_ms){
+    TraceHal *T = (TraceHal*)c;
+    trace_push(T, 9, timeout_ms, 0, 0, 0);
+    T->irq_pending = 1;
+}
+
+// Sample-Streams: reproduzierbare 12-Bit-Werte, protokolliert wird der Block
+static int th_adc_read(void*c,int ch,Val*dst,int n){
+    TraceHal *T = (TraceHal*)c;
+    uint32_t sum = 0;
+    for (int i=0;i<n;i++){ dst[i] = (Val)(trace_input(T) & 0xfff); sum += (uint32_t)dst[i]; }
+    trace_push(T, 10, ch, n, 0, (int)sum);
+    return n;
+}
+
+static Trace run_traced(const uint8_t *code, size_t len, uint32_t mem_cap, size_t limit){
+    static Val stack[256], locals[256];
+    static uint32_t calls[256];
+    static VmIrq irq[VM_MAX_IRQ];
+    memset(stack,0,sizeof(stack)); memset(locals,0,sizeof(locals));
+    Val *mem = (Val*)calloc(mem_cap ? mem_cap : 1, sizeof(Val));
+
+    TraceHal *T = (TraceHal*)calloc(1, sizeof(TraceHal));
+    T->hal = (struct HAL){ th_gpio_mode, th_gpio_write, th_sleep_ms, th_gpio_read, th_print_int,
+                           th_gpio_mode_mask, th_gpio_write_mask, th_gpio_read_port,
+                           th_irq_attach, th_event_poll, th_event_wait, th_adc_read };
+    T->log = (HalEvent*)malloc(limit*sizeof(HalEvent)); T->limit = limit; T->rng = 1;
+
+    VM vm = {
+        .code=code, .code_len=(uint32_t)len, .ip=0,
+        .stack=stack, .sp=0, .stack_cap=256,
+        .locals=locals, .locals_cap=256,
+        .callstack=calls, .call_cap=256, .irq=irq,
+        .mem=mem, .mem_cap=mem_cap,
+        .hal=T
+    };
+    Trace tr;
+    if (setjmp(T->stop) == 0){
+        VmRes r = vm_run(&vm);
+        while (r == VM_WAIT || r == VM_YIELD){
+            if (r == VM_WAIT) vm_wait_event(&vm, -1);
+            else trace_push(T, 11, 0, 0, 0, 0);      // Reihenfolge der yields gehört zum Verhalten
+            r = vm_run(&vm);
+        }
+        tr.res = r==VM_OK ? TR_OK : TR_TRAP;
+    }
+    else                      tr.res = TR_LIMIT;
+    tr.sp = vm.sp; tr.log = T->log; tr.n = T->n;
+    free(T); free(mem);
+    return tr;
+}
+
+static int verify(const uint8_t *a, size_t alen, const uint8_t *b, size_t blen, uint32_t mem_cap, size_t limit){
+    static const char *kinds[] = { "gpio_mode", "gpio_write", "sleep_ms", "gpio_read", "print_int",
+                                   "gpio_mode_mask", "gpio_write_mask", "gpio_read_port",
+                                   "irq_attach", "event_wait", "adc_read", "yield" };
+    static const char *res[]   = { "OK", "TRAP", "LIMIT" };
+    Trace x = run_traced(a, alen, mem_cap, limit);
+    Trace y = run_traced(b, blen, mem_cap, limit);
+    int ok = 1;
+    size_t n = x.n < y.n ? x.n : y.n;
+    for (size_t i=0;i<n && ok;i++){
+        const HalEvent *e = &x.log[i], *f = &y.log[i];
+        if (e->kind!=f->kind || e->a!=f->a || e->b!=f->b || e->c!=f->c || e->r!=f->r){
+            fprintf(stderr,"verify: HAL-Aufruf #%zu weicht ab: %s(%d,%d,%d)->%d vs. %s(%d,%d,%d)->%d\n", i,
+                    kinds[e->kind], e->a, e->b, e->c, e->r,
+                    kinds[f->kind], f->a, f->b, f->c, f->r);
+            ok = 0;
+        }
+    }
+    if (ok && x.n != y.n){
+        fprintf(stderr,"verify: Anzahl HAL-Aufrufe weicht ab: %zu vs. %zu\n", x.n, y.n); ok = 0;
+    }
+    if (ok && (x.res != y.res || (x.res == TR_OK && x.sp != y.sp))){
+        fprintf(stderr,"verify: Ende weicht ab: %s sp=%zu vs. %s sp=%zu\n",
+                res[x.res], x.sp, res[y.res], y.sp);
+        ok = 0;
+    }
+    if (ok) printf("verify: OK (%zu HAL-Aufrufe, Ende %s)\n", x.n, res[x.res]);
+    free(x.log); free(y.log);
+    return ok;
+}
+
+// ---- I/O ----
+static uint8_t *read_file(const char *path, size_t *n){
+    FILE*f=fopen(path,"rb"); if(!f){perror("open"); exit(1);}
+    fseek(f,0,SEEK_END); long len=ftell(f); fseek(f,0,SEEK_SET);
+    uint8_t*buf=(uint8_t*)malloc(len ? len : 1);
+    if (fread(buf,1,len,f) != (size_t)len){ perror("read"); exit(1); }
+    fclose(f); *n=(size_t)len;
+    return buf;
+}
+static void write_file(const char*path,const uint8_t*data,size_t n){
+    FILE*f=fopen(path,"wb"); if(!f){perror("open out"); exit(1);}
+    fwrite(data,1,n,f); fclose(f);
+}
+
+static int count_live(const Prog *P){ int c=0; for(int i=0;i<P->n;i++) c+=P->v[i].live; return c; }
+
+int main(int argc, char **argv){
+    int do_verify = 0; size_t limit = 100000;
+    const char *in = NULL, *out = NULL;
+    for (int i=1;i<argc;i++){
+        if (!strcmp(argv[i],"--verify")) do_verify = 1;
+        else if (!strcmp(argv[i],"--calls") && i+1<argc) limit = strtoul(argv[++i],NULL,10);
+        else if (!in) in = argv[i];
+        else if (!out) out = argv[i];
+        else in = NULL, i = argc;
+    }
+    if (!in || !out || !limit){
+        fprintf(stderr,"Usage: %s [--verify] [--calls N] in.bin out.bin\n", argv[0]);
+        return 1;
+    }
+
+    size_t flen; uint8_t *file = read_file(in, &flen);
+    MoteImage img;
+    if (mote_image_parse(&img, file, flen) != 0){
+        fprintf(stderr,"mote-opt: defekter Image-Header: %s\n", in);
+        free(file); return 1;
+    }
+    const uint8_t *code = img.code; size_t len = img.code_len;
+    Prog P;
+    if (!decode(&P, code, len)){
+        fprintf(stderr,"mote-opt: Image wird unverändert übernommen\n");
+        write_file(out, file, flen);
+        free(P.v); free(file);
+        return 2;
+    }
+    // Yield-Stellen (YELD) sind Code-Adressen hinter einem CALL yield: am CALL festmachen,
+    // die Stelle selbst wird Einsprung
+    MoteYield *ys = NULL;
+    int ny = mote_yields_decode(mote_image_find(&img, "YELD"), &ys);
+    int *ycall = (int*)malloc((ny > 0 ? ny : 1)*sizeof(int));
+    for (int k=0;k<ny;k++){
+        int i = 0;
+        while (i < P.n && P.v[i].pc + 2 < ys[k].addr) i++;
+        if (i == P.n || P.v[i].pc + 2 != ys[k].addr || P.v[i].op != OP_CALL || P.v[i].arg != NAT_YIELD){ ny = -1; break; }
+        ycall[k] = i;
+        if (i+1 < P.n) P.v[i+1].site = 1;
+    }
+    if (ny < 0){
+        fprintf(stderr,"mote-opt: defekte YELD-Sektion, Image wird unverändert übernommen\n");
+        write_file(out, file, flen);
+        free(ys); free(ycall); free(P.v); free(file);
+        return 2;
+    }
+
+    // Schleifenschranken (LOOP) hängen am Schleifenkopf; der ist Sprungziel und
+    // bleibt als Instruktion erhalten, solange die Schleife lebt
+    MoteLoop *ls = NULL;
+    int nl = mote_loops_decode(mote_image_find(&img, "LOOP"), &ls);
+    int *lhead = (int*)malloc((nl > 0 ? nl : 1)*sizeof(int));
+    for (int k=0;k<nl;k++){
+        int i = 0;
+        while (i < P.n && P.v[i].pc < ls[k].addr) i++;
+        lhead[k] = i < P.n && P.v[i].pc == ls[k].addr ? i : -1;   // keine Instruktion: verwerfen
+    }
+    if (nl < 0) fprintf(stderr,"mote-opt: defekte LOOP-Sektion, Schleifenschranken entfallen\n");
+
+    int n0 = P.n, dead_funcs = 0;
+    int st_thread=0, st_next=0, st_dead=0, st_peep=0;
+    for (;;){
+        int a = pass_jump_threading(&P);
+        int b = pass_jump_to_next(&P);
+        int c = pass_reachability(&P, &dead_funcs);
+        int d = pass_peephole(&P);
+        st_thread += a; st_next += b; st_dead += c; st_peep += d;
+        if (!(a|b|c|d)) break;
+    }
+
+    uint32_t *npc;
+    size_t olen; uint8_t *opt = emit(&P, &olen, &npc);
+    if (img.nsect){
+        // Header übernehmen, CODE ersetzen, Yield-Stellen umrechnen (tote fallen weg)
+        int nk = 0;
+        for (int k=0;k<ny;k++){
+            if (!P.v[ycall[k]].live) continue;
+            ys[nk].id = ys[k].id; ys[nk].addr = npc[ycall[k]] + 2; nk++;
+        }
+        uint32_t ylen; uint8_t *ybuf = mote_yields_encode(ys, nk, &ylen);
+        int lk = 0;
+        for (int k=0;k<nl;k++){
+            if (lhead[k] < 0 || !P.v[lhead[k]].live) continue;
+            ls[lk].addr = npc[lhead[k]]; ls[lk].bound = ls[k].bound; lk++;
+        }
+        uint32_t llen; uint8_t *lbuf = mote_loops_encode(ls, lk, &llen);
+        MoteSection s[MOTE_MAX_SECTIONS];
+        for (int i=0;i<img.nsect;i++){
+            s[i] = img.sect[i];
+            if (!memcmp(s[i].tag,"CODE",4)){ s[i].data = opt; s[i].len = (uint32_t)olen; }
+            if (!memcmp(s[i].tag,"YELD",4)){ s[i].data = ybuf; s[i].len = ylen; }
+            if (!memcmp(s[i].tag,"LOOP",4)){ s[i].data = lbuf; s[i].len = llen; }
+        }
+        size_t ilen; uint8_t *image = mote_image_encode(s, img.nsect, &ilen);
+        write_file(out, image, ilen);
+        free(image); free(ybuf); free(lbuf);
+    } else {
+        write_file(out, opt, olen);
+    }
+    printf("mote-opt: %zu -> %zu Bytes, %d -> %d Instruktionen "
+           "(threading %d, jmp-next %d, unerreichbar %d, tote Funktionen %d, peephole %d)\n",
+           len, olen, n0, count_live(&P), st_thread, st_next, st_dead, dead_funcs, st_peep);
+
+    int rc = 0;
+    if (do_verify && !verify(code, len, opt, olen, img.meta.mem, limit)) rc = 3;
+    free(opt); free(npc); free(ys); free(ycall); free(ls); free(lhead); free(P.v); free(file);
+    return rc;
+}
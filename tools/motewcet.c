@@ -0,0 +1,792 @@
+// motewcet.c – Statische Obergrenzen der Ausführung für Mote-Images (.bin)
+//
+// Je Funktion (Hauptprogramm, CALLUSER-Ziele, Interrupt-Handler) höchstens:
+//   - ausgeführte Instruktionen und HAL-Aufrufe
+//   - Kosten nach einem Modell je Opcode und Native (--costs, z. B. von bench_cost)
+//   - Operanden-Stack und Call-Tiefe (vm_analyze_fn)
+// Das Hauptprogramm wird an yield() geteilt: berichtet wird je Abschnitt vom
+// Start bzw. einer Yield-Stelle bis zum nächsten yield, HALT, RET oder Trap.
+//
+// Schleifen sind natürliche Schleifen (Rücksprung auf einen dominierenden
+// Kopf). Ihre Schranke kommt aus der LOOP-Sektion (motec: while/for ...
+// bound N) oder wird für Zählschleifen gefolgert:
+//   PUSHI A; STOREL i  direkt vor dem Kopf, einziger Eintritt
+//   LOADL i; PUSHI B; LT|LE|GT|GE|NE; JZ  als ganzer Kopf, JZ verlässt die Schleife
+//   LOADL i; PUSHI C; ADD|SUB; STOREL i; JMP Kopf  vor jedem Rücksprung
+// und sonst kein STOREL i in der Schleife, ihren Callees oder Handlern.
+// Ohne Schranke, bei irreduziblem Kontrollfluss, Rekursion und Block-Natives
+// mit unbekannter Länge ist das Ergebnis unbeschränkt (Rückgabe 2).
+// Nicht eingerechnet: Wartezeit in sleep_ms/wait_event und Interrupt-Handler,
+// die an sicheren Punkten einspringen (sie stehen als eigene Funktionen da).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include "../src/vm.h"
+#include "../src/vm_ops.h"
+#include "../src/vm_analyze.h"
+#include "../src/image.h"
+
+// ---- Kostenmodell ----
+typedef struct {
+    double op[OP_COUNT];
+    double nat[NAT_COUNT], nat_elem[NAT_COUNT];   // je Aufruf, je verarbeitetem Element
+    char unit[32];
+} Model;
+
+static void model_default(Model *M){
+    memset(M, 0, sizeof(*M));
+    for (int k=0;k<OP_COUNT;k++) M->op[k] = 1;    // Kosten = Instruktionen
+    strcpy(M->unit, "Instr.");
+}
+
+static int find_name(const char *const *names, int n, const char *s){
+    for (int k=0;k<n;k++) if (!strcmp(names[k], s)) return k;
+    return -1;
+}
+
+// Zeilen: OPNAME kosten | native name kosten [je_element] | unit text | # Kommentar
+static int model_load(Model *M, const char *path){
+    FILE *f = fopen(path, "r");
+    if (!f){ perror(path); return -1; }
+    char line[256]; int ln = 0;
+    while (fgets(line, sizeof line, f)){
+        ln++;
+        char a[32], b[32]; double x = 0, y = 0;
+        char *h = strchr(line, '#'); if (h) *h = 0;
+        int n = sscanf(line, "%31s %31s %lf %lf", a, b, &x, &y);
+        if (n <= 0) continue;
+        if (!strcmp(a, "unit") && n >= 2){ snprintf(M->unit, sizeof M->unit, "%s", b); continue; }
+        if (!strcmp(a, "native") && n >= 3){
+            int k = find_name(vm_native_names, NAT_COUNT, b);
+            if (k >= 0){ M->nat[k] = x; M->nat_elem[k] = n >= 4 ? y : 0; continue; }
+        } else if (n >= 2){
+            int k = find_name(vm_op_names, OP_COUNT, a);
+            if (k >= 0 && sscanf(b, "%lf", &x) == 1){ M->op[k] = x; continue; }
+        }
+        fprintf(stderr,"mote-wcet: %s:%d: unbekannter Eintrag\n", path, ln);
+        fclose(f); return -1;
+    }
+    fclose(f);
+    return 0;
+}
+
+// ---- Natives: HAL-Aufrufe und Elementzahl ----
+enum { HAL_NONE, HAL_ONE, HAL_CHUNK };      // CHUNK: ein adc_read je ADC_CHUNK Werte
+#define ADC_CHUNK 256                         // wie vm_interp.h
+
+static const struct {
+    uint8_t hal;
+    int8_t  n_at;       // Stackposition der Länge n (0 = oben), -1 ohne
+    uint8_t mem;        // n durch den linearen Speicher begrenzt (sonst Trap)
+} nat_info[NAT_COUNT] = {
+    [NAT_GPIO_MODE]={HAL_ONE,-1,0}, [NAT_GPIO_WRITE]={HAL_ONE,-1,0}, [NAT_SLEEP_MS]={HAL_ONE,-1,0},
+    [NAT_GPIO_READ]={HAL_ONE,-1,0}, [NAT_PRINT_INT]={HAL_ONE,-1,0},
+    [NAT_GPIO_MODE_MASK]={HAL_ONE,-1,0}, [NAT_GPIO_WRITE_MASK]={HAL_ONE,-1,0}, [NAT_GPIO_READ_PORT]={HAL_ONE,-1,0},
+    [NAT_GPIO_ON_EDGE]={HAL_ONE,-1,0}, [NAT_WAIT_EVENT]={HAL_ONE,-1,0},
+    [NAT_MEM_FILL]={HAL_NONE,1,1}, [NAT_MEM_COPY]={HAL_NONE,0,1}, [NAT_MEM_SUM]={HAL_NONE,0,1}, [NAT_MEM_MAX]={HAL_NONE,0,1},
+    [NAT_ADC_SAMPLE]={HAL_ONE,-1,0}, [NAT_ADC_READ]={HAL_ONE,0,1},
+    [NAT_ADC_BLOCK_AVG]={HAL_CHUNK,0,0}, [NAT_COUNT_ABOVE]={HAL_CHUNK,1,0},
+    [NAT_FIR_APPLY]={HAL_CHUNK,3,1}, [NAT_YIELD]={HAL_NONE,-1,0},
+};
+
+// ---- Programm ----
+typedef struct { uint32_t pc; uint8_t op; int32_t arg; int blk; } Ins;
+
+enum { END_FALL, END_RET, END_HALT, END_TRAP };
+typedef struct {
+    int first, last;    // Instruktionsindizes
+    int succ[2], ns;    // Blockindizes
+    uint8_t end;        // ohne Nachfolger: wie der Block endet
+    uint8_t yield;      // endet mit CALL yield (succ[0] ist die Yield-Stelle)
+} Blk;
+
+typedef struct { double n, hal, t; } Cost;   // Instruktionen, HAL-Aufrufe, Modellkosten
+#define NONE (-1.0)                            // Pfad nicht möglich
+
+enum { FN_MAIN, FN_FUNC, FN_IRQ };
+typedef struct {
+    uint32_t entry;
+    int kind, state;          // state: 0 neu, 1 in Arbeit, 2 fertig
+    Cost total;               // bis RET/HALT; beim Hauptprogramm der teuerste Abschnitt
+    uint8_t stores[32];       // geschriebene Locals inklusive Callees
+    VmFnNeeds need; int need_ok;
+} Fn;
+
+typedef struct { int fn; uint32_t head; uint32_t bound; int src; } LoopRep;
+enum { SRC_NONE=0, SRC_NOTE=1, SRC_INFER=2 };
+typedef struct { int fn; char msg[112]; } Note;
+typedef struct { uint32_t id, addr; Cost c; } Seg;
+
+typedef struct {
+    const uint8_t *code; size_t len;
+    Ins *v; int n; int *at;   // at[pc] = Instruktionsindex, -1
+    Blk *b; int nb;
+    Fn *f; int nf;
+    MoteLoop *notes; int nnotes;
+    MoteYield *ys; int nys;
+    int64_t mem;              // Worte linearer Speicher, -1 unbekannt (kein META)
+    const Model *M;
+    LoopRep *loops; int nloops;
+    Note *w; int nw;
+    Seg *seg; int nseg;
+    uint8_t irq_stores[32];
+    int *stack; int sp;       // Funktionen in Arbeit (Rekursion)
+} Prog;
+
+static int32_t rd_i32(const uint8_t *p){ int32_t v; memcpy(&v,p,4); return v; }
+
+static void note(Prog *P, int fn, const char *fmt, ...){
+    P->w = (Note*)realloc(P->w, (P->nw+1)*sizeof(Note));
+    Note *e = &P->w[P->nw++];
+    e->fn = fn;
+    va_list ap; va_start(ap, fmt); vsnprintf(e->msg, sizeof e->msg, fmt, ap); va_end(ap);
+}
+
+static int fn_by_entry(const Prog *P, uint32_t entry){
+    for (int k=0;k<P->nf;k++) if (P->f[k].entry == entry) return k;
+    return -1;
+}
+
+static void fn_name(const Prog *P, int k, char *buf, size_t n){
+    const Fn *F = &P->f[k];
+    if (F->kind == FN_MAIN) snprintf(buf, n, "main");
+    else snprintf(buf, n, "%s @%04X", F->kind == FN_IRQ ? "irq" : "fn", F->entry);
+}
+
+static int fn_add(Prog *P, uint32_t entry, int kind){
+    int k = fn_by_entry(P, entry);
+    if (k >= 0){ if (kind == FN_IRQ) P->f[k].kind = FN_IRQ; return k; }
+    P->f = (Fn*)realloc(P->f, (P->nf+1)*sizeof(Fn));
+    Fn *F = &P->f[P->nf];
+    memset(F, 0, sizeof(*F));
+    F->entry = entry; F->kind = kind;
+    return P->nf++;
+}
+
+// Dekodieren, Funktionen finden, Basisblöcke bilden; 0 ok
+static int build(Prog *P){
+    size_t len = P->len;
+    P->v = (Ins*)calloc(len ? len : 1, sizeof(Ins));
+    P->at = (int*)malloc((len+1)*sizeof(int));
+    for (size_t i=0;i<=len;i++) P->at[i] = -1;
+    for (size_t ip=0; ip<len; ){
+        int ol = vm_op_operand_len(P->code[ip]);
+        if (ol < 0 || ip+1+ol > len){ fprintf(stderr,"mote-wcet: ungültige Instruktion bei %04zX\n", ip); return -1; }
+        Ins *I = &P->v[P->n];
+        P->at[ip] = P->n;
+        I->pc = (uint32_t)ip; I->op = P->code[ip];
+        if (ol == 4) I->arg = rd_i32(P->code+ip+1);
+        else if (ol == 1) I->arg = P->code[ip+1];
+        P->n++; ip += 1+ol;
+    }
+    if (!P->n){ fprintf(stderr,"mote-wcet: kein Code\n"); return -1; }
+
+    fn_add(P, 0, FN_MAIN);
+    uint8_t *lead = (uint8_t*)calloc(P->n+1, 1);
+    lead[0] = 1;
+    for (int i=0;i<P->n;i++){
+        Ins *I = &P->v[i];
+        int code_ref = I->op == OP_JMP || I->op == OP_JZ || I->op == OP_CALLUSER
+            || (I->op == OP_PUSHI && i+1 < P->n && P->v[i+1].op == OP_CALL && P->v[i+1].arg == NAT_GPIO_ON_EDGE);
+        if (code_ref && I->arg >= 0 && (size_t)I->arg < len){
+            if (P->at[I->arg] < 0){
+                fprintf(stderr,"mote-wcet: Ziel %d bei %04X liegt nicht auf einer Instruktion\n", I->arg, I->pc);
+                free(lead); return -1;
+            }
+            lead[P->at[I->arg]] = 1;
+            if (I->op == OP_CALLUSER) fn_add(P, (uint32_t)I->arg, FN_FUNC);
+            if (I->op == OP_PUSHI) fn_add(P, (uint32_t)I->arg, FN_IRQ);
+        }
+        if (I->op == OP_JMP || I->op == OP_JZ || I->op == OP_RET || I->op == OP_HALT
+            || (I->op == OP_CALL && I->arg == NAT_YIELD)) lead[i+1] = 1;
+    }
+
+    P->b = (Blk*)calloc(len ? len : 1, sizeof(Blk));
+    for (int i=0;i<P->n;i++){
+        if (lead[i]){ P->b[P->nb].first = i; P->nb++; }
+        P->v[i].blk = P->nb-1;
+        P->b[P->nb-1].last = i;
+    }
+    free(lead);
+
+    for (int k=0;k<P->nb;k++){
+        Blk *B = &P->b[k];
+        const Ins *I = &P->v[B->last];
+        int next = B->last+1 < P->n ? P->v[B->last+1].blk : -1;
+        int tgt = (I->op == OP_JMP || I->op == OP_JZ) && I->arg >= 0 && (size_t)I->arg < len
+                ? P->v[P->at[I->arg]].blk : -1;
+        switch (I->op){
+            case OP_RET:  B->end = END_RET; break;
+            case OP_HALT: B->end = END_HALT; break;
+            case OP_JMP:  if (tgt >= 0) B->succ[B->ns++] = tgt; else B->end = END_TRAP; break;
+            case OP_JZ:
+                if (tgt >= 0) B->succ[B->ns++] = tgt;
+                if (next >= 0 && next != tgt) B->succ[B->ns++] = next;
+                if (!B->ns) B->end = END_TRAP;
+                break;
+            default:
+                if (next >= 0) B->succ[B->ns++] = next; else B->end = END_TRAP;   // Codeende: Trap
+                B->yield = I->op == OP_CALL && I->arg == NAT_YIELD;
+                break;
+        }
+    }
+    return 0;
+}
+
+// ---- Konstante Argumente ----
+// Wert an Stackposition d (0 = oben) vor Instruktion i, wenn ihn innerhalb
+// des Blocks ein PUSHI gelegt hat
+static int const_arg(const Prog *P, int i, int d, int32_t *val){
+    int first = P->b[P->v[i].blk].first;
+    for (int k=i-1; k>=first; k--){
+        const Ins *I = &P->v[k];
+        int pop, push;
+        if (I->op == OP_CALLUSER || vm_op_stack_effect(I->op, I->arg, &pop, &push) < 0) return 0;
+        if (d < push){
+            if (I->op == OP_PUSHI){ *val = I->arg; return 1; }
+            if (I->op == OP_DUP) { d = 0; continue; }            // Kopie des Werts darunter
+            return 0;
+        }
+        d += pop - push;
+    }
+    return 0;
+}
+
+// ---- Kosten ----
+static Cost cadd(Cost a, Cost b){
+    if (a.n < 0 || b.n < 0) return (Cost){ NONE, NONE, NONE };
+    return (Cost){ a.n+b.n, a.hal+b.hal, a.t+b.t };
+}
+static Cost cmax(Cost a, Cost b){
+    return (Cost){ a.n > b.n ? a.n : b.n, a.hal > b.hal ? a.hal : b.hal, a.t > b.t ? a.t : b.t };
+}
+// k-mal a; k = 0 liefert 0 auch für unbeschränktes a
+static Cost cmul(double k, Cost a){
+    if (k == 0) return (Cost){ 0, 0, 0 };
+    return (Cost){ k*a.n, k*a.hal, k*a.t };
+}
+static const Cost ZERO = { 0, 0, 0 }, NOPATH = { NONE, NONE, NONE },
+                  UNBOUNDED = { INFINITY, INFINITY, INFINITY };
+
+static void analyze_fn(Prog *P, int f);
+
+// Ein Native: Aufwand nach Länge n (konstant, sonst durch den Speicher begrenzt)
+static Cost native_cost(Prog *P, int fn, int i){
+    const Ins *I = &P->v[i];
+    int k = I->arg;
+    if (k < 0 || k >= NAT_COUNT) return ZERO;                // Trap
+    Cost c = { 0, nat_info[k].hal == HAL_ONE, P->M->nat[k] };
+    if (nat_info[k].n_at < 0) return c;
+    int32_t n;
+    double elems;
+    if (const_arg(P, i, nat_info[k].n_at, &n)) elems = n > 0 ? n : 0;
+    else if (nat_info[k].mem && P->mem >= 0) elems = (double)P->mem;
+    else {
+        note(P, fn, "%s bei %04X: Länge nicht konstant%s", vm_native_names[k], I->pc,
+             nat_info[k].mem ? " und Speichergröße unbekannt" : "");
+        return UNBOUNDED;
+    }
+    if (k == NAT_ADC_READ) c.hal = elems > 0;
+    if (nat_info[k].hal == HAL_CHUNK) c.hal = ceil(elems / ADC_CHUNK);
+    if (k == NAT_FIR_APPLY){                               // Arbeit je Ausgabewert wächst mit taps
+        int32_t taps;
+        elems *= const_arg(P, i, 1, &taps) && taps > 0 && taps <= VM_FIR_TAPS ? taps : VM_FIR_TAPS;
+    }
+    c.t += P->M->nat_elem[k] * elems;
+    return c;
+}
+
+static Cost block_cost(Prog *P, int fn, int b){
+    Cost c = ZERO;
+    for (int i=P->b[b].first; i<=P->b[b].last; i++){
+        const Ins *I = &P->v[i];
+        c.n += 1; c.t += P->M->op[I->op];
+        if (I->op == OP_CALL) c = cadd(c, native_cost(P, fn, i));
+        if (I->op == OP_CALLUSER){
+            int g = fn_by_entry(P, (uint32_t)I->arg);
+            if (g < 0) continue;                             // Ziel außerhalb des Codes: Trap
+            if (P->f[g].state == 0) analyze_fn(P, g);
+            if (P->f[g].state == 1){                        // g ruft sich über diesen Pfad selbst
+                int s = P->sp;
+                while (s > 0 && P->stack[s-1] != g) s--;
+                note(P, g, "rekursiv (Zyklus über %d Funktion%s)", P->sp - s + 1, P->sp - s ? "en" : "");
+                c = UNBOUNDED;
+            } else c = cadd(c, P->f[g].total);
+        }
+    }
+    return c;
+}
+
+// ---- Graph einer Funktion ----
+typedef struct {
+    int m;                    // Knoten 0..m-1, Wurzel m (verbindet alle Einstiege)
+    int *blk, *loc;           // lokal -> Block, Block -> lokal (-1)
+    int *soff, *succ;         // Nachfolger (CSR)
+    int *poff, *pred;
+    Cost *c;                  // Knotenkosten; Schleifenkopf nach dem Zusammenfassen: ganze Schleife
+    int *rep;                 // Knoten -> Kopf der äußersten schon zusammengefassten Schleife
+    uint8_t *term;            // Pfad endet hier (RET, HALT, yield, Trap)
+} G;
+
+static void csr(int m, int ne, const int *from, const int *to, int **off, int **adj){
+    *off = (int*)calloc(m+2, sizeof(int));
+    *adj = (int*)malloc((ne ? ne : 1)*sizeof(int));
+    for (int e=0;e<ne;e++) (*off)[from[e]+1]++;
+    for (int k=0;k<=m;k++) (*off)[k+1] += (*off)[k];
+    int *fill = (int*)malloc((m+1)*sizeof(int));
+    memcpy(fill, *off, (m+1)*sizeof(int));
+    for (int e=0;e<ne;e++) (*adj)[fill[from[e]]++] = to[e];
+    free(fill);
+}
+
+// Dominatoren (Cooper/Harvey/Kennedy) über die Wurzel m
+static int *dominators(const G *g){
+    int m = g->m, R = m;
+    int *rpo = (int*)malloc((m+1)*sizeof(int)), *num = (int*)malloc((m+1)*sizeof(int));
+    int *st = (int*)malloc((m+1)*sizeof(int)), *it = (int*)calloc(m+1, sizeof(int));
+    uint8_t *seen = (uint8_t*)calloc(m+1, 1);
+    int sp = 0, nr = m+1;
+    st[sp++] = R; seen[R] = 1;
+    while (sp){                                       // iterative Tiefensuche, Postorder rückwärts
+        int u = st[sp-1];
+        if (g->soff[u] + it[u] < g->soff[u+1]){
+            int v = g->succ[g->soff[u] + it[u]++];
+            if (!seen[v]){ seen[v] = 1; st[sp++] = v; }
+        } else { rpo[--nr] = u; sp--; }
+    }
+    for (int k=nr;k<=m;k++) num[rpo[k]] = k;
+    int *idom = (int*)malloc((m+1)*sizeof(int));
+    for (int k=0;k<=m;k++) idom[k] = -1;
+    idom[R] = R;
+    for (int changed=1; changed; ){
+        changed = 0;
+        for (int k=nr+1;k<=m;k++){
+            int b = rpo[k], nd = -1;
+            for (int e=g->poff[b]; e<g->poff[b+1]; e++){
+                int p = g->pred[e];
+                if (idom[p] < 0) continue;
+                if (nd < 0){ nd = p; continue; }
+                int x = p, y = nd;
+                while (x != y){
+                    while (num[x] > num[y]) x = idom[x];
+                    while (num[y] > num[x]) y = idom[y];
+                }
+                nd = x;
+            }
+            if (nd >= 0 && idom[b] != nd){ idom[b] = nd; changed = 1; }
+        }
+    }
+    free(rpo); free(num); free(st); free(it); free(seen);
+    return idom;
+}
+
+static int dominates(const int *idom, int root, int h, int u){
+    for (;;){
+        if (u == h) return 1;
+        if (u == root) return 0;
+        u = idom[u];
+    }
+}
+
+// Längster Weg ab u über zusammengefasste Knoten in der Menge in (NULL = alle),
+// ohne Kanten zum Kopf h. want: 0 irgendein Ende, 1 bis zu einem Rücksprung auf
+// h, 2 bis zu einem Ausgang aus der Menge. memo/state je Aufruf von längster().
+typedef struct { const G *g; const uint8_t *in; int h, want; Cost *memo; uint8_t *state; } Walk;
+
+static Cost walk(Walk *W, int u){
+    if (W->state[u] == 2) return W->memo[u];
+    if (W->state[u] == 1) return UNBOUNDED;             // Zyklus: nur bei irreduziblem Fluss
+    W->state[u] = 1;
+    const G *g = W->g;
+    Cost best = NOPATH;
+    int end = 0;                                        // von u aus endet hier ein gesuchter Pfad
+    for (int x=0;x<g->m;x++){
+        if (g->rep[x] != u || (W->in && !W->in[x])) continue;
+        if (g->term[x] && W->want != 1) end = 1;
+        for (int e=g->soff[x]; e<g->soff[x+1]; e++){
+            int s = g->succ[e];
+            if (s == W->h){ if (W->want == 1) end = 1; continue; }
+            if (W->in && !W->in[s]){ if (W->want == 2) end = 1; continue; }
+            int r = g->rep[s];
+            if (r == u) continue;
+            best = cmax(best, walk(W, r));
+        }
+    }
+    if (W->want == 0) end = 1;
+    if (end) best = cmax(best, ZERO);
+    W->memo[u] = best.n < 0 ? NOPATH : cadd(g->c[u], best);
+    W->state[u] = 2;
+    return W->memo[u];
+}
+
+static Cost longest(const G *g, const uint8_t *in, int h, int want, int from){
+    Walk W = { g, in, h, want, (Cost*)malloc(g->m*sizeof(Cost)), (uint8_t*)calloc(g->m, 1) };
+    Cost c = walk(&W, from);
+    free(W.memo); free(W.state);
+    return c;
+}
+
+// Zählschleife erkennen (siehe Kopfkommentar); Anzahl Durchläufe oder -1
+static int64_t infer_bound(Prog *P, const G *g, const uint8_t *in, int h, const uint8_t *entry){
+    const Blk *H = &P->b[g->blk[h]];
+    if (H->last - H->first != 3 || entry[h]) return -1;
+    const Ins *hd = &P->v[H->first];
+    if (hd[0].op != OP_LOADL || hd[1].op != OP_PUSHI || hd[3].op != OP_JZ) return -1;
+    uint8_t cmp = hd[2].op, s = (uint8_t)hd[0].arg;
+    if (cmp != OP_LT && cmp != OP_LE && cmp != OP_GT && cmp != OP_GE && cmp != OP_NE) return -1;
+    int jz = P->at[hd[3].arg >= 0 && (size_t)hd[3].arg < P->len ? hd[3].arg : 0];
+    if ((size_t)hd[3].arg < P->len && in[g->loc[P->v[jz].blk]]) return -1;   // JZ muss hinaus
+    int64_t B = hd[1].arg;
+
+    // Einziger Eintritt von außen: PUSHI A; STOREL i am Ende des vorigen Blocks
+    int64_t A = 0; int outside = 0;
+    for (int e=g->poff[h]; e<g->poff[h+1]; e++){
+        int p = g->pred[e];
+        if (p == g->m || in[p]) continue;
+        outside++;
+        const Blk *Q = &P->b[g->blk[p]];
+        if (Q->last+1 != H->first || Q->last - Q->first < 1 || P->v[Q->last].op == OP_JMP) return -1;
+        const Ins *q = &P->v[Q->last-1];
+        if (q[0].op != OP_PUSHI || q[1].op != OP_STOREL || q[1].arg != s) return -1;
+        A = q[0].arg;
+    }
+    if (outside != 1) return -1;
+
+    // Jeder Rücksprung: LOADL i; PUSHI C; ADD|SUB; STOREL i; JMP h im selben Block
+    int step_op = -1; int64_t C = 0; int nstore = 0;
+    for (int x=0;x<g->m;x++){
+        if (!in[x]) continue;
+        const Blk *X = &P->b[g->blk[x]];
+        int latch = 0;
+        for (int e=g->soff[x]; e<g->soff[x+1]; e++) if (g->succ[e] == h) latch = 1;
+        if (latch){
+            if (X->last - X->first < 4) return -1;
+            const Ins *t = &P->v[X->last-4];
+            if (t[0].op != OP_LOADL || t[0].arg != s || t[1].op != OP_PUSHI || (t[2].op != OP_ADD && t[2].op != OP_SUB)
+                || t[3].op != OP_STOREL || t[3].arg != s || t[4].op != OP_JMP) return -1;
+            if (step_op >= 0 && (step_op != t[2].op || C != t[1].arg)) return -1;
+            step_op = t[2].op; C = t[1].arg;
+        }
+        for (int i=X->first; i<=X->last; i++){
+            const Ins *I = &P->v[i];
+            if (I->op == OP_STOREL && I->arg == s) nstore++;
+            if (I->op == OP_CALLUSER){
+                int f = fn_by_entry(P, (uint32_t)I->arg);
+                if (f >= 0 && (P->f[f].stores[s>>3] & (1u << (s&7)))) return -1;
+            }
+        }
+    }
+    int nlatch = 0;
+    for (int e=g->poff[h]; e<g->poff[h+1]; e++) if (g->pred[e] != g->m && in[g->pred[e]]) nlatch++;
+    if (nstore != nlatch || (P->irq_stores[s>>3] & (1u << (s&7)))) return -1;
+    if (C <= 0) return -1;
+
+    // Durchläufe ohne Überlauf von i
+    if (step_op == OP_ADD){
+        if (cmp == OP_LT) return A >= B ? 0 : B-1+C <= INT32_MAX ? (B-A + C-1)/C : -1;
+        if (cmp == OP_LE) return A > B ? 0 : B+C <= INT32_MAX ? (B-A)/C + 1 : -1;
+        if (cmp == OP_NE) return A <= B && (B-A) % C == 0 ? (B-A)/C : -1;
+    } else {
+        if (cmp == OP_GT) return A <= B ? 0 : B+1-C >= INT32_MIN ? (A-B + C-1)/C : -1;
+        if (cmp == OP_GE) return A < B ? 0 : B-C >= INT32_MIN ? (A-B)/C + 1 : -1;
+        if (cmp == OP_NE) return A >= B && (A-B) % C == 0 ? (A-B)/C : -1;
+    }
+    return -1;
+}
+
+static const MoteLoop *loop_note(const Prog *P, uint32_t head){
+    for (int k=0;k<P->nnotes;k++) if (P->notes[k].addr == head) return &P->notes[k];
+    return NULL;
+}
+
+static void analyze_fn(Prog *P, int f){
+    Fn *F = &P->f[f];
+    F->state = 1;
+    P->stack[P->sp++] = f;
+    int main = F->kind == FN_MAIN;
+    char fname[32]; fn_name(P, f, fname, sizeof fname);
+
+    // Erreichbare Blöcke; im Hauptprogramm endet ein Abschnitt an yield,
+    // die Stelle dahinter wird eigener Einstieg
+    G g; memset(&g, 0, sizeof g);
+    g.loc = (int*)malloc(P->nb*sizeof(int));
+    g.blk = (int*)malloc(P->nb*sizeof(int));
+    for (int k=0;k<P->nb;k++) g.loc[k] = -1;
+    int *work = (int*)malloc(P->nb*sizeof(int)), wn = 0;
+    int eb = P->v[P->at[F->entry]].blk;
+    g.loc[eb] = g.m; g.blk[g.m++] = eb; work[wn++] = eb;
+    while (wn){
+        const Blk *B = &P->b[work[--wn]];
+        for (int e=0;e<B->ns;e++){
+            int s = B->succ[e];
+            if (g.loc[s] < 0){ g.loc[s] = g.m; g.blk[g.m++] = s; work[wn++] = s; }
+        }
+    }
+    free(work);
+
+    int m = g.m, ne = 0;
+    size_t maxe = 3*(size_t)m + 1;                      // je Block 2 Nachfolger, dazu Wurzelkanten
+    int *ef = (int*)calloc(maxe, sizeof(int)), *et = (int*)calloc(maxe, sizeof(int));
+    uint8_t *entry = (uint8_t*)calloc(m, 1);
+    g.term = (uint8_t*)calloc(m, 1);
+    entry[0] = 1;
+    for (int x=0;x<m;x++){
+        const Blk *B = &P->b[g.blk[x]];
+        if (main && B->yield){
+            g.term[x] = 1;
+            entry[g.loc[B->succ[0]]] = 1;
+            continue;
+        }
+        if (!B->ns) g.term[x] = 1;
+        for (int e=0;e<B->ns;e++){ ef[ne] = x; et[ne] = g.loc[B->succ[e]]; ne++; }
+    }
+    for (int x=0;x<m;x++) if (entry[x]){ ef[ne] = m; et[ne] = x; ne++; }
+    csr(m, ne, ef, et, &g.soff, &g.succ);
+    csr(m, ne, et, ef, &g.poff, &g.pred);
+    free(ef); free(et);
+
+    g.c = (Cost*)malloc(m*sizeof(Cost));
+    g.rep = (int*)malloc(m*sizeof(int));
+    for (int x=0;x<m;x++){ g.c[x] = block_cost(P, f, g.blk[x]); g.rep[x] = x; }
+
+    // Rücksprünge: Kante u -> h mit h dominiert u. Ohne sie muss der Graph azyklisch sein.
+    int *idom = dominators(&g);
+    uint8_t *head = (uint8_t*)calloc(m, 1);
+    int irreducible = 0;
+    {
+        uint8_t *col = (uint8_t*)calloc(m+1, 1);
+        int *st = (int*)malloc((m+1)*sizeof(int)), *it = (int*)calloc(m+1, sizeof(int)), sp = 0;
+        st[sp++] = m; col[m] = 1;
+        while (sp && !irreducible){
+            int u = st[sp-1];
+            if (g.soff[u] + it[u] < g.soff[u+1]){
+                int v = g.succ[g.soff[u] + it[u]++];
+                if (u < m && dominates(idom, m, v, u)){ head[v] = 1; continue; }
+                if (col[v] == 1) irreducible = 1;
+                else if (!col[v]){ col[v] = 1; st[sp++] = v; }
+            } else { col[u] = 2; sp--; }
+        }
+        free(col); free(st); free(it);
+    }
+    if (irreducible) note(P, f, "irreduzibler Kontrollfluss");
+
+    // Natürliche Schleifen, innere zuerst (kleinerer Rumpf)
+    int nh = 0;
+    int *hs = (int*)malloc((m ? m : 1)*sizeof(int));
+    uint8_t **body = (uint8_t**)malloc((m ? m : 1)*sizeof(uint8_t*));
+    int *size = (int*)calloc(m ? m : 1, sizeof(int));
+    for (int h=0; h<m && !irreducible; h++){
+        if (!head[h]) continue;
+        uint8_t *in = (uint8_t*)calloc(m, 1);
+        int *wl = (int*)malloc(m*sizeof(int)), n = 0, cnt = 1;
+        in[h] = 1;
+        for (int e=g.poff[h]; e<g.poff[h+1]; e++){
+            int u = g.pred[e];
+            if (u < m && dominates(idom, m, h, u) && !in[u]){ in[u] = 1; wl[n++] = u; cnt++; }
+        }
+        while (n){
+            int u = wl[--n];
+            for (int e=g.poff[u]; e<g.poff[u+1]; e++){
+                int p = g.pred[e];
+                if (p < m && !in[p]){ in[p] = 1; wl[n++] = p; cnt++; }
+            }
+        }
+        free(wl);
+        hs[nh] = h; body[nh] = in; size[nh] = cnt; nh++;
+    }
+    for (int a=1;a<nh;a++)                              // nach Größe sortieren
+        for (int b=a; b>0 && size[b-1] > size[b]; b--){
+            int t = hs[b]; hs[b] = hs[b-1]; hs[b-1] = t;
+            t = size[b]; size[b] = size[b-1]; size[b-1] = t;
+            uint8_t *q = body[b]; body[b] = body[b-1]; body[b-1] = q;
+        }
+
+    for (int k=0;k<nh;k++){
+        int h = hs[k];
+        uint8_t *in = body[k];
+        uint32_t hpc = P->v[P->b[g.blk[h]].first].pc;
+        const MoteLoop *an = loop_note(P, hpc);
+        int64_t inf = infer_bound(P, &g, in, h, entry);
+        LoopRep L = { f, hpc, 0, SRC_NONE };
+        if (inf >= 0){ L.bound = (uint32_t)inf; L.src |= SRC_INFER; }
+        if (an && (!(L.src & SRC_INFER) || an->bound < L.bound)) L.bound = an->bound;
+        if (an) L.src |= SRC_NOTE;
+        P->loops = (LoopRep*)realloc(P->loops, (P->nloops+1)*sizeof(LoopRep));
+        P->loops[P->nloops++] = L;
+
+        Cost iter = longest(&g, in, h, 1, h), out = longest(&g, in, h, 2, h);
+        Cost tot;
+        if (L.src == SRC_NONE){ note(P, f, "Schleife @%04X ohne Schranke", hpc); tot = UNBOUNDED; }
+        else if (out.n < 0){ note(P, f, "Schleife @%04X ohne Ausgang", hpc); tot = UNBOUNDED; }
+        else tot = cadd(cmul(L.bound, iter), out);
+        for (int x=0;x<m;x++) if (in[x]) g.rep[x] = h;
+        g.c[h] = tot;
+    }
+
+    // Je Einstieg der teuerste Weg; beim Hauptprogramm je Abschnitt
+    F->total = ZERO;
+    for (int x=0;x<m;x++){
+        if (!entry[x]) continue;
+        Cost c = irreducible ? UNBOUNDED : longest(&g, NULL, -1, 0, g.rep[x]);
+        F->total = cmax(F->total, c);
+        if (!main) continue;
+        P->seg = (Seg*)realloc(P->seg, (P->nseg+1)*sizeof(Seg));
+        Seg *S = &P->seg[P->nseg++];
+        S->addr = P->v[P->b[g.blk[x]].first].pc; S->id = UINT32_MAX; S->c = c;
+        for (int y=0;y<P->nys;y++) if (P->ys[y].addr == S->addr) S->id = P->ys[y].id;
+    }
+
+    for (int k=0;k<nh;k++) free(body[k]);
+    free(hs); free(body); free(size); free(head); free(idom);
+    free(g.loc); free(g.blk); free(g.soff); free(g.succ); free(g.poff); free(g.pred);
+    free(g.c); free(g.rep); free(g.term); free(entry);
+    F->state = 2;
+    P->sp--;
+}
+
+// Geschriebene Locals je Funktion inklusive aller Callees (Fixpunkt)
+static void collect_stores(Prog *P){
+    uint8_t *seen = (uint8_t*)malloc(P->nb);
+    int *work = (int*)malloc(P->nb*sizeof(int));
+    int **callees = (int**)calloc(P->nf, sizeof(int*)), *ncallees = (int*)calloc(P->nf, sizeof(int));
+    for (int f=0;f<P->nf;f++){
+        memset(seen, 0, P->nb);
+        int wn = 0, eb = P->v[P->at[P->f[f].entry]].blk;
+        seen[eb] = 1; work[wn++] = eb;
+        while (wn){
+            const Blk *B = &P->b[work[--wn]];
+            for (int i=B->first;i<=B->last;i++){
+                const Ins *I = &P->v[i];
+                if (I->op == OP_STOREL) P->f[f].stores[I->arg>>3] |= 1u << (I->arg&7);
+                if (I->op == OP_CALLUSER && fn_by_entry(P, (uint32_t)I->arg) >= 0){
+                    callees[f] = (int*)realloc(callees[f], (ncallees[f]+1)*sizeof(int));
+                    callees[f][ncallees[f]++] = fn_by_entry(P, (uint32_t)I->arg);
+                }
+            }
+            for (int e=0;e<B->ns;e++) if (!seen[B->succ[e]]){ seen[B->succ[e]] = 1; work[wn++] = B->succ[e]; }
+        }
+    }
+    for (int changed=1; changed; ){
+        changed = 0;
+        for (int f=0;f<P->nf;f++)
+            for (int k=0;k<ncallees[f];k++)
+                for (int w=0;w<32;w++){
+                    uint8_t x = P->f[f].stores[w] | P->f[callees[f][k]].stores[w];
+                    if (x != P->f[f].stores[w]){ P->f[f].stores[w] = x; changed = 1; }
+                }
+    }
+    for (int f=0;f<P->nf;f++){
+        if (P->f[f].kind == FN_IRQ) for (int w=0;w<32;w++) P->irq_stores[w] |= P->f[f].stores[w];
+        free(callees[f]);
+    }
+    free(callees); free(ncallees); free(seen); free(work);
+}
+
+// ---- Ausgabe ----
+static void put_num(double v, int prec){
+    if (isinf(v)) printf(" %12s", "unbegrenzt");
+    else printf(" %12.*f", prec, v);
+}
+
+static void put_row(const char *name, Cost c, const Fn *F){
+    printf("  %-20s", name);
+    put_num(c.n, 0); put_num(c.hal, 0); put_num(c.t, 1);
+    if (!F) printf("\n");
+    else if (F->need_ok) printf(" %6u %6u\n", F->need.stack_max, F->need.call_max);
+    else printf(" %6s %6s\n", "?", "?");
+}
+
+static uint8_t *read_file(const char *path, size_t *n){
+    FILE*f=fopen(path,"rb"); if(!f){perror("open"); exit(1);}
+    fseek(f,0,SEEK_END); long len=ftell(f); fseek(f,0,SEEK_SET);
+    uint8_t*buf=(uint8_t*)malloc(len ? len : 1);
+    if (fread(buf,1,len,f) != (size_t)len){ perror("read"); exit(1); }
+    fclose(f); *n=(size_t)len;
+    return buf;
+}
+
+int main(int argc, char **argv){
+    const char *in = NULL, *costs = NULL;
+    for (int i=1;i<argc;i++){
+        if (!strcmp(argv[i],"--costs") && i+1<argc) costs = argv[++i];
+        else if (!in) in = argv[i];
+        else in = NULL, i = argc;
+    }
+    if (!in){
+        fprintf(stderr,"Usage: %s [--costs modell.txt] program.bin\n", argv[0]);
+        return 1;
+    }
+    Model M; model_default(&M);
+    if (costs && model_load(&M, costs) != 0) return 1;
+
+    size_t flen; uint8_t *file = read_file(in, &flen);
+    MoteImage img;
+    if (mote_image_parse(&img, file, flen) != 0){
+        fprintf(stderr,"mote-wcet: defekter Image-Header: %s\n", in);
+        free(file); return 1;
+    }
+    Prog P; memset(&P, 0, sizeof P);
+    P.code = img.code; P.len = img.code_len; P.M = &M;
+    P.mem = mote_image_find(&img, "META") ? (int64_t)img.meta.mem : -1;
+    P.nnotes = mote_loops_decode(mote_image_find(&img, "LOOP"), &P.notes);
+    P.nys = mote_yields_decode(mote_image_find(&img, "YELD"), &P.ys);
+    if (P.nnotes < 0 || P.nys < 0){
+        fprintf(stderr,"mote-wcet: defekte LOOP- oder YELD-Sektion\n");
+        free(file); return 1;
+    }
+    int rc = 1;
+    if (build(&P) == 0){
+        collect_stores(&P);
+        P.stack = (int*)malloc(P.nf*sizeof(int));
+        for (int f=0;f<P.nf;f++){
+            if (P.f[f].state == 0) analyze_fn(&P, f);
+            P.f[f].need_ok = vm_analyze_fn(P.code, P.len, P.f[f].entry, &P.f[f].need) == 0;
+        }
+
+        VmNeeds need;
+        int need_ok = vm_analyze(P.code, P.len, &need) == 0;
+        printf("mote-wcet: %s, %zu Bytes Code, %d Funktionen, Kosten in %s%s\n",
+               in, P.len, P.nf, M.unit, costs ? "" : " (ohne --costs)");
+        if (need_ok) printf("Programm mit Handlern: Stack %u, Call-Tiefe %u\n", need.stack_max, need.call_max);
+        else printf("Programm mit Handlern: Stack und Call-Tiefe nicht bestimmbar (?)\n");
+        printf("  %-20s %12s %12s %12s %6s %6s\n", "", "Instrukt.", "HAL-Aufrufe", "Kosten", "Stack", "Calls");
+        int unbounded = 0;
+        for (int f=0;f<P.nf;f++){
+            char name[48]; fn_name(&P, f, name, sizeof name);
+            if (P.f[f].kind == FN_MAIN && P.nseg > 1){
+                // Abschnitte: Start bzw. Yield-Stelle bis zum nächsten Ende
+                for (int s=0;s<P.nseg;s++){
+                    char sn[48];
+                    if (!s) snprintf(sn, sizeof sn, "main ab Start");
+                    else if (P.seg[s].id != UINT32_MAX) snprintf(sn, sizeof sn, "main ab yield(%u)", P.seg[s].id);
+                    else snprintf(sn, sizeof sn, "main ab @%04X", P.seg[s].addr);
+                    put_row(sn, P.seg[s].c, s ? NULL : &P.f[f]);
+                }
+            } else put_row(name, P.f[f].total, &P.f[f]);
+            if (isinf(P.f[f].total.n) || isinf(P.f[f].total.t)) unbounded = 1;
+        }
+        if (P.nloops){
+            printf("Schleifen:\n");
+            for (int k=0;k<P.nloops;k++){
+                const LoopRep *L = &P.loops[k];
+                char name[48]; fn_name(&P, L->fn, name, sizeof name);
+                static const char *src[4] = { "ohne Schranke", "bound", "gefolgert", "gefolgert, bound" };
+                if (L->src) printf("  @%04X in %-14s %10u Durchläufe (%s)\n", L->head, name, L->bound, src[L->src]);
+                else printf("  @%04X in %-14s %10s\n", L->head, name, src[0]);
+            }
+        }
+        if (P.nw){
+            printf("Unbeschränkt:\n");
+            for (int k=0;k<P.nw;k++){
+                char name[48]; fn_name(&P, P.w[k].fn, name, sizeof name);
+                printf("  %s: %s\n", name, P.w[k].msg);
+            }
+        }
+        rc = unbounded || P.nw ? 2 : 0;
+    }
+    free(P.v); free(P.at); free(P.b); free(P.f); free(P.notes); free(P.ys);
+    free(P.loops); free(P.w); free(P.seg); free(P.stack); free(file);
+    return rc;
+}